@@ -18,6 +18,22 @@
 
 #include "adc/adc.h"
 
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <utils.h>
+
+#include "dsp/dsp_js.h"
+#include "recorder/recorder.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace artik {
 
 using v8::Exception;
@@ -34,15 +50,317 @@ using v8::Value;
 using v8::Context;
 
 Persistent<Function> AdcWrapper::constructor;
+Persistent<FunctionTemplate> AdcWrapper::tmpl;
+
+/*
+ * Continuous sampling: a dedicated thread wakes up on absolute
+ * CLOCK_MONOTONIC deadlines and reads every channel once per tick, filling
+ * blocks of interleaved samples. Full blocks are copied to JS through an
+ * uv_async handle along with the timestamp of their first frame. When JS
+ * falls behind and no free block is left, the new block is dropped and
+ * counted as an overrun; the sampling clock itself never waits for JS.
+ * With a DSP pipeline, full blocks are reduced in order by a worker thread,
+ * so that a slow pipeline does not delay the sampling clock, and only
+ * their features are handed to JS. A recorder gets every frame,
+ * including the ones of dropped blocks, from the sampling thread.
+ */
+struct AdcStream {
+  AdcWrapper* wrap;
+  uv_async_t async;
+  std::thread thread;
+  std::mutex lock;
+  std::atomic<bool> quit;
+  artik_error error;
+  /* Channels other than the streaming ADC are kept referenced */
+  std::vector<AdcWrapper*> channels;
+  /* Cached attribute of each channel, NULL when going through the SDK */
+  std::vector<std::shared_ptr<SysfsFile>> fast;
+  Nan::Persistent<v8::Array> handles;
+  uint64_t period;
+  size_t frames;
+  std::vector<std::vector<int32_t>> blocks;
+  std::vector<double> timestamps;
+  std::deque<size_t> free_blocks;
+  std::deque<size_t> filled_blocks;
+  DspPipeline* dsp;
+  std::thread dsp_thread;
+  std::condition_variable dsp_cond;
+  std::deque<size_t> dsp_blocks;
+  std::vector<std::vector<DspPipeline::Features>> features;
+  std::shared_ptr<RingFile> recorder;
+  /* Wall clock minus monotonic clock in ms, for the recorded timestamps */
+  double realtime_offset;
+  Nan::Callback* callback;
+  uint64_t samples;
+  uint64_t overruns;
+  uint64_t missed;
+  uint64_t dropped;
+
+  void run();
+  void run_dsp();
+};
+
+static void add_ns(struct timespec* ts, uint64_t ns) {
+  ns += ts->tv_nsec;
+  ts->tv_sec += ns / 1000000000;
+  ts->tv_nsec = ns % 1000000000;
+}
+
+static double to_ns(const struct timespec& ts) {
+  return static_cast<double>(ts.tv_sec) * 1e9 + ts.tv_nsec;
+}
+
+/* Sleep in bounded steps so that stopping a slow stream does not hang */
+static void sleep_until(const struct timespec& deadline,
+    const std::atomic<bool>& quit) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  while (!quit && to_ns(now) < to_ns(deadline)) {
+    struct timespec step = now;
+
+    add_ns(&step, 100000000);
+    if (to_ns(step) > to_ns(deadline))
+      step = deadline;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &step, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+  }
+}
+
+void AdcStream::run() {
+  struct timespec deadline;
+  int block = -1;
+  size_t frame = 0;
+  double block_start = 0;
+  std::vector<int32_t> scratch(frames * channels.size());
+  std::vector<double> recorded_times;
+  std::vector<double> recorded_values;
+
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+  for (;;) {
+    sleep_until(deadline, quit);
+    if (quit)
+      return;
+
+    std::unique_lock<std::mutex> l(lock);
+
+    if (frame == 0) {
+      block_start = to_ns(deadline);
+      if (!free_blocks.empty()) {
+        block = free_blocks.front();
+        free_blocks.pop_front();
+        timestamps[block] = to_ns(deadline);
+      } else {
+        /* Keep sampling in time, the block is dropped once full */
+        block = -1;
+      }
+    }
+    l.unlock();
+
+    int32_t* out = (block >= 0) ? blocks[block].data() : scratch.data();
+    out += frame * channels.size();
+
+    for (size_t c = 0; c < channels.size(); c++) {
+      int val = -1;
+      artik_error ret;
+
+      if (fast[c]) {
+        ret = fast[c]->read_int(&val);
+      } else {
+        std::lock_guard<std::mutex> io(channels[c]->getLock());
+        ret = channels[c]->getObj()->get_value(&val);
+      }
+
+      if (ret != S_OK) {
+        l.lock();
+        error = ret;
+        if (block >= 0)
+          free_blocks.push_front(block);
+        l.unlock();
+        uv_async_send(&async);
+        return;
+      }
+      out[c] = val;
+    }
+
+    if (recorder && frame + 1 == frames) {
+      const int32_t* data = (block >= 0) ? blocks[block].data() :
+          scratch.data();
+
+      recorded_times.resize(frames);
+      recorded_values.assign(data, data + frames * channels.size());
+      for (size_t i = 0; i < frames; i++)
+        recorded_times[i] = (block_start + i * period) / 1e6 +
+            realtime_offset;
+      recorder->append(recorded_times.data(), recorded_values.data(),
+          frames);
+    }
+
+    l.lock();
+    samples++;
+    if (++frame == frames) {
+      frame = 0;
+      if (block >= 0 && dsp) {
+        dsp_blocks.push_back(block);
+        dsp_cond.notify_one();
+      } else if (block >= 0) {
+        filled_blocks.push_back(block);
+        l.unlock();
+        uv_async_send(&async);
+        l.lock();
+      } else {
+        overruns++;
+        dropped++;
+      }
+    }
+
+    /* Skip the ticks that could not be honored instead of bursting */
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    add_ns(&deadline, period);
+    while (to_ns(deadline) < to_ns(now)) {
+      missed++;
+      add_ns(&deadline, period);
+    }
+  }
+}
+
+void AdcStream::run_dsp() {
+  std::unique_lock<std::mutex> l(lock);
+
+  while (!quit) {
+    if (dsp_blocks.empty()) {
+      dsp_cond.wait(l);
+      continue;
+    }
+
+    size_t block = dsp_blocks.front();
+    dsp_blocks.pop_front();
+    l.unlock();
+
+    dsp->process(blocks[block].data(), frames, &features[block]);
+
+    l.lock();
+    filled_blocks.push_back(block);
+    l.unlock();
+    uv_async_send(&async);
+    l.lock();
+  }
+}
+
+static void adc_stream_async_cb(uv_async_t* handle) {
+  AdcStream* stream = reinterpret_cast<AdcStream*>(handle->data);
+  Nan::HandleScope scope;
+  std::deque<size_t> filled;
+  artik_error error;
+  uint64_t dropped;
+
+  {
+    std::lock_guard<std::mutex> l(stream->lock);
+    error = stream->error;
+    filled.swap(stream->filled_blocks);
+    dropped = stream->dropped;
+    stream->dropped = 0;
+  }
+
+  Isolate* isolate = Isolate::GetCurrent();
+
+  for (size_t i = 0; i < filled.size(); i++) {
+    Local<Value> data;
+
+    if (stream->dsp) {
+      std::vector<DspPipeline::Features>& features =
+          stream->features[filled[i]];
+      Local<v8::Array> channels = v8::Array::New(isolate, features.size());
+
+      for (size_t c = 0; c < features.size(); c++)
+        channels->Set(c, dsp_features_to_js(isolate, features[c]));
+      data = channels;
+    } else {
+      std::vector<int32_t>& block = stream->blocks[filled[i]];
+      size_t size = block.size() * sizeof(int32_t);
+      Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, size);
+
+      memcpy(buffer->GetContents().Data(), block.data(), size);
+      data = v8::Int32Array::New(buffer, 0, block.size());
+    }
+
+    Local<Value> argv[4] = {
+      Nan::Null(),
+      data,
+      Nan::New<Number>(stream->timestamps[filled[i]]),
+      Nan::New<Number>(static_cast<double>(dropped))
+    };
+    dropped = 0;
+
+    {
+      std::lock_guard<std::mutex> l(stream->lock);
+      stream->free_blocks.push_back(filled[i]);
+    }
+
+    stream->callback->Call(4, argv);
+
+    /* The callback may have stopped the stream */
+    if (stream->wrap == NULL)
+      return;
+  }
+
+  if (error != S_OK) {
+    AdcWrapper* wrap = stream->wrap;
+    Nan::Callback* callback = stream->callback;
+
+    /* Keep the callback alive past the stream teardown */
+    stream->callback = NULL;
+    wrap->stop_stream();
+
+    Local<Value> argv[1] = { Nan::Error(error_msg(error)) };
+    callback->Call(1, argv);
+    delete callback;
+  }
+}
+
+static void adc_stream_close_cb(uv_handle_t* handle) {
+  AdcStream* stream = reinterpret_cast<AdcStream*>(handle->data);
+
+  stream->handles.Reset();
+  delete stream->callback;
+  delete stream->dsp;
+  delete stream;
+}
 
 AdcWrapper::AdcWrapper(unsigned int pin_num, char *name) {
   m_adc = new Adc(pin_num, name);
+  m_stream = NULL;
 }
 
 AdcWrapper::~AdcWrapper() {
+  stop_stream();
   delete m_adc;
 }
 
+void AdcWrapper::stop_stream() {
+  if (!m_stream)
+    return;
+
+  {
+    /* Taken so that the DSP thread cannot miss the wake up */
+    std::lock_guard<std::mutex> l(m_stream->lock);
+    m_stream->quit = true;
+  }
+  m_stream->dsp_cond.notify_one();
+  m_stream->thread.join();
+  if (m_stream->dsp_thread.joinable())
+    m_stream->dsp_thread.join();
+  for (size_t c = 1; c < m_stream->channels.size(); c++)
+    m_stream->channels[c]->Unref();
+  m_stream->wrap = NULL;
+  uv_close(reinterpret_cast<uv_handle_t*>(&m_stream->async),
+           adc_stream_close_cb);
+  m_stream = NULL;
+  Unref();
+}
+
 void AdcWrapper::Init(Local<Object> exports) {
   Isolate* isolate = exports->GetIsolate();
   Local<FunctionTemplate> modal = FunctionTemplate::New(isolate, New);
@@ -60,7 +378,14 @@ void AdcWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "set_pin_num", set_pin_num);
   NODE_SET_PROTOTYPE_METHOD(modal, "set_name", set_name);
 
+  NODE_SET_PROTOTYPE_METHOD(modal, "stream_start", stream_start);
+  NODE_SET_PROTOTYPE_METHOD(modal, "stream_stop", stream_stop);
+  NODE_SET_PROTOTYPE_METHOD(modal, "stream_stats", stream_stats);
+  NODE_SET_PROTOTYPE_METHOD(modal, "enable_fast_io", enable_fast_io);
+  NODE_SET_PROTOTYPE_METHOD(modal, "disable_fast_io", disable_fast_io);
+
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "adc"),
     modal->GetFunction());
 }
@@ -114,9 +439,15 @@ void AdcWrapper::request(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  Adc* obj = ObjectWrap::Unwrap<AdcWrapper>(args.Holder())->getObj();
+  AdcWrapper* wrap = ObjectWrap::Unwrap<AdcWrapper>(args.Holder());
+  artik_error ret;
+
+  {
+    std::lock_guard<std::mutex> io(wrap->getLock());
+    ret = wrap->getObj()->request();
+  }
 
-  args.GetReturnValue().Set(Number::New(isolate, obj->request()));
+  args.GetReturnValue().Set(Number::New(isolate, ret));
 }
 
 void AdcWrapper::release(const FunctionCallbackInfo<Value>& args) {
@@ -126,9 +457,17 @@ void AdcWrapper::release(const FunctionCallbackInfo<Value>& args) {
                       isolate, "Wrong number of arguments")));
     return;
   }
-  Adc* obj = ObjectWrap::Unwrap<AdcWrapper>(args.Holder())->getObj();
+  AdcWrapper* wrap = ObjectWrap::Unwrap<AdcWrapper>(args.Holder());
+
+  artik_error ret;
 
-  args.GetReturnValue().Set(Number::New(isolate, obj->release()));
+  wrap->stop_stream();
+  wrap->m_fast.reset();
+  {
+    std::lock_guard<std::mutex> io(wrap->getLock());
+    ret = wrap->getObj()->release();
+  }
+  args.GetReturnValue().Set(Number::New(isolate, ret));
 }
 
 void AdcWrapper::get_value(const FunctionCallbackInfo<Value>& args) {
@@ -139,9 +478,15 @@ void AdcWrapper::get_value(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  Adc* obj = ObjectWrap::Unwrap<AdcWrapper>(args.Holder())->getObj();
+  AdcWrapper* wrap = ObjectWrap::Unwrap<AdcWrapper>(args.Holder());
   int val = -1;
-  obj->get_value(&val);
+
+  if (wrap->m_fast) {
+    wrap->m_fast->read_int(&val);
+  } else {
+    std::lock_guard<std::mutex> io(wrap->getLock());
+    wrap->getObj()->get_value(&val);
+  }
 
   args.GetReturnValue().Set(Number::New(isolate, val));
 }
@@ -211,4 +556,195 @@ void AdcWrapper::set_name(const FunctionCallbackInfo<Value>& args) {
   obj->set_name(*val);
 }
 
+void AdcWrapper::stream_start(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  AdcWrapper* wrap = ObjectWrap::Unwrap<AdcWrapper>(args.Holder());
+
+  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsFunction()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  auto rate = js_object_attribute_to_cpp<double>(args[0], "rate");
+  auto frames = js_object_attribute_to_cpp<uint32_t>(args[0], "block_size");
+  auto ring_size = js_object_attribute_to_cpp<uint32_t>(args[0], "ring_size");
+  auto channels = js_object_attribute_to_cpp<Local<v8::Array>>(args[0],
+      "channels");
+  uint32_t block_frames = frames ? frames.value() : 256;
+  uint32_t blocks = ring_size ? ring_size.value() : 8;
+
+  if (!rate || rate.value() <= 0 || rate.value() > 1e6 || block_frames == 0 ||
+      blocks == 0) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Invalid sampling settings")));
+    return;
+  }
+
+  if (wrap->m_stream) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Stream already started")));
+    return;
+  }
+
+  DspPipeline* dsp = NULL;
+  auto dsp_options = js_object_attribute_to_cpp<Local<Value>>(args[0], "dsp");
+
+  if (dsp_options) {
+    dsp = dsp_pipeline_from_js(isolate, dsp_options.value());
+    if (!dsp)
+      return;
+  }
+
+  auto recorder = js_object_attribute_to_cpp<Local<Value>>(args[0],
+      "recorder");
+  RecorderWrapper* recorder_wrap = NULL;
+
+  if (recorder) {
+    recorder_wrap = RecorderWrapper::from_js(recorder.value());
+    if (!recorder_wrap) {
+      delete dsp;
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Option recorder should be a recorder")));
+      return;
+    }
+  }
+
+  AdcStream* stream = new AdcStream();
+  Local<v8::Array> handles = Nan::New<v8::Array>();
+
+  /* This ADC always comes first, then the extra channels in order */
+  stream->channels.push_back(wrap);
+  stream->fast.push_back(wrap->getFastIo());
+  if (channels) {
+    Local<v8::Array> array = channels.value();
+    Local<FunctionTemplate> adc = Local<FunctionTemplate>::New(isolate, tmpl);
+
+    for (unsigned int i = 0; i < array->Length(); i++) {
+      Local<Value> channel = Nan::Get(array, i).ToLocalChecked();
+
+      if (!adc->HasInstance(channel)) {
+        delete dsp;
+        delete stream;
+        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+            isolate, "Channels should be ADC instances")));
+        return;
+      }
+
+      AdcWrapper* other = ObjectWrap::Unwrap<AdcWrapper>(channel.As<Object>());
+
+      stream->channels.push_back(other);
+      stream->fast.push_back(other->getFastIo());
+      Nan::Set(handles, i, channel);
+    }
+  }
+
+  if (recorder_wrap &&
+      recorder_wrap->getFile()->channels() != stream->channels.size()) {
+    delete dsp;
+    delete stream;
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Recorder channels do not match the stream")));
+    return;
+  }
+
+  struct timespec mono;
+
+  clock_gettime(CLOCK_MONOTONIC, &mono);
+  if (recorder_wrap)
+    stream->recorder = recorder_wrap->getFile();
+  stream->realtime_offset = RingFile::now() - to_ns(mono) / 1e6;
+  stream->wrap = wrap;
+  stream->quit = false;
+  stream->error = S_OK;
+  stream->handles.Reset(handles);
+  stream->period = static_cast<uint64_t>(1e9 / rate.value());
+  stream->frames = block_frames;
+  stream->blocks.resize(blocks);
+  stream->timestamps.resize(blocks);
+  for (uint32_t i = 0; i < blocks; i++) {
+    stream->blocks[i].resize(block_frames * stream->channels.size());
+    stream->free_blocks.push_back(i);
+  }
+  stream->dsp = dsp;
+  if (dsp) {
+    dsp->reset(stream->channels.size());
+    stream->features.resize(blocks);
+  }
+  stream->callback = new Nan::Callback(args[1].As<Function>());
+  stream->samples = 0;
+  stream->overruns = 0;
+  stream->missed = 0;
+  stream->dropped = 0;
+
+  stream->async.data = stream;
+  uv_async_init(uv_default_loop(), &stream->async, adc_stream_async_cb);
+
+  /* Keep the wrappers alive for as long as the stream runs */
+  for (size_t c = 0; c < stream->channels.size(); c++)
+    stream->channels[c]->Ref();
+  wrap->m_stream = stream;
+  stream->thread = std::thread(&AdcStream::run, stream);
+  if (dsp)
+    stream->dsp_thread = std::thread(&AdcStream::run_dsp, stream);
+}
+
+void AdcWrapper::stream_stop(const FunctionCallbackInfo<Value>& args) {
+  ObjectWrap::Unwrap<AdcWrapper>(args.Holder())->stop_stream();
+}
+
+void AdcWrapper::stream_stats(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  AdcStream* stream = ObjectWrap::Unwrap<AdcWrapper>(args.Holder())->m_stream;
+  Local<Object> stats = Object::New(isolate);
+
+  if (stream) {
+    std::lock_guard<std::mutex> l(stream->lock);
+    stats->Set(String::NewFromUtf8(isolate, "samples"),
+               Number::New(isolate, stream->samples));
+    stats->Set(String::NewFromUtf8(isolate, "overruns"),
+               Number::New(isolate, stream->overruns));
+    stats->Set(String::NewFromUtf8(isolate, "missed"),
+               Number::New(isolate, stream->missed));
+    stats->Set(String::NewFromUtf8(isolate, "pending"),
+               Number::New(isolate, stream->filled_blocks.size() +
+                   stream->dsp_blocks.size()));
+  }
+
+  args.GetReturnValue().Set(stats);
+}
+
+void AdcWrapper::enable_fast_io(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  AdcWrapper* wrap = ObjectWrap::Unwrap<AdcWrapper>(args.Holder());
+
+  if (args.Length() > 1 || (args.Length() == 1 && !args[0]->IsString())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  std::string root = args.Length() ? *v8::String::Utf8Value(args[0]) : "";
+  std::string path = sysfs_path(root,
+      "bus/iio/devices/iio:device0/in_voltage" +
+      std::to_string(wrap->getObj()->get_pin_num()) + "_raw");
+  std::shared_ptr<SysfsFile> file = std::make_shared<SysfsFile>();
+  int err = file->open(path, O_RDONLY);
+
+  if (err < 0) {
+    std::string msg = "Cannot open " + path + ": " + strerror(-err);
+
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, msg.c_str())));
+    return;
+  }
+
+  /* A running stream keeps sampling through its own reference */
+  wrap->m_fast = file;
+}
+
+void AdcWrapper::disable_fast_io(const FunctionCallbackInfo<Value>& args) {
+  ObjectWrap::Unwrap<AdcWrapper>(args.Holder())->m_fast.reset();
+}
+
 }  // namespace artik
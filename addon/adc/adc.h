@@ -26,13 +26,23 @@
 #include <uv.h>
 #include <artik_adc.hh>
 
+#include <memory>
+#include <mutex>
+
+#include "base/sysfs_file.h"
+
 namespace artik {
 
+struct AdcStream;
+
 class AdcWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
 
   Adc* getObj() { return m_adc; }
+  std::mutex& getLock() { return m_lock; }
+  /* Shared with the streams sampling this ADC */
+  std::shared_ptr<SysfsFile> getFastIo() { return m_fast; }
 
  private:
   AdcWrapper(unsigned int, char*);
@@ -41,6 +51,7 @@ class AdcWrapper : public node::ObjectWrap {
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   static void request(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void release(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -52,7 +63,20 @@ class AdcWrapper : public node::ObjectWrap {
   static void set_pin_num(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void set_name(const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  static void stream_start(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stream_stop(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stream_stats(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void enable_fast_io(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void disable_fast_io(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void stop_stream();
+
   Adc *m_adc;
+  /* Serializes SDK reads between the JS thread and sampling threads */
+  std::mutex m_lock;
+  AdcStream* m_stream;
+  std::shared_ptr<SysfsFile> m_fast;
 };
 
 }  // namespace artik
@@ -19,13 +19,16 @@
 #include <artik_module.h>
 
 #include <node.h>
+#include <loop.h>
 
 #include "i2c/i2c.h"
 #include "gpio/gpio.h"
+#include "gpio/gpio_group.h"
 #include "serial/serial.h"
 #include "pwm/pwm.h"
 #include "adc/adc.h"
 #include "http/http.h"
+#include "http/http_headers.h"
 #include "websocket/websocket.h"
 #include "cloud/cloud.h"
 #include "wifi/wifi.h"
@@ -33,6 +36,8 @@
 #include "spi/spi.h"
 #include "time/time.h"
 #include "sensor/sensor.h"
+#include "sensor/sensor_hub.h"
+#include "recorder/recorder.h"
 #include "network/network.h"
 #include "bluetooth/bluetooth.h"
 #include "zigbee/zigbee.h"
@@ -139,6 +144,18 @@ namespace artik {
     args.GetReturnValue().Set(v8::String::NewFromUtf8(isolate, modelnum));
   }
 
+  void SetGlibThread(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    v8::Isolate* isolate = args.GetIsolate();
+
+    if (args.Length() != 1 || !args[0]->IsBoolean()) {
+      isolate->ThrowException(v8::Exception::TypeError(
+          v8::String::NewFromUtf8(isolate, "Wrong arguments")));
+      return;
+    }
+
+    GlibLoop::Instance()->set_threaded(args[0]->BooleanValue());
+  }
+
   void DestroyAll(const v8::FunctionCallbackInfo<v8::Value>& args) {
   }
 
@@ -154,21 +171,26 @@ namespace artik {
     NODE_SET_METHOD(exports, "get_platform_manufacturer", GetPlatformManufacturer);
     NODE_SET_METHOD(exports, "get_platform_uptime", GetPlatformUptime);
     NODE_SET_METHOD(exports, "get_platform_model_number", GetPlatformModelNumber);
+    NODE_SET_METHOD(exports, "set_glib_thread", SetGlibThread);
     NODE_SET_METHOD(exports, "destroy", DestroyAll);
 
     /* Register all modules */
     GpioWrapper::Init(exports);
+    GpioGroupWrapper::Init(exports);
     I2cWrapper::Init(exports);
     SerialWrapper::Init(exports);
     PwmWrapper::Init(exports);
     AdcWrapper::Init(exports);
     HttpWrapper::Init(exports);
+    HttpHeadersWrapper::Init(exports);
     CloudWrapper::Init(exports);
     WifiWrapper::Init(exports);
     MediaWrapper::Init(exports);
     SpiWrapper::Init(exports);
     TimeWrapper::Init(exports);
     SensorWrapper::Init(exports);
+    SensorHubWrapper::Init(exports);
+    RecorderWrapper::Init(exports);
     NetworkWrapper::Init(exports);
     WebsocketWrapper::Init(exports);
     BluetoothWrapper::Init(exports);
@@ -0,0 +1,128 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "base/sha256.h"
+
+#include <string.h>
+
+namespace artik {
+
+static const uint32_t k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t ror(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+void Sha256::reset() {
+  static const uint32_t init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  memcpy(m_state, init, sizeof(m_state));
+  m_length = 0;
+  m_used = 0;
+}
+
+void Sha256::transform(const uint8_t* block) {
+  uint32_t w[64];
+  uint32_t s[8];
+
+  for (int i = 0; i < 16; i++)
+    w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+           (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = ror(w[i - 15], 7) ^ ror(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = ror(w[i - 2], 17) ^ ror(w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  memcpy(s, m_state, sizeof(s));
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = s[7] + (ror(s[4], 6) ^ ror(s[4], 11) ^ ror(s[4], 25)) +
+                  ((s[4] & s[5]) ^ (~s[4] & s[6])) + k[i] + w[i];
+    uint32_t t2 = (ror(s[0], 2) ^ ror(s[0], 13) ^ ror(s[0], 22)) +
+                  ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+
+    memmove(s + 1, s, 7 * sizeof(uint32_t));
+    s[4] += t1;
+    s[0] = t1 + t2;
+  }
+
+  for (int i = 0; i < 8; i++)
+    m_state[i] += s[i];
+}
+
+void Sha256::update(const void* data, size_t size) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+
+  m_length += size;
+
+  if (m_used) {
+    size_t n = 64 - m_used < size ? 64 - m_used : size;
+
+    memcpy(m_block + m_used, p, n);
+    m_used += n;
+    p += n;
+    size -= n;
+    if (m_used < 64)
+      return;
+    transform(m_block);
+    m_used = 0;
+  }
+
+  for (; size >= 64; p += 64, size -= 64)
+    transform(p);
+
+  memcpy(m_block, p, size);
+  m_used = size;
+}
+
+std::string Sha256::hex_digest() {
+  static const char digits[] = "0123456789abcdef";
+  uint64_t bits = m_length * 8;
+  uint8_t pad[72] = { 0x80 };
+  size_t pad_size = (m_used < 56 ? 56 : 120) - m_used;
+  std::string hex;
+
+  for (int i = 0; i < 8; i++)
+    pad[pad_size + i] = bits >> (56 - i * 8);
+  update(pad, pad_size + 8);
+
+  for (int i = 0; i < 8; i++) {
+    for (int j = 28; j >= 0; j -= 4)
+      hex += digits[(m_state[i] >> j) & 0xf];
+  }
+
+  return hex;
+}
+
+}  // namespace artik
@@ -0,0 +1,50 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_BASE_SHA256_H_
+#define ADDON_BASE_SHA256_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+namespace artik {
+
+/* Incremental SHA-256 (FIPS 180-4), fed as data comes */
+class Sha256 {
+ public:
+  Sha256() { reset(); }
+
+  void reset();
+  void update(const void* data, size_t size);
+  /* Lower-case hexadecimal digest, the context must be reset for reuse */
+  std::string hex_digest();
+
+ private:
+  void transform(const uint8_t* block);
+
+  uint32_t m_state[8];
+  uint64_t m_length;
+  uint8_t m_block[64];
+  size_t m_used;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_BASE_SHA256_H_
@@ -0,0 +1,114 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "base/sysfs_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace artik {
+
+static artik_error errno_to_artik(int err) {
+  switch (err) {
+  case EACCES:
+  case EPERM:
+    return E_ACCESS_DENIED;
+  case EBUSY:
+    return E_BUSY;
+  case EINVAL:
+  case ERANGE:
+    return E_BAD_ARGS;
+  default:
+    return E_NOT_SUPPORTED;
+  }
+}
+
+SysfsFile::SysfsFile() : m_fd(-1), m_regular(false) {
+}
+
+SysfsFile::~SysfsFile() {
+  if (m_fd >= 0)
+    ::close(m_fd);
+}
+
+int SysfsFile::open(const std::string& path, int flags) {
+  int fd = ::open(path.c_str(), flags | O_CLOEXEC);
+  struct stat st;
+
+  if (fd < 0)
+    return -errno;
+
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = fd;
+  m_regular = (fstat(fd, &st) == 0 && S_ISREG(st.st_mode));
+  m_path = path;
+
+  return 0;
+}
+
+artik_error SysfsFile::read_int(int* value) {
+  char buf[32];
+  char* end;
+  ssize_t len;
+
+  do {
+    len = pread(m_fd, buf, sizeof(buf) - 1, 0);
+  } while (len < 0 && errno == EINTR);
+
+  if (len < 0)
+    return errno_to_artik(errno);
+  if (len == 0)
+    return E_BAD_ARGS;
+
+  buf[len] = '\0';
+  *value = strtol(buf, &end, 10);
+  if (end == buf)
+    return E_BAD_ARGS;
+
+  return S_OK;
+}
+
+artik_error SysfsFile::write_int(int value) {
+  char buf[16];
+  int len = snprintf(buf, sizeof(buf), "%d", value);
+  ssize_t ret;
+
+  do {
+    ret = pwrite(m_fd, buf, len, 0);
+  } while (ret < 0 && errno == EINTR);
+
+  if (ret < 0)
+    return errno_to_artik(errno);
+
+  /* Plain files stand in for attributes in tests, drop any longer value */
+  if (m_regular && ftruncate(m_fd, len) < 0)
+    return errno_to_artik(errno);
+
+  return S_OK;
+}
+
+std::string sysfs_path(const std::string& root, const std::string& path) {
+  return (root.empty() ? std::string("/sys") : root) + "/" + path;
+}
+
+}  // namespace artik
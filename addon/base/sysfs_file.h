@@ -0,0 +1,61 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_BASE_SYSFS_FILE_H_
+#define ADDON_BASE_SYSFS_FILE_H_
+
+#include <artik_error.h>
+
+#include <string>
+
+namespace artik {
+
+/*
+ * Sysfs attribute kept open across accesses. Every read or write is a
+ * single pread()/pwrite() at offset 0, which makes the kernel refresh or
+ * store the attribute, instead of the open/access/close sequence of the
+ * SDK accessors.
+ */
+class SysfsFile {
+ public:
+  SysfsFile();
+  ~SysfsFile();
+
+  /* Returns 0 or a negative errno */
+  int open(const std::string& path, int flags);
+
+  artik_error read_int(int* value);
+  artik_error write_int(int value);
+
+  const std::string& path() const { return m_path; }
+
+ private:
+  SysfsFile(const SysfsFile&);
+  SysfsFile& operator=(const SysfsFile&);
+
+  int m_fd;
+  bool m_regular;
+  std::string m_path;
+};
+
+/* Location of 'path' under 'root', "/sys" when 'root' is empty */
+std::string sysfs_path(const std::string& root, const std::string& path);
+
+}  // namespace artik
+
+#endif  // ADDON_BASE_SYSFS_FILE_H_
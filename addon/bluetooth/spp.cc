@@ -54,7 +54,25 @@ using v8::Context;
 Persistent<Function> SppSocketWrapper::constructor;
 Persistent<Function> SppWrapper::constructor;
 
-static int _socket_watch(int fd, enum watch_io io, void *user_data) {
+SppSocketWrapper::SppSocketWrapper(const std::string& device_path, int fd,
+    int version, int features)
+  : m_device_path(device_path),
+    m_fd(fd),
+    m_version(version),
+    m_features(features),
+    m_watch_id(0),
+    m_paused(false),
+    m_in_watch(false),
+    m_closed(false) {
+}
+
+SppSocketWrapper::~SppSocketWrapper() {
+  stop_watch();
+  delete m_emit;
+}
+
+int SppSocketWrapper::socket_watch(int fd, enum watch_io io,
+    void *user_data) {
   int ret = 0;
   Isolate *isolate = Isolate::GetCurrent();
   HandleScope scope(isolate);
@@ -74,7 +92,8 @@ static int _socket_watch(int fd, enum watch_io io, void *user_data) {
           reinterpret_cast<char*>(buffer), num_bytes);
       js_buffer = buf.ToLocalChecked();
     }
-    ret = 1;
+    /* An empty read means the remote side closed the connection */
+    ret = (num_bytes != 0) ? 1 : 0;
   } else if (io & WATCH_IO_ERR) {
     std::string msg = "Error: unable to read the socket.";
     error = String::NewFromUtf8(isolate, msg.c_str());
@@ -92,20 +111,47 @@ static int _socket_watch(int fd, enum watch_io io, void *user_data) {
     js_buffer
   };
 
+  wrapSocket->m_in_watch = true;
   wrapSocket->emit(isolate, wrapSocket, 3, argv);
-  return ret;
+  wrapSocket->m_in_watch = false;
+
+  if (!ret)
+    wrapSocket->m_closed = true;
+
+  /* A pause() requested from the "data" handler drops the watch here */
+  if (!ret || wrapSocket->m_paused) {
+    wrapSocket->m_watch_id = 0;
+    return 0;
+  }
+
+  return 1;
 }
 
-SppSocketWrapper::SppSocketWrapper(const std::string& device_path, int fd,
-    int version, int features)
-  : m_device_path(device_path),
-    m_fd(fd),
-    m_version(version),
-    m_features(features) {
+artik_error SppSocketWrapper::start_watch() {
+  artik_loop_module* loop =
+      reinterpret_cast<artik_loop_module*>(artik_request_api_module("loop"));
+
+  artik_error err = loop->add_fd_watch(
+      m_fd,
+      (watch_io)(WATCH_IO_IN | WATCH_IO_ERR | WATCH_IO_HUP | WATCH_IO_NVAL),
+      socket_watch,
+      this,
+      &m_watch_id);
+
+  artik_release_api_module(loop);
+  return err;
 }
 
-SppSocketWrapper::~SppSocketWrapper() {
-  delete m_emit;
+void SppSocketWrapper::stop_watch() {
+  if (!m_watch_id)
+    return;
+
+  artik_loop_module* loop =
+      reinterpret_cast<artik_loop_module*>(artik_request_api_module("loop"));
+
+  loop->remove_fd_watch(m_watch_id);
+  m_watch_id = 0;
+  artik_release_api_module(loop);
 }
 
 void SppSocketWrapper::Init(Local<Object> exports) {
@@ -125,6 +171,8 @@ void SppSocketWrapper::Init(Local<Object> exports) {
   objTpl->SetAccessor(String::NewFromUtf8(isolate, "features"),
           getFeatures);
   NODE_SET_PROTOTYPE_METHOD(tpl, "write", write);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "pause", pause);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "resume", resume);
 
   constructor.Reset(isolate, tpl->GetFunction());
   exports->Set(String::NewFromUtf8(isolate, "SppSocket"),
@@ -154,18 +202,11 @@ void SppSocketWrapper::New(const FunctionCallbackInfo<Value>& args) {
     int fd = args[1]->Int32Value();
     int version = args[2]->Int32Value();
     int features = args[3]->Int32Value();
-    artik_loop_module* loop =
-        reinterpret_cast<artik_loop_module*>(artik_request_api_module("loop"));
 
     SppSocketWrapper* obj = new SppSocketWrapper(*device_path, fd, version,
         features);
 
-    artik_error err = loop->add_fd_watch(
-        fd,
-        (watch_io)(WATCH_IO_IN | WATCH_IO_ERR | WATCH_IO_HUP | WATCH_IO_NVAL),
-        _socket_watch,
-        obj,
-        NULL);
+    artik_error err = obj->start_watch();
 
     if (err != S_OK) {
       delete obj;
@@ -257,6 +298,39 @@ void SppSocketWrapper::write(const FunctionCallbackInfo<Value>& args) {
   }
 }
 
+void SppSocketWrapper::pause(const FunctionCallbackInfo<Value>& args) {
+  SppSocketWrapper* obj = ObjectWrap::Unwrap<SppSocketWrapper>(args.Holder());
+
+  if (obj->m_paused)
+    return;
+
+  obj->m_paused = true;
+
+  /* From the "data" handler, socket_watch() drops the watch itself */
+  if (!obj->m_in_watch)
+    obj->stop_watch();
+}
+
+void SppSocketWrapper::resume(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SppSocketWrapper* obj = ObjectWrap::Unwrap<SppSocketWrapper>(args.Holder());
+
+  if (!obj->m_paused)
+    return;
+
+  obj->m_paused = false;
+
+  if (obj->m_watch_id || obj->m_closed)
+    return;
+
+  artik_error err = obj->start_watch();
+  if (err != S_OK) {
+    std::string msg = "Error: " + std::string(error_msg(err));
+    isolate->ThrowException(Exception::Error(
+          String::NewFromUtf8(isolate, msg.c_str())));
+  }
+}
+
 static void _spp_release(artik_bt_event event,
     void *data, void *user_data) {
   Isolate *isolate = Isolate::GetCurrent();
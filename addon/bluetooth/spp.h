@@ -20,6 +20,7 @@
 #define ADDON_BLUETOOTH_SPP_H_
 
 #include <artik_bluetooth.hh>
+#include <artik_loop.h>
 
 #include <node.h>
 #include <node_object_wrap.h>
@@ -56,11 +57,27 @@ class SppSocketWrapper : public node::ObjectWrap {
   static void getFeatures(v8::Local<v8::String> property,
       const v8::PropertyCallbackInfo<v8::Value>& info);
   static void write(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void pause(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void resume(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  static int socket_watch(int fd, enum watch_io io, void *user_data);
+  artik_error start_watch();
+  void stop_watch();
+
   std::string m_device_path;
   int m_fd;
   int m_version;
   int m_features;
 
+  /*
+   * The fd watch is removed while the socket is paused so that unread data
+   * stays in the kernel and RFCOMM flow control throttles the remote side.
+   */
+  int m_watch_id;
+  bool m_paused;
+  bool m_in_watch;
+  bool m_closed;
+
   v8::Persistent<v8::Function>* m_emit;
 };
 
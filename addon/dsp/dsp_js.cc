@@ -0,0 +1,150 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "dsp/dsp_js.h"
+
+#include <string.h>
+#include <utils.h>
+
+#include <string>
+#include <vector>
+
+namespace artik {
+
+using v8::Exception;
+using v8::Isolate;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::String;
+using v8::Value;
+
+static std::vector<float> to_floats(const std::vector<double>& values) {
+  return std::vector<float>(values.begin(), values.end());
+}
+
+DspPipeline* dsp_pipeline_from_js(Isolate* isolate, Local<Value> options) {
+  if (!options->IsObject()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return NULL;
+  }
+
+  DspPipeline* dsp = new DspPipeline();
+  auto iir = js_object_attribute_to_cpp<Local<Value>>(options, "iir");
+  auto average = js_object_attribute_to_cpp<uint32_t>(options,
+      "moving_average");
+  auto fir = js_object_attribute_to_cpp<std::vector<double>>(options, "fir");
+  auto decimate = js_object_attribute_to_cpp<uint32_t>(options, "decimate");
+  auto peaks = js_object_attribute_to_cpp<Local<Value>>(options, "peaks");
+  auto fft = js_object_attribute_to_cpp<Local<Value>>(options, "fft");
+  auto samples = js_object_attribute_to_cpp<bool>(options, "samples");
+
+  if (iir) {
+    auto b = js_object_attribute_to_cpp<std::vector<double>>(iir.value(), "b");
+    auto a = js_object_attribute_to_cpp<std::vector<double>>(iir.value(), "a");
+
+    if (!b || !a || !dsp->set_iir(to_floats(b.value()), to_floats(a.value()))) {
+      delete dsp;
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Invalid IIR coefficients")));
+      return NULL;
+    }
+  }
+
+  if (average)
+    dsp->set_moving_average(average.value());
+
+  if (fir)
+    dsp->set_fir(to_floats(fir.value()));
+
+  if (decimate)
+    dsp->set_decimation(decimate.value());
+
+  if (peaks) {
+    auto threshold = js_object_attribute_to_cpp<double>(peaks.value(),
+        "threshold");
+    auto distance = js_object_attribute_to_cpp<uint32_t>(peaks.value(),
+        "distance");
+
+    dsp->set_peaks(threshold ? threshold.value() : 0,
+                   distance ? distance.value() : 1);
+  }
+
+  if (fft) {
+    auto size = js_object_attribute_to_cpp<uint32_t>(fft.value(), "size");
+    auto window = js_object_attribute_to_cpp<std::string>(fft.value(),
+        "window");
+    bool hann = window && window.value() == "hann";
+
+    if (!size || (window && !hann && window.value() != "none") ||
+        !dsp->set_fft(size.value(), hann)) {
+      delete dsp;
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Invalid FFT settings")));
+      return NULL;
+    }
+  }
+
+  if (samples)
+    dsp->set_keep_samples(samples.value());
+
+  return dsp;
+}
+
+static Local<v8::Float32Array> to_float32_array(Isolate* isolate,
+    const std::vector<float>& values) {
+  size_t size = values.size() * sizeof(float);
+  Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, size);
+
+  if (size)
+    memcpy(buffer->GetContents().Data(), values.data(), size);
+
+  return v8::Float32Array::New(buffer, 0, values.size());
+}
+
+Local<Object> dsp_features_to_js(Isolate* isolate,
+    const DspPipeline::Features& features) {
+  Local<Object> js_features = Object::New(isolate);
+  Local<v8::Array> peaks = v8::Array::New(isolate, features.peaks.size());
+
+  for (size_t i = 0; i < features.peaks.size(); i++)
+    peaks->Set(i, Number::New(isolate, features.peaks[i]));
+
+  js_features->Set(String::NewFromUtf8(isolate, "mean"),
+                   Number::New(isolate, features.mean));
+  js_features->Set(String::NewFromUtf8(isolate, "rms"),
+                   Number::New(isolate, features.rms));
+  js_features->Set(String::NewFromUtf8(isolate, "min"),
+                   Number::New(isolate, features.min));
+  js_features->Set(String::NewFromUtf8(isolate, "max"),
+                   Number::New(isolate, features.max));
+  js_features->Set(String::NewFromUtf8(isolate, "peak_index"),
+                   Number::New(isolate, features.peak_index));
+  js_features->Set(String::NewFromUtf8(isolate, "peaks"), peaks);
+  if (!features.spectrum.empty())
+    js_features->Set(String::NewFromUtf8(isolate, "spectrum"),
+                     to_float32_array(isolate, features.spectrum));
+  if (!features.samples.empty())
+    js_features->Set(String::NewFromUtf8(isolate, "samples"),
+                     to_float32_array(isolate, features.samples));
+
+  return js_features;
+}
+
+}  // namespace artik
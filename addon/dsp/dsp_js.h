@@ -0,0 +1,41 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_DSP_DSP_JS_H_
+#define ADDON_DSP_DSP_JS_H_
+
+#include <node.h>
+#include <nan.h>
+
+#include "dsp/dsp_pipeline.h"
+
+namespace artik {
+
+/*
+ * Build a pipeline from its JS description, throws and returns NULL when
+ * the options are invalid.
+ */
+DspPipeline* dsp_pipeline_from_js(v8::Isolate* isolate,
+    v8::Local<v8::Value> options);
+
+v8::Local<v8::Object> dsp_features_to_js(v8::Isolate* isolate,
+    const DspPipeline::Features& features);
+
+}  // namespace artik
+
+#endif  // ADDON_DSP_DSP_JS_H_
@@ -0,0 +1,359 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "dsp/dsp_pipeline.h"
+
+#include <math.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include <algorithm>
+
+namespace artik {
+
+/* Inner loop of the FIR filter and of the energy computations */
+static float dot(const float *a, const float *b, size_t n) {
+  size_t i = 0;
+  float sum = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  float32x4_t acc = vdupq_n_f32(0);
+
+  for (; i + 4 <= n; i += 4)
+    acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+
+  float32x2_t half = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+  sum = vget_lane_f32(vpadd_f32(half, half), 0);
+#elif defined(__SSE__)
+  __m128 acc = _mm_setzero_ps();
+  float lanes[4];
+
+  for (; i + 4 <= n; i += 4)
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+  _mm_storeu_ps(lanes, acc);
+  sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+  for (; i < n; i++)
+    sum += a[i] * b[i];
+
+  return sum;
+}
+
+DspPipeline::DspPipeline()
+  : m_average(0),
+    m_decimation(1),
+    m_peaks(false),
+    m_peak_threshold(0),
+    m_peak_distance(1),
+    m_fft_size(0),
+    m_keep_samples(false) {
+}
+
+bool DspPipeline::set_iir(const std::vector<float>& b,
+                          const std::vector<float>& a) {
+  if (b.empty() || a.empty() || a[0] == 0)
+    return false;
+
+  size_t length = std::max(a.size(), b.size());
+
+  m_iir_b.assign(length, 0);
+  m_iir_a.assign(length, 0);
+  for (size_t i = 0; i < b.size(); i++)
+    m_iir_b[i] = b[i] / a[0];
+  for (size_t i = 0; i < a.size(); i++)
+    m_iir_a[i] = a[i] / a[0];
+
+  return true;
+}
+
+void DspPipeline::set_moving_average(size_t length) {
+  m_average = length > 1 ? length : 0;
+}
+
+void DspPipeline::set_fir(const std::vector<float>& taps) {
+  /* Stored reversed so that outputs are plain dot products */
+  m_fir.assign(taps.rbegin(), taps.rend());
+}
+
+void DspPipeline::set_decimation(size_t factor) {
+  m_decimation = factor ? factor : 1;
+}
+
+void DspPipeline::set_peaks(float threshold, size_t distance) {
+  m_peaks = true;
+  m_peak_threshold = threshold;
+  m_peak_distance = distance ? distance : 1;
+}
+
+bool DspPipeline::set_fft(size_t size, bool hann) {
+  if (size == 0) {
+    m_fft_size = 0;
+    return true;
+  }
+
+  if (size < 4 || (size & (size - 1)))
+    return false;
+
+  size_t half = size / 2;
+  size_t bits = 0;
+
+  while ((static_cast<size_t>(1) << bits) < half)
+    bits++;
+
+  m_fft_size = size;
+  m_window.assign(size, 1);
+  if (hann) {
+    for (size_t i = 0; i < size; i++)
+      m_window[i] = 0.5f - 0.5f * cosf(2 * M_PI * i / (size - 1));
+  }
+
+  m_twiddles.resize(half + 1);
+  for (size_t k = 0; k <= half; k++)
+    m_twiddles[k] = std::polar(1.0f, static_cast<float>(-2 * M_PI * k / size));
+
+  m_bit_reverse.resize(half);
+  for (size_t i = 0; i < half; i++) {
+    size_t r = 0;
+
+    for (size_t b = 0; b < bits; b++)
+      r |= ((i >> b) & 1) << (bits - 1 - b);
+    m_bit_reverse[i] = r;
+  }
+
+  return true;
+}
+
+void DspPipeline::reset(size_t channels) {
+  m_channels.assign(channels, Channel());
+
+  for (auto& channel : m_channels) {
+    if (!m_iir_a.empty())
+      channel.iir_state.assign(m_iir_a.size() - 1, 0);
+    channel.average.assign(m_average, 0);
+    channel.average_pos = 0;
+    channel.average_sum = 0;
+    if (!m_fir.empty())
+      channel.fir_history.assign(m_fir.size() - 1, 0);
+    channel.phase = 0;
+    channel.fft_history.assign(m_fft_size, 0);
+    channel.fft_filled = 0;
+  }
+}
+
+void DspPipeline::process(const int32_t *in, size_t frames,
+                          std::vector<Features> *out) {
+  size_t count = m_channels.size();
+  std::vector<float> samples(frames);
+
+  out->resize(count);
+
+  for (size_t c = 0; c < count; c++) {
+    for (size_t i = 0; i < frames; i++)
+      samples[i] = static_cast<float>(in[i * count + c]);
+
+    filter(&m_channels[c], &samples);
+    analyze(&m_channels[c], samples, &(*out)[c]);
+  }
+}
+
+void DspPipeline::filter(Channel *channel, std::vector<float> *samples) {
+  std::vector<float>& x = *samples;
+
+  if (!m_iir_a.empty()) {
+    std::vector<float>& z = channel->iir_state;
+    size_t order = z.size();
+
+    /* Direct form II transposed */
+    for (size_t i = 0; i < x.size(); i++) {
+      float in = x[i];
+      float y = m_iir_b[0] * in + (order ? z[0] : 0);
+
+      for (size_t k = 0; k + 1 < order; k++)
+        z[k] = m_iir_b[k + 1] * in - m_iir_a[k + 1] * y + z[k + 1];
+      if (order)
+        z[order - 1] = m_iir_b[order] * in - m_iir_a[order] * y;
+      x[i] = y;
+    }
+  }
+
+  if (m_average) {
+    for (size_t i = 0; i < x.size(); i++) {
+      channel->average_sum += x[i] - channel->average[channel->average_pos];
+      channel->average[channel->average_pos] = x[i];
+      channel->average_pos = (channel->average_pos + 1) % m_average;
+      x[i] = static_cast<float>(channel->average_sum / m_average);
+    }
+  }
+
+  if (m_fir.empty() && m_decimation == 1)
+    return;
+
+  /* History followed by the block keeps every FIR window contiguous */
+  std::vector<float> buffer(channel->fir_history);
+  size_t taps = m_fir.size();
+  size_t kept = 0;
+
+  buffer.insert(buffer.end(), x.begin(), x.end());
+
+  for (size_t i = 0; i < x.size(); i++) {
+    bool keep = (channel->phase == 0);
+
+    channel->phase = (channel->phase + 1) % m_decimation;
+    if (!keep)
+      continue;
+
+    /* Only the outputs surviving the decimation are computed */
+    x[kept++] = taps ? dot(m_fir.data(), buffer.data() + i, taps) : x[i];
+  }
+  x.resize(kept);
+
+  if (taps > 1)
+    channel->fir_history.assign(buffer.end() - (taps - 1), buffer.end());
+}
+
+void DspPipeline::analyze(Channel *channel, const std::vector<float>& x,
+                          Features *features) {
+  double sum = 0;
+  size_t peak = 0;
+
+  features->peaks.clear();
+  features->spectrum.clear();
+  features->samples.clear();
+
+  if (x.empty()) {
+    features->mean = 0;
+    features->rms = 0;
+    features->min = 0;
+    features->max = 0;
+    features->peak_index = 0;
+    return;
+  }
+
+  features->min = x[0];
+  features->max = x[0];
+  for (size_t i = 0; i < x.size(); i++) {
+    sum += x[i];
+    features->min = std::min(features->min, x[i]);
+    features->max = std::max(features->max, x[i]);
+    if (fabsf(x[i]) > fabsf(x[peak]))
+      peak = i;
+  }
+
+  features->mean = sum / x.size();
+  features->rms = sqrt(dot(x.data(), x.data(), x.size()) / x.size());
+  features->peak_index = peak;
+
+  if (m_peaks) {
+    size_t last = 0;
+    bool found = false;
+
+    for (size_t i = 1; i + 1 < x.size(); i++) {
+      if (x[i] <= m_peak_threshold || x[i] < x[i - 1] || x[i] <= x[i + 1])
+        continue;
+      if (found && i - last < m_peak_distance)
+        continue;
+
+      features->peaks.push_back(i);
+      last = i;
+      found = true;
+    }
+  }
+
+  if (m_fft_size) {
+    std::vector<float>& history = channel->fft_history;
+
+    /* Slide the analysis window over the newest samples */
+    if (x.size() >= m_fft_size) {
+      history.assign(x.end() - m_fft_size, x.end());
+    } else {
+      history.erase(history.begin(), history.begin() + x.size());
+      history.insert(history.end(), x.begin(), x.end());
+    }
+    channel->fft_filled = std::min(channel->fft_filled + x.size(),
+                                   m_fft_size);
+
+    if (channel->fft_filled == m_fft_size)
+      spectrum(channel, &features->spectrum);
+  }
+
+  if (m_keep_samples)
+    features->samples = x;
+}
+
+void DspPipeline::spectrum(Channel *channel, std::vector<float> *out) {
+  const std::vector<float>& x = channel->fft_history;
+  size_t half = m_fft_size / 2;
+  std::vector<std::complex<float>> z(half);
+  float gain = 0;
+
+  /* Real FFT of size N through a complex FFT of size N/2 */
+  for (size_t k = 0; k < half; k++) {
+    z[k] = std::complex<float>(x[2 * k] * m_window[2 * k],
+                               x[2 * k + 1] * m_window[2 * k + 1]);
+  }
+  for (size_t i = 0; i < m_fft_size; i++)
+    gain += m_window[i];
+
+  fft(&z);
+
+  out->resize(half + 1);
+  for (size_t k = 0; k <= half; k++) {
+    std::complex<float> a = z[k % half];
+    std::complex<float> b = std::conj(z[(half - k) % half]);
+    std::complex<float> even = (a + b) * 0.5f;
+    std::complex<float> odd = (a - b) * std::complex<float>(0, -0.5f);
+    float scale = (k == 0 || k == half) ? 1 / gain : 2 / gain;
+
+    /* Amplitude of the sinusoid at bin k */
+    (*out)[k] = std::abs(even + m_twiddles[k] * odd) * scale;
+  }
+}
+
+void DspPipeline::fft(std::vector<std::complex<float>> *data) {
+  std::vector<std::complex<float>>& d = *data;
+  size_t n = d.size();
+
+  for (size_t i = 0; i < n; i++) {
+    size_t j = m_bit_reverse[i];
+
+    if (i < j)
+      std::swap(d[i], d[j]);
+  }
+
+  for (size_t len = 2; len <= n; len <<= 1) {
+    size_t step = 2 * n / len;
+
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t j = 0; j < len / 2; j++) {
+        std::complex<float> u = d[i + j];
+        std::complex<float> v = d[i + j + len / 2] * m_twiddles[j * step];
+
+        d[i + j] = u + v;
+        d[i + j + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+}  // namespace artik
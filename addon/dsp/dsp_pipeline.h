@@ -0,0 +1,107 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_DSP_DSP_PIPELINE_H_
+#define ADDON_DSP_DSP_PIPELINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <complex>
+#include <vector>
+
+namespace artik {
+
+/*
+ * Reduces blocks of interleaved samples to a few features per channel.
+ * Each channel goes through, in this order and when configured: an IIR
+ * filter, a moving average, an FIR filter and a decimation. Filter states
+ * carry over from one block to the next. The features are then computed on
+ * the resulting samples of the block.
+ */
+class DspPipeline {
+ public:
+  struct Features {
+    double mean;
+    double rms;
+    float min;
+    float max;
+    size_t peak_index;
+    std::vector<uint32_t> peaks;
+    std::vector<float> spectrum;
+    std::vector<float> samples;
+  };
+
+  DspPipeline();
+
+  /* 'a' is normalized so that a[0] == 1, returns false if a[0] is 0 */
+  bool set_iir(const std::vector<float>& b, const std::vector<float>& a);
+  void set_moving_average(size_t length);
+  void set_fir(const std::vector<float>& taps);
+  void set_decimation(size_t factor);
+  /* Local maxima above 'threshold' at least 'distance' samples apart */
+  void set_peaks(float threshold, size_t distance);
+  /* Magnitude spectrum of the last 'size' samples, a power of two */
+  bool set_fft(size_t size, bool hann);
+  void set_keep_samples(bool keep) { m_keep_samples = keep; }
+
+  void reset(size_t channels);
+
+  void process(const int32_t *in, size_t frames,
+               std::vector<Features> *out);
+
+  size_t channels() const { return m_channels.size(); }
+  size_t fft_size() const { return m_fft_size; }
+
+ private:
+  struct Channel {
+    std::vector<float> iir_state;
+    std::vector<float> average;
+    size_t average_pos;
+    double average_sum;
+    std::vector<float> fir_history;
+    size_t phase;
+    std::vector<float> fft_history;
+    size_t fft_filled;
+  };
+
+  void filter(Channel *channel, std::vector<float> *samples);
+  void analyze(Channel *channel, const std::vector<float>& samples,
+               Features *features);
+  void spectrum(Channel *channel, std::vector<float> *out);
+  void fft(std::vector<std::complex<float>> *data);
+
+  std::vector<float> m_iir_b;
+  std::vector<float> m_iir_a;
+  size_t m_average;
+  std::vector<float> m_fir;
+  size_t m_decimation;
+  bool m_peaks;
+  float m_peak_threshold;
+  size_t m_peak_distance;
+  size_t m_fft_size;
+  std::vector<float> m_window;
+  std::vector<std::complex<float>> m_twiddles;
+  std::vector<size_t> m_bit_reverse;
+  bool m_keep_samples;
+  std::vector<Channel> m_channels;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_DSP_DSP_PIPELINE_H_
@@ -18,10 +18,19 @@
 
 #include "gpio/gpio.h"
 
+#include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <nan.h>
+#include <utils.h>
 
 #include <artik_log.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #define MAX_ARG_STR_LEN 32
 
 namespace artik {
@@ -42,35 +51,366 @@ using v8::Context;
 
 Persistent<Function> GpioWrapper::constructor;
 
+/*
+ * Edge capture: the GLib thread stamps every edge with CLOCK_MONOTONIC and
+ * stores it in a fixed size ring. JS gets the edges in batches, as pairs of
+ * (timestamp in ns, value) in a Float64Array, every 'interval' ms or as
+ * soon as 'count' edges are pending. Edges arriving while the ring is full
+ * are dropped and counted as overruns.
+ */
+struct GpioCapture {
+  uv_async_t async;
+  uv_timer_t timer;
+  int handles;
+  std::mutex lock;
+  std::vector<double> ring;
+  size_t capacity;
+  size_t head;
+  size_t count;
+  size_t threshold;
+  bool notified;
+  uint64_t edges;
+  uint64_t overruns;
+  uint64_t dropped;
+  Nan::Callback* callback;
+
+  void record(int val);
+  void flush();
+};
+
+static double monotonic_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<double>(ts.tv_sec) * 1e9 + ts.tv_nsec;
+}
+
+void GpioCapture::record(int val) {
+  double now = monotonic_ns();
+  bool notify = false;
+
+  std::lock_guard<std::mutex> l(lock);
+
+  edges++;
+  if (count == capacity) {
+    overruns++;
+    dropped++;
+  } else {
+    size_t i = ((head + count) % capacity) * 2;
+
+    ring[i] = now;
+    ring[i + 1] = val ? 1 : 0;
+    count++;
+  }
+
+  if (threshold && count >= threshold && !notified) {
+    notified = true;
+    notify = true;
+  }
+
+  if (notify)
+    uv_async_send(&async);
+}
+
+void GpioCapture::flush() {
+  Nan::HandleScope scope;
+  std::vector<double> events;
+  uint64_t lost;
+
+  {
+    std::lock_guard<std::mutex> l(lock);
+
+    events.reserve(count * 2);
+    for (size_t n = 0; n < count; n++) {
+      size_t i = ((head + n) % capacity) * 2;
+
+      events.push_back(ring[i]);
+      events.push_back(ring[i + 1]);
+    }
+    head = (head + count) % capacity;
+    count = 0;
+    lost = dropped;
+    dropped = 0;
+    notified = false;
+  }
+
+  if (events.empty() && !lost)
+    return;
+
+  Isolate* isolate = Isolate::GetCurrent();
+  size_t size = events.size() * sizeof(double);
+  Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, size);
+
+  memcpy(buffer->GetContents().Data(), events.data(), size);
+
+  Local<Value> argv[2] = {
+    v8::Float64Array::New(buffer, 0, events.size()),
+    Nan::New<Number>(static_cast<double>(lost))
+  };
+  callback->Call(2, argv);
+}
+
+static void gpio_capture_async_cb(uv_async_t* handle) {
+  reinterpret_cast<GpioCapture*>(handle->data)->flush();
+}
+
+static void gpio_capture_timer_cb(uv_timer_t* handle) {
+  reinterpret_cast<GpioCapture*>(handle->data)->flush();
+}
+
+static void gpio_capture_close_cb(uv_handle_t* handle) {
+  GpioCapture* capture = reinterpret_cast<GpioCapture*>(handle->data);
+
+  if (--capture->handles > 0)
+    return;
+
+  delete capture->callback;
+  delete capture;
+}
+
+/*
+ * Pulse counter: edges are debounced, counted and timed on the GLib thread,
+ * JS only reads snapshots of the counters. The period statistics cover the
+ * window since the previous snapshot taken with a reset. Periods are
+ * measured between edges of the same direction, so that counting both
+ * edges does not halve them.
+ */
+struct GpioCounter {
+  uv_timer_t timer;
+  std::mutex lock;
+  double debounce;
+  int filter;
+  double count;
+  double rejected;
+  double last_edge;
+  double last_pulse[2];
+  double window_start;
+  double window_pulses;
+  double period_min;
+  double period_max;
+  double period_sum;
+  double periods;
+  double hist_min;
+  double hist_width;
+  std::vector<uint32_t> histogram;
+  Nan::Callback* callback;
+
+  void record(int val);
+  void reset_window(double now);
+  Local<Object> snapshot(bool reset);
+};
+
+void GpioCounter::record(int val) {
+  double now = monotonic_ns();
+
+  std::lock_guard<std::mutex> l(lock);
+
+  if (last_edge && now - last_edge < debounce) {
+    rejected++;
+    return;
+  }
+
+  last_edge = now;
+  if (filter >= 0 && (val ? 1 : 0) != filter)
+    return;
+
+  count++;
+  window_pulses++;
+
+  double& last = last_pulse[val ? 1 : 0];
+
+  if (last) {
+    double period = (now - last) / 1e3;
+
+    if (!periods || period < period_min)
+      period_min = period;
+    if (period > period_max)
+      period_max = period;
+    period_sum += period;
+    periods++;
+
+    if (!histogram.empty()) {
+      double bin = (period - hist_min) / hist_width;
+      size_t last_bin = histogram.size() - 1;
+
+      histogram[bin < 0 ? 0 : std::min(static_cast<size_t>(bin), last_bin)]++;
+    }
+  }
+
+  last = now;
+}
+
+void GpioCounter::reset_window(double now) {
+  window_start = now;
+  window_pulses = 0;
+  period_min = 0;
+  period_max = 0;
+  period_sum = 0;
+  periods = 0;
+  std::fill(histogram.begin(), histogram.end(), 0);
+}
+
+Local<Object> GpioCounter::snapshot(bool reset) {
+  Isolate* isolate = Isolate::GetCurrent();
+  Local<Object> stats = Object::New(isolate);
+  double now = monotonic_ns();
+
+  std::lock_guard<std::mutex> l(lock);
+  double average = periods ? period_sum / periods : 0;
+
+  stats->Set(String::NewFromUtf8(isolate, "count"),
+      Number::New(isolate, count));
+  stats->Set(String::NewFromUtf8(isolate, "rejected"),
+      Number::New(isolate, rejected));
+  stats->Set(String::NewFromUtf8(isolate, "pulses"),
+      Number::New(isolate, window_pulses));
+  stats->Set(String::NewFromUtf8(isolate, "elapsed"),
+      Number::New(isolate, (now - window_start) / 1e6));
+  stats->Set(String::NewFromUtf8(isolate, "frequency"),
+      Number::New(isolate, average ? 1e6 / average : 0));
+  stats->Set(String::NewFromUtf8(isolate, "period_min"),
+      Number::New(isolate, period_min));
+  stats->Set(String::NewFromUtf8(isolate, "period_max"),
+      Number::New(isolate, period_max));
+  stats->Set(String::NewFromUtf8(isolate, "period_avg"),
+      Number::New(isolate, average));
+
+  if (!histogram.empty()) {
+    Local<v8::Array> bins = v8::Array::New(isolate, histogram.size());
+
+    for (size_t i = 0; i < histogram.size(); i++)
+      bins->Set(i, Number::New(isolate, histogram[i]));
+    stats->Set(String::NewFromUtf8(isolate, "histogram"), bins);
+  }
+
+  if (reset)
+    reset_window(now);
+
+  return stats;
+}
+
+static void gpio_counter_timer_cb(uv_timer_t* handle) {
+  GpioCounter* counter = reinterpret_cast<GpioCounter*>(handle->data);
+  Nan::HandleScope scope;
+  Local<Value> argv[1] = { counter->snapshot(true) };
+
+  counter->callback->Call(1, argv);
+}
+
+static void gpio_counter_close_cb(uv_handle_t* handle) {
+  GpioCounter* counter = reinterpret_cast<GpioCounter*>(handle->data);
+
+  delete counter->callback;
+  delete counter;
+}
+
+static void gpio_edge_callback(void* user_data, int val) {
+  reinterpret_cast<GpioWrapper*>(user_data)->on_edge(val);
+}
+
 static void gpio_change_callback(void* user_data, int val) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   GpioWrapper* wrap = reinterpret_cast<GpioWrapper*>(user_data);
 
   log_dbg("");
 
-  if (!wrap->getChangeCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, val]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, val ? "1" : "0")),
-  };
+    if (!wrap->getChangeCb())
+      return;
+
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, val ? "1" : "0")),
+    };
 
-  Local<Function>::New(isolate, *wrap->getChangeCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+    Local<Function>::New(isolate, *wrap->getChangeCb())->Call(
+        isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 }
 
 GpioWrapper::GpioWrapper(artik_gpio_id id, char* name, artik_gpio_dir_t dir,
     artik_gpio_edge_t edge, int initial_value) {
-  m_gpio = new Gpio(id, name, dir, edge, initial_value);
+  {
+    GlibLoop::SdkLock lock;
+    m_gpio = new Gpio(id, name, dir, edge, initial_value);
+  }
+  m_edge = edge;
   m_change_cb = NULL;
+  m_capture = NULL;
+  m_counter = NULL;
   m_loop = GlibLoop::Instance();
-  m_loop->attach();
+  m_loop->attach(true);
 }
 
 GpioWrapper::~GpioWrapper() {
-  m_loop->detach();
-  delete m_gpio;
+  finish_capture();
+  finish_counter();
+  {
+    GlibLoop::SdkLock lock;
+    delete m_gpio;
+  }
+  m_loop->cancel(this);
+  m_loop->detach(true);
+}
+
+void GpioWrapper::on_edge(int val) {
+  std::lock_guard<std::mutex> lock(m_edge_lock);
+
+  if (m_capture)
+    m_capture->record(val);
+  else if (m_counter)
+    m_counter->record(val);
+}
+
+void GpioWrapper::finish_capture() {
+  GpioCapture* capture;
+
+  {
+    std::lock_guard<std::mutex> lock(m_edge_lock);
+    capture = m_capture;
+    m_capture = NULL;
+  }
+
+  if (!capture)
+    return;
+
+  {
+    GlibLoop::SdkLock lock;
+    m_gpio->unset_change_callback();
+  }
+
+  /* Hand over the last edges before tearing down */
+  capture->flush();
+
+  uv_timer_stop(&capture->timer);
+  uv_close(reinterpret_cast<uv_handle_t*>(&capture->async),
+      gpio_capture_close_cb);
+  uv_close(reinterpret_cast<uv_handle_t*>(&capture->timer),
+      gpio_capture_close_cb);
+  Unref();
+}
+
+void GpioWrapper::finish_counter() {
+  GpioCounter* counter;
+
+  {
+    std::lock_guard<std::mutex> lock(m_edge_lock);
+    counter = m_counter;
+    m_counter = NULL;
+  }
+
+  if (!counter)
+    return;
+
+  {
+    GlibLoop::SdkLock lock;
+    m_gpio->unset_change_callback();
+  }
+  uv_timer_stop(&counter->timer);
+  uv_close(reinterpret_cast<uv_handle_t*>(&counter->timer),
+      gpio_counter_close_cb);
+  Unref();
 }
 
 void GpioWrapper::Init(Local<Object> exports) {
@@ -89,6 +429,14 @@ void GpioWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(tpl, "get_name", get_name);
   NODE_SET_PROTOTYPE_METHOD(tpl, "get_direction", get_direction);
   NODE_SET_PROTOTYPE_METHOD(tpl, "get_id", get_id);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "enable_fast_io", enable_fast_io);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "disable_fast_io", disable_fast_io);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "start_capture", start_capture);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stop_capture", stop_capture);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get_capture_stats", get_capture_stats);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "start_counter", start_counter);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stop_counter", stop_counter);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "read_counter", read_counter);
 
   constructor.Reset(isolate, tpl->GetFunction());
   exports->Set(String::NewFromUtf8(isolate, "gpio"),
@@ -166,13 +514,18 @@ void GpioWrapper::request(const FunctionCallbackInfo<Value>& args) {
 
   log_dbg("");
 
-  ret = obj->request();
+  {
+    GlibLoop::SdkLock lock;
+    ret = obj->request();
+  }
 
   /* If a callback is provided, use it for change notification */
   if ((ret == S_OK) && args[0]->IsFunction() &&
       (obj->get_direction() == GPIO_IN)) {
     wrap->m_change_cb = new v8::Persistent<v8::Function>();
     wrap->m_change_cb->Reset(isolate, Local<Function>::Cast(args[0]));
+
+    GlibLoop::SdkLock lock;
     obj->set_change_callback(gpio_change_callback,
         reinterpret_cast<void*>(wrap));
   }
@@ -188,26 +541,44 @@ void GpioWrapper::release(const FunctionCallbackInfo<Value>& args) {
 
   log_dbg("");
 
+  wrap->finish_capture();
+  wrap->finish_counter();
+
+  {
+    GlibLoop::SdkLock lock;
+
+    if (wrap->m_change_cb)
+      obj->unset_change_callback();
+    wrap->m_fast.reset();
+    ret = obj->release();
+  }
+
   /* If a callback was set, release it */
   if (wrap->m_change_cb) {
-    obj->unset_change_callback();
     delete wrap->m_change_cb;
     wrap->m_change_cb = NULL;
   }
 
-  ret = obj->release();
-
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
 
 void GpioWrapper::read(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
-  Gpio* obj = ObjectWrap::Unwrap<GpioWrapper>(args.Holder())->getObj();
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+  Gpio* obj = wrap->getObj();
   int val;
 
   log_dbg("");
 
-  val = obj->read();
+  if (wrap->m_fast) {
+    artik_error ret = wrap->m_fast->read_int(&val);
+
+    if (ret != S_OK)
+      val = ret;
+  } else {
+    GlibLoop::SdkLock lock;
+    val = obj->read();
+  }
 
   if (val < 0) {
     isolate->ThrowException(Exception::TypeError(
@@ -229,8 +600,15 @@ void GpioWrapper::write(const FunctionCallbackInfo<Value>& args) {
       return;
   }
 
-  Gpio* obj = ObjectWrap::Unwrap<GpioWrapper>(args.Holder())->getObj();
-  artik_error ret = obj->write(args[0]->NumberValue());
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+  artik_error ret;
+
+  if (wrap->m_fast) {
+    ret = wrap->m_fast->write_int(args[0]->NumberValue() ? 1 : 0);
+  } else {
+    GlibLoop::SdkLock lock;
+    ret = wrap->getObj()->write(args[0]->NumberValue());
+  }
 
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
@@ -263,4 +641,295 @@ void GpioWrapper::get_id(const FunctionCallbackInfo<Value>& args) {
   args.GetReturnValue().Set(Number::New(isolate, obj->get_id()));
 }
 
+void GpioWrapper::start_capture(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+  Gpio* obj = wrap->getObj();
+
+  log_dbg("");
+
+  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsFunction()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  auto interval = js_object_attribute_to_cpp<uint32_t>(args[0], "interval");
+  auto count = js_object_attribute_to_cpp<uint32_t>(args[0], "count");
+  auto ring_size = js_object_attribute_to_cpp<uint32_t>(args[0], "ring_size");
+  uint32_t capacity = ring_size ? ring_size.value() : 4096;
+  uint32_t period = interval ? interval.value() : 50;
+  uint32_t threshold = count ? count.value() : 1024;
+
+  if (capacity == 0 || (period == 0 && threshold == 0) ||
+      threshold > capacity) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Invalid capture settings")));
+    return;
+  }
+
+  if (wrap->m_capture || wrap->m_counter || wrap->m_change_cb) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "GPIO is already notifying changes")));
+    return;
+  }
+
+  GpioCapture* capture = new GpioCapture();
+
+  capture->handles = 2;
+  capture->ring.resize(capacity * 2);
+  capture->capacity = capacity;
+  capture->head = 0;
+  capture->count = 0;
+  capture->threshold = threshold;
+  capture->notified = false;
+  capture->edges = 0;
+  capture->overruns = 0;
+  capture->dropped = 0;
+  capture->callback = new Nan::Callback(args[1].As<Function>());
+
+  capture->async.data = capture;
+  uv_async_init(uv_default_loop(), &capture->async, gpio_capture_async_cb);
+  capture->timer.data = capture;
+  uv_timer_init(uv_default_loop(), &capture->timer);
+
+  {
+    std::lock_guard<std::mutex> lock(wrap->m_edge_lock);
+    wrap->m_capture = capture;
+  }
+
+  artik_error ret;
+
+  {
+    GlibLoop::SdkLock lock;
+    ret = obj->set_change_callback(gpio_edge_callback,
+        reinterpret_cast<void*>(wrap));
+  }
+  if (ret != S_OK) {
+    {
+      std::lock_guard<std::mutex> lock(wrap->m_edge_lock);
+      wrap->m_capture = NULL;
+    }
+    uv_close(reinterpret_cast<uv_handle_t*>(&capture->async),
+        gpio_capture_close_cb);
+    uv_close(reinterpret_cast<uv_handle_t*>(&capture->timer),
+        gpio_capture_close_cb);
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, error_msg(ret))));
+    return;
+  }
+
+  if (period)
+    uv_timer_start(&capture->timer, gpio_capture_timer_cb, period, period);
+
+  /* Keep the wrapper alive for as long as the capture runs */
+  wrap->Ref();
+}
+
+void GpioWrapper::stop_capture(const FunctionCallbackInfo<Value>& args) {
+  log_dbg("");
+
+  ObjectWrap::Unwrap<GpioWrapper>(args.Holder())->finish_capture();
+}
+
+void GpioWrapper::get_capture_stats(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+  Local<Object> stats = Object::New(isolate);
+  std::lock_guard<std::mutex> lock(wrap->m_edge_lock);
+  GpioCapture* capture = wrap->m_capture;
+
+  log_dbg("");
+
+  if (capture) {
+    std::lock_guard<std::mutex> l(capture->lock);
+    stats->Set(String::NewFromUtf8(isolate, "edges"),
+        Number::New(isolate, capture->edges));
+    stats->Set(String::NewFromUtf8(isolate, "overruns"),
+        Number::New(isolate, capture->overruns));
+    stats->Set(String::NewFromUtf8(isolate, "pending"),
+        Number::New(isolate, capture->count));
+  }
+
+  args.GetReturnValue().Set(stats);
+}
+
+void GpioWrapper::start_counter(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+  Gpio* obj = wrap->getObj();
+
+  log_dbg("");
+
+  if (args.Length() < 1 || args.Length() > 2 || !args[0]->IsObject() ||
+      (args.Length() == 2 && !args[1]->IsFunction())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  auto debounce = js_object_attribute_to_cpp<uint32_t>(args[0], "debounce");
+  auto edge = js_object_attribute_to_cpp<std::string>(args[0], "edge");
+  auto interval = js_object_attribute_to_cpp<uint32_t>(args[0], "interval");
+  auto histogram = js_object_attribute_to_cpp<Local<Value>>(args[0],
+      "histogram");
+  uint32_t period = interval ? interval.value() : 0;
+  int filter = wrap->m_edge == GPIO_EDGE_FALLING ? 0 :
+      wrap->m_edge == GPIO_EDGE_BOTH ? -1 : 1;
+  double hist_min = 0;
+  double hist_max = 0;
+  uint32_t bins = 0;
+
+  if (edge) {
+    if (edge.value() == "rising") {
+      filter = 1;
+    } else if (edge.value() == "falling") {
+      filter = 0;
+    } else if (edge.value() == "both") {
+      filter = -1;
+    } else {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+      return;
+    }
+  }
+
+  if (histogram) {
+    auto min = js_object_attribute_to_cpp<double>(histogram.value(), "min");
+    auto max = js_object_attribute_to_cpp<double>(histogram.value(), "max");
+    auto count = js_object_attribute_to_cpp<uint32_t>(histogram.value(),
+        "bins");
+
+    if (!max || !count || count.value() == 0 ||
+        max.value() <= (min ? min.value() : 0)) {
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Invalid histogram settings")));
+      return;
+    }
+
+    hist_min = min ? min.value() : 0;
+    hist_max = max.value();
+    bins = count.value();
+  }
+
+  if (wrap->m_capture || wrap->m_counter || wrap->m_change_cb) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "GPIO is already notifying changes")));
+    return;
+  }
+
+  GpioCounter* counter = new GpioCounter();
+
+  counter->debounce = debounce ? debounce.value() * 1e3 : 0;
+  counter->filter = filter;
+  counter->count = 0;
+  counter->rejected = 0;
+  counter->last_edge = 0;
+  counter->last_pulse[0] = 0;
+  counter->last_pulse[1] = 0;
+  counter->histogram.resize(bins);
+  counter->hist_min = hist_min;
+  counter->hist_width = bins ? (hist_max - hist_min) / bins : 0;
+  counter->reset_window(monotonic_ns());
+  counter->callback = (args.Length() == 2) ?
+      new Nan::Callback(args[1].As<Function>()) : NULL;
+
+  counter->timer.data = counter;
+  uv_timer_init(uv_default_loop(), &counter->timer);
+
+  {
+    std::lock_guard<std::mutex> lock(wrap->m_edge_lock);
+    wrap->m_counter = counter;
+  }
+
+  artik_error ret;
+
+  {
+    GlibLoop::SdkLock lock;
+    ret = obj->set_change_callback(gpio_edge_callback,
+        reinterpret_cast<void*>(wrap));
+  }
+  if (ret != S_OK) {
+    {
+      std::lock_guard<std::mutex> lock(wrap->m_edge_lock);
+      wrap->m_counter = NULL;
+    }
+    uv_close(reinterpret_cast<uv_handle_t*>(&counter->timer),
+        gpio_counter_close_cb);
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, error_msg(ret))));
+    return;
+  }
+
+  /* Snapshots are only pushed to JS when a callback is given */
+  if (counter->callback && period)
+    uv_timer_start(&counter->timer, gpio_counter_timer_cb, period, period);
+
+  /* Keep the wrapper alive for as long as the counter runs */
+  wrap->Ref();
+}
+
+void GpioWrapper::stop_counter(const FunctionCallbackInfo<Value>& args) {
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+
+  log_dbg("");
+
+  if (wrap->m_counter)
+    args.GetReturnValue().Set(wrap->m_counter->snapshot(false));
+
+  wrap->finish_counter();
+}
+
+void GpioWrapper::read_counter(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+
+  log_dbg("");
+
+  if (!wrap->m_counter) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Counter is not started")));
+    return;
+  }
+
+  bool reset = args.Length() > 0 && args[0]->BooleanValue();
+
+  args.GetReturnValue().Set(wrap->m_counter->snapshot(reset));
+}
+
+void GpioWrapper::enable_fast_io(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioWrapper* wrap = ObjectWrap::Unwrap<GpioWrapper>(args.Holder());
+
+  log_dbg("");
+
+  if (args.Length() > 1 || (args.Length() == 1 && !args[0]->IsString())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  std::string root = args.Length() ? *v8::String::Utf8Value(args[0]) : "";
+  std::string path = sysfs_path(root, "class/gpio/gpio" +
+      std::to_string(wrap->getObj()->get_id()) + "/value");
+  std::unique_ptr<SysfsFile> file(new SysfsFile());
+  int err = file->open(path, O_RDWR);
+
+  if (err < 0) {
+    std::string msg = "Cannot open " + path + ": " + strerror(-err);
+
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, msg.c_str())));
+    return;
+  }
+
+  wrap->m_fast = std::move(file);
+}
+
+void GpioWrapper::disable_fast_io(const FunctionCallbackInfo<Value>& args) {
+  log_dbg("");
+
+  ObjectWrap::Unwrap<GpioWrapper>(args.Holder())->m_fast.reset();
+}
+
 }  // namespace artik
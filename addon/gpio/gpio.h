@@ -27,8 +27,16 @@
 
 #include <loop.h>
 
+#include <memory>
+#include <mutex>
+
+#include "base/sysfs_file.h"
+
 namespace artik {
 
+struct GpioCapture;
+struct GpioCounter;
+
 class GpioWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object> exports);
@@ -36,6 +44,8 @@ class GpioWrapper : public node::ObjectWrap {
   Gpio* getObj() { return m_gpio; }
   v8::Persistent<v8::Function>* getChangeCb() { return m_change_cb; }
 
+  void on_edge(int val);
+
  private:
   explicit GpioWrapper(artik_gpio_id, char*, artik_gpio_dir_t,
       artik_gpio_edge_t, int);
@@ -51,10 +61,30 @@ class GpioWrapper : public node::ObjectWrap {
   static void get_name(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void get_direction(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void get_id(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void start_capture(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stop_capture(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_capture_stats(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void start_counter(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stop_counter(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void read_counter(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void enable_fast_io(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void disable_fast_io(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void finish_capture();
+  void finish_counter();
 
   Gpio* m_gpio;
+  /* As requested, the default of what the counter counts */
+  artik_gpio_edge_t m_edge;
   v8::Persistent<v8::Function>* m_change_cb;
   GlibLoop* m_loop;
+  /* Guards m_capture and m_counter against the GLib thread */
+  std::mutex m_edge_lock;
+  GpioCapture* m_capture;
+  GpioCounter* m_counter;
+  std::unique_ptr<SysfsFile> m_fast;
 };
 
 }  // namespace artik
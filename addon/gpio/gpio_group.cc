@@ -0,0 +1,339 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "gpio/gpio_group.h"
+
+#include <string.h>
+#include <nan.h>
+
+#include <artik_log.h>
+
+#include <string>
+#include <vector>
+
+#define MAX_ARG_STR_LEN 32
+#define MAX_MASK_PINS 32
+
+namespace artik {
+
+using v8::Exception;
+using v8::Function;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Isolate;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::Persistent;
+using v8::String;
+using v8::Value;
+using v8::Context;
+
+Persistent<Function> GpioGroupWrapper::constructor;
+
+GpioGroupWrapper::GpioGroupWrapper(const std::vector<artik_gpio_id>& ids,
+    const char* name, artik_gpio_dir_t dir) {
+  for (size_t i = 0; i < ids.size(); i++) {
+    std::string pin = std::string(name) + "-" + std::to_string(i);
+
+    m_gpios.push_back(new Gpio(ids[i], &pin[0], dir, GPIO_EDGE_NONE, 0));
+  }
+  m_values.assign(ids.size(), -1);
+  m_requested = false;
+}
+
+GpioGroupWrapper::~GpioGroupWrapper() {
+  release_all();
+  for (auto gpio : m_gpios)
+    delete gpio;
+}
+
+void GpioGroupWrapper::release_all() {
+  if (!m_requested)
+    return;
+
+  for (auto gpio : m_gpios)
+    gpio->release();
+  m_values.assign(m_gpios.size(), -1);
+  m_requested = false;
+}
+
+void GpioGroupWrapper::Init(Local<Object> exports) {
+  Isolate* isolate = exports->GetIsolate();
+
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(String::NewFromUtf8(isolate, "gpio_group"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototypes
+  NODE_SET_PROTOTYPE_METHOD(tpl, "request", request);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "release", release);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "read", read);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "write", write);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get_count", get_count);
+
+  constructor.Reset(isolate, tpl->GetFunction());
+  exports->Set(String::NewFromUtf8(isolate, "gpio_group"),
+               tpl->GetFunction());
+}
+
+void GpioGroupWrapper::New(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  log_dbg("");
+
+  if (args.IsConstructCall()) {
+    if (!args[0]->IsArray() ||
+        !args[1]->IsString() ||
+        !args[2]->IsString()) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+        return;
+    }
+
+    Local<v8::Array> array = Local<v8::Array>::Cast(args[0]);
+    std::vector<artik_gpio_id> ids;
+
+    for (unsigned int i = 0; i < array->Length(); i++) {
+      Local<Value> id = array->Get(i);
+
+      if (!id->IsNumber()) {
+        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+            isolate, "Wrong arguments")));
+        return;
+      }
+      ids.push_back(id->NumberValue());
+    }
+
+    if (ids.empty()) {
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "The group needs at least one GPIO")));
+      return;
+    }
+
+    v8::String::Utf8Value param1(args[1]->ToString());
+    char* name = *param1;
+
+    artik_gpio_dir_t dir = artik_gpio_dir_t::GPIO_DIR_INVALID;
+    v8::String::Utf8Value param2(args[2]->ToString());
+    char* dir_str = *param2;
+
+    if (!strncmp(dir_str, "out", MAX_ARG_STR_LEN)) {
+      dir = GPIO_OUT;
+    } else if (!strncmp(dir_str, "in", MAX_ARG_STR_LEN)) {
+      dir = GPIO_IN;
+    } else {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+      return;
+    }
+
+    GpioGroupWrapper* obj = new GpioGroupWrapper(ids, name, dir);
+    obj->Wrap(args.This());
+
+    args.GetReturnValue().Set(args.This());
+  } else {
+    const int argc = 3;
+    Local<Value> argv[argc] = { args[0], args[1], args[2] };
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Function> cons = Local<Function>::New(isolate, constructor);
+    args.GetReturnValue().Set(
+        cons->NewInstance(context, argc, argv).ToLocalChecked());
+  }
+}
+
+void GpioGroupWrapper::request(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioGroupWrapper* wrap = ObjectWrap::Unwrap<GpioGroupWrapper>(args.Holder());
+  artik_error ret = S_OK;
+
+  log_dbg("");
+
+  if (wrap->m_requested) {
+    args.GetReturnValue().Set(Number::New(isolate, E_BUSY));
+    return;
+  }
+
+  /* All or nothing: give back the pins already requested on failure */
+  for (size_t i = 0; i < wrap->m_gpios.size(); i++) {
+    ret = wrap->m_gpios[i]->request();
+    if (ret != S_OK) {
+      while (i-- > 0)
+        wrap->m_gpios[i]->release();
+      break;
+    }
+  }
+
+  wrap->m_requested = (ret == S_OK);
+  args.GetReturnValue().Set(Number::New(isolate, ret));
+}
+
+void GpioGroupWrapper::release(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioGroupWrapper* wrap = ObjectWrap::Unwrap<GpioGroupWrapper>(args.Holder());
+
+  log_dbg("");
+
+  wrap->release_all();
+
+  args.GetReturnValue().Set(Number::New(isolate, S_OK));
+}
+
+void GpioGroupWrapper::read(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioGroupWrapper* wrap = ObjectWrap::Unwrap<GpioGroupWrapper>(args.Holder());
+  std::vector<Gpio*>& gpios = wrap->m_gpios;
+  bool to_array = args.Length() > 0 && args[0]->IsUint8Array();
+
+  log_dbg("");
+
+  if (args.Length() > 0 && !to_array) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (!to_array && gpios.size() > MAX_MASK_PINS) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Too many GPIOs for a bitmask, read into a Uint8Array")));
+    return;
+  }
+
+  Nan::TypedArrayContents<uint8_t> out(args[0]);
+
+  if (to_array && out.length() < gpios.size()) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Array is smaller than the group")));
+    return;
+  }
+
+  uint32_t mask = 0;
+
+  for (size_t i = 0; i < gpios.size(); i++) {
+    int val = gpios[i]->read();
+
+    if (val < 0) {
+      isolate->ThrowException(Exception::TypeError(
+        String::NewFromUtf8(isolate, error_msg(val))));
+      return;
+    }
+
+    if (to_array)
+      (*out)[i] = val ? 1 : 0;
+    else if (val)
+      mask |= 1u << i;
+  }
+
+  if (to_array)
+    args.GetReturnValue().Set(args[0]);
+  else
+    args.GetReturnValue().Set(Number::New(isolate, mask));
+}
+
+void GpioGroupWrapper::write(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioGroupWrapper* wrap = ObjectWrap::Unwrap<GpioGroupWrapper>(args.Holder());
+  std::vector<Gpio*>& gpios = wrap->m_gpios;
+  std::vector<int> values(gpios.size());
+  uint32_t mask = 0xffffffff;
+
+  log_dbg("");
+
+  if (args.Length() < 1 || args.Length() > 2 ||
+      (args.Length() == 2 && !args[1]->IsUint32())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (args.Length() == 2) {
+    if (gpios.size() > MAX_MASK_PINS) {
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Too many GPIOs for a bitmask")));
+      return;
+    }
+    mask = args[1]->Uint32Value();
+  }
+
+  /* Gather the new state first so that the pins are then set back to back */
+  if (args[0]->IsNumber()) {
+    if (gpios.size() > MAX_MASK_PINS) {
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Too many GPIOs for a bitmask, write a Uint8Array")));
+      return;
+    }
+
+    uint32_t bits = args[0]->Uint32Value();
+    for (size_t i = 0; i < gpios.size(); i++)
+      values[i] = (bits >> i) & 1;
+  } else if (args[0]->IsUint8Array()) {
+    Nan::TypedArrayContents<uint8_t> in(args[0]);
+
+    if (in.length() < gpios.size()) {
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Array is smaller than the group")));
+      return;
+    }
+
+    for (size_t i = 0; i < gpios.size(); i++)
+      values[i] = (*in)[i] ? 1 : 0;
+  } else if (args[0]->IsArray()) {
+    Local<v8::Array> in = Local<v8::Array>::Cast(args[0]);
+
+    if (in->Length() < gpios.size()) {
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Array is smaller than the group")));
+      return;
+    }
+
+    for (size_t i = 0; i < gpios.size(); i++)
+      values[i] = in->Get(i)->BooleanValue() ? 1 : 0;
+  } else {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+    return;
+  }
+
+  /* Only touch the pins whose level actually changes */
+  for (size_t i = 0; i < gpios.size(); i++) {
+    if (i < MAX_MASK_PINS && !((mask >> i) & 1))
+      continue;
+    if (wrap->m_values[i] == values[i])
+      continue;
+
+    artik_error ret = gpios[i]->write(values[i]);
+    if (ret != S_OK) {
+      wrap->m_values[i] = -1;
+      args.GetReturnValue().Set(Number::New(isolate, ret));
+      return;
+    }
+    wrap->m_values[i] = values[i];
+  }
+
+  args.GetReturnValue().Set(Number::New(isolate, S_OK));
+}
+
+void GpioGroupWrapper::get_count(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  GpioGroupWrapper* wrap = ObjectWrap::Unwrap<GpioGroupWrapper>(args.Holder());
+
+  args.GetReturnValue().Set(Number::New(isolate, wrap->m_gpios.size()));
+}
+
+}  // namespace artik
@@ -0,0 +1,59 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_GPIO_GPIO_GROUP_H_
+#define ADDON_GPIO_GPIO_GROUP_H_
+
+#include <node.h>
+#include <node_object_wrap.h>
+
+#include <artik_gpio.hh>
+
+#include <vector>
+
+namespace artik {
+
+class GpioGroupWrapper : public node::ObjectWrap {
+ public:
+  static void Init(v8::Local<v8::Object> exports);
+
+ private:
+  GpioGroupWrapper(const std::vector<artik_gpio_id>& ids, const char* name,
+      artik_gpio_dir_t dir);
+  ~GpioGroupWrapper();
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static v8::Persistent<v8::Function> constructor;
+
+  static void request(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void release(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void read(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void write(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_count(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void release_all();
+
+  std::vector<Gpio*> m_gpios;
+  /* Last value written to each pin, -1 when unknown */
+  std::vector<int> m_values;
+  bool m_requested;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_GPIO_GPIO_GROUP_H_
@@ -0,0 +1,83 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "http/header_arena.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace artik {
+
+HttpHeaderArena::HttpHeaderArena(const std::vector<std::string>& pairs) {
+  size_t count = pairs.size() / 2;
+  size_t strings = 0;
+
+  /* SDK name and value, as truncated so far, then the libcurl line */
+  for (size_t i = 0; i < count * 2; i += 2) {
+    size_t name = std::min<size_t>(pairs[i].size(), MAX_HEADER_SIZE);
+    size_t data = std::min<size_t>(pairs[i + 1].size(), MAX_HEADER_SIZE);
+
+    strings += name + 1 + data + 1;
+    strings += pairs[i].size() + 2 + pairs[i + 1].size() + 1;
+  }
+
+  size_t fields_size = count * sizeof(artik_http_header_field);
+  size_t list_size = count * sizeof(struct curl_slist);
+
+  m_arena.reset(new char[fields_size + list_size + strings]);
+
+  artik_http_header_field* fields =
+      reinterpret_cast<artik_http_header_field*>(m_arena.get());
+  struct curl_slist* list =
+      reinterpret_cast<struct curl_slist*>(m_arena.get() + fields_size);
+  char* p = m_arena.get() + fields_size + list_size;
+
+  for (size_t i = 0; i < count; i++) {
+    const std::string& name = pairs[i * 2];
+    const std::string& data = pairs[i * 2 + 1];
+    size_t name_len = std::min<size_t>(name.size(), MAX_HEADER_SIZE);
+    size_t data_len = std::min<size_t>(data.size(), MAX_HEADER_SIZE);
+
+    fields[i].name = p;
+    memcpy(p, name.data(), name_len);
+    p[name_len] = '\0';
+    p += name_len + 1;
+
+    fields[i].data = p;
+    memcpy(p, data.data(), data_len);
+    p[data_len] = '\0';
+    p += data_len + 1;
+
+    list[i].data = p;
+    list[i].next = i + 1 < count ? &list[i + 1] : NULL;
+    memcpy(p, name.data(), name.size());
+    p += name.size();
+    memcpy(p, ": ", 2);
+    p += 2;
+    memcpy(p, data.data(), data.size());
+    p += data.size();
+    *p++ = '\0';
+  }
+
+  m_headers.fields = fields;
+  m_headers.num_fields = count;
+  m_list = list;
+}
+
+}  // namespace artik
@@ -0,0 +1,62 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_HTTP_HEADER_ARENA_H_
+#define ADDON_HTTP_HEADER_ARENA_H_
+
+#include <curl/curl.h>
+#include <artik_http.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace artik {
+
+/*
+ * Request headers marshaled once into a single allocation, laid out both
+ * as the SDK fields and as a libcurl list. Never modified once built, so
+ * any number of requests may share them from any thread.
+ */
+class HttpHeaderArena {
+ public:
+  /* Names and values alternate, a trailing name without value is dropped */
+  explicit HttpHeaderArena(const std::vector<std::string>& pairs);
+
+  int size() const { return m_headers.num_fields; }
+
+  /* NULL when there is no header */
+  artik_http_headers* sdk() { return size() ? &m_headers : NULL; }
+  /*
+   * "Name: value" lines, NULL when there is no header. Requests adding
+   * their own lines link them in front rather than appending to it.
+   */
+  struct curl_slist* curl() { return size() ? m_list : NULL; }
+
+ private:
+  HttpHeaderArena(const HttpHeaderArena&);
+  HttpHeaderArena& operator=(const HttpHeaderArena&);
+
+  std::unique_ptr<char[]> m_arena;
+  artik_http_headers m_headers;
+  struct curl_slist* m_list;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_HTTP_HEADER_ARENA_H_
@@ -17,13 +17,16 @@
  */
 
 #include "http/http.h"
+#include "http/http_headers.h"
 
 #include <unistd.h>
 #include <node_buffer.h>
 #include <artik_log.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/ssl_config_converter.h"
 
@@ -47,139 +50,473 @@ using v8::Context;
 
 Persistent<Function> HttpWrapper::constructor;
 
+/*
+ * Request of the callback forms of the verbs, the user data handed to the
+ * SDK. Holds the headers and the body until the SDK is done with them.
+ */
+struct HttpLegacyRequest {
+  HttpLegacyRequest(HttpWrapper* wrap,
+      std::shared_ptr<HttpHeaderArena> headers)
+    : wrap(wrap), headers(headers) {}
+
+  HttpWrapper* wrap;
+  std::shared_ptr<HttpHeaderArena> headers;
+  std::string body;
+};
+
+/* Called once the SDK is done with a request, leaves its wrapper */
+static HttpWrapper* end_legacy_request(void* user_data) {
+  HttpLegacyRequest* req = reinterpret_cast<HttpLegacyRequest*>(user_data);
+  HttpWrapper* wrap = req->wrap;
+
+  delete req;
+  return wrap;
+}
+
 static int on_http_data(char *data, unsigned int len, void *user_data) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
-  HttpWrapper* wrap = reinterpret_cast<HttpWrapper*>(user_data);
+  HttpWrapper* wrap = reinterpret_cast<HttpLegacyRequest*>(user_data)->wrap;
 
   log_dbg("");
 
-  if (!wrap->getDataCb())
-    return 0;
+  /* The callback is only looked at on the JS thread */
+  std::string chunk(data, len);
 
-  Handle<Value> argv[] = {
-    Handle<Value>(Nan::CopyBuffer(data, len).ToLocalChecked())
-  };
+  GlibLoop::Instance()->invoke(wrap, [wrap, chunk]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
 
-  Local<Function>::New(isolate, *wrap->getDataCb())->Call(
-    isolate->GetCurrentContext()->Global(), 1, argv);
+    if (wrap->getDataCb().IsEmpty())
+      return;
+
+    Handle<Value> argv[] = {
+      Handle<Value>(Nan::CopyBuffer(chunk.data(),
+                                    chunk.size()).ToLocalChecked())
+    };
+
+    Local<Function>::New(isolate, wrap->getDataCb())->Call(
+      isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 
   return len;
 }
 
 static void on_http_error(artik_error result, int status, char * response,
   void *user_data) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
-  HttpWrapper* wrap = reinterpret_cast<HttpWrapper*>(user_data);
+  HttpWrapper* wrap = end_legacy_request(user_data);
 
   log_dbg("");
 
-  if (!wrap->getErrorCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, result, status]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, error_msg(result))),
-    Handle<Value>(v8::Integer::New(isolate, status)),
-  };
+    if (wrap->getErrorCb().IsEmpty())
+      return;
+
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, error_msg(result))),
+      Handle<Value>(v8::Integer::New(isolate, status)),
+    };
 
-  Local<Function>::New(isolate, *wrap->getErrorCb())->Call(
-    isolate->GetCurrentContext()->Global(), 2, argv);
+    Local<Function>::New(isolate, wrap->getErrorCb())->Call(
+      isolate->GetCurrentContext()->Global(), 2, argv);
+  });
 }
 
 static void http_response_get_callback(artik_error result, int status,
   char *response, void *user_data) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
-  HttpWrapper* wrap = reinterpret_cast<HttpWrapper*>(user_data);
+  HttpWrapper* wrap = end_legacy_request(user_data);
+  std::string body(result != S_OK ? error_msg(result) :
+                                    (response ? response : ""));
 
   log_dbg("");
 
-  if (!wrap->getResponseGetCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, body, status]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, result != S_OK ?
-                                                error_msg(result) : response)),
-    Handle<Value>(v8::Integer::New(isolate, status)),
-  };
+    if (wrap->getResponseGetCb().IsEmpty())
+      return;
 
-  Local<Function>::New(isolate, *wrap->getResponseGetCb())->Call(
-    isolate->GetCurrentContext()->Global(), 2, argv);
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, body.c_str())),
+      Handle<Value>(v8::Integer::New(isolate, status)),
+    };
+
+    Local<Function>::New(isolate, wrap->getResponseGetCb())->Call(
+      isolate->GetCurrentContext()->Global(), 2, argv);
+  });
 }
 
 static void http_response_post_callback(artik_error result, int status,
   char *response, void *user_data) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
-  HttpWrapper* wrap = reinterpret_cast<HttpWrapper*>(user_data);
+  HttpWrapper* wrap = end_legacy_request(user_data);
+  std::string body(result != S_OK ? error_msg(result) :
+                                    (response ? response : ""));
 
   log_dbg("");
 
-  if (!wrap->getResponsePostCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, body, status]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, result != S_OK ?
-                                                error_msg(result) : response)),
-    Handle<Value>(v8::Integer::New(isolate, status)),
-  };
+    if (wrap->getResponsePostCb().IsEmpty())
+      return;
 
-  Local<Function>::New(isolate, *wrap->getResponsePostCb())->Call(
-    isolate->GetCurrentContext()->Global(), 2, argv);
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, body.c_str())),
+      Handle<Value>(v8::Integer::New(isolate, status)),
+    };
+
+    Local<Function>::New(isolate, wrap->getResponsePostCb())->Call(
+      isolate->GetCurrentContext()->Global(), 2, argv);
+  });
 }
 
 static void http_response_put_callback(artik_error result, int status,
   char *response, void *user_data) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
-  HttpWrapper* wrap = reinterpret_cast<HttpWrapper*>(user_data);
+  HttpWrapper* wrap = end_legacy_request(user_data);
+  std::string body(result != S_OK ? error_msg(result) :
+                                    (response ? response : ""));
 
   log_dbg("");
 
-  if (!wrap->getResponsePutCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, body, status]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, result != S_OK ?
-                                                error_msg(result) : response)),
-    Handle<Value>(v8::Integer::New(isolate, status)),
-  };
+    if (wrap->getResponsePutCb().IsEmpty())
+      return;
+
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, body.c_str())),
+      Handle<Value>(v8::Integer::New(isolate, status)),
+    };
 
-  Local<Function>::New(isolate, *wrap->getResponsePutCb())->Call(
-    isolate->GetCurrentContext()->Global(), 2, argv);
+    Local<Function>::New(isolate, wrap->getResponsePutCb())->Call(
+      isolate->GetCurrentContext()->Global(), 2, argv);
+  });
 }
 
 static void http_response_del_callback(artik_error result, int status,
   char *response, void *user_data) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
-  HttpWrapper* wrap = reinterpret_cast<HttpWrapper*>(user_data);
+  HttpWrapper* wrap = end_legacy_request(user_data);
+  std::string body(result != S_OK ? error_msg(result) :
+                                    (response ? response : ""));
 
   log_dbg("");
 
-  if (!wrap->getResponseDelCb())
+  GlibLoop::Instance()->invoke(wrap, [wrap, body, status]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    if (wrap->getResponseDelCb().IsEmpty())
+      return;
+
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, body.c_str())),
+      Handle<Value>(v8::Integer::New(isolate, status)),
+    };
+
+    Local<Function>::New(isolate, wrap->getResponseDelCb())->Call(
+      isolate->GetCurrentContext()->Global(), 2, argv);
+  });
+}
+
+/*
+ * Request going through the SDK, used when the TLS setup relies on the
+ * Secure Element which only the SDK can drive. The SDK cannot abort it:
+ * on timeout or cancellation the request completes right away and the
+ * response is dropped when it eventually comes. The wrapper is kept alive
+ * until then, the SDK holding a pointer to this.
+ */
+struct HttpSdkRequest {
+  HttpWrapper* wrap;
+  uint64_t id;
+  std::unique_ptr<artik_ssl_config> ssl_config;
+  std::shared_ptr<HttpHeaderArena> headers;
+  std::string body;
+  uv_timer_t* timer;
+};
+
+static void http_timer_close_cb(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_timer_t*>(handle);
+}
+
+static void http_sdk_stop_timer(HttpSdkRequest* req) {
+  if (!req->timer)
     return;
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, result != S_OK ?
-                                                error_msg(result) : response)),
-    Handle<Value>(v8::Integer::New(isolate, status)),
-  };
+  uv_timer_stop(req->timer);
+  uv_close(reinterpret_cast<uv_handle_t*>(req->timer), http_timer_close_cb);
+  req->timer = NULL;
+}
+
+static void http_sdk_timeout_cb(uv_timer_t* handle) {
+  HttpSdkRequest* req = reinterpret_cast<HttpSdkRequest*>(handle->data);
+  HttpClient::Response response;
 
-  Local<Function>::New(isolate, *wrap->getResponseDelCb())->Call(
-    isolate->GetCurrentContext()->Global(), 2, argv);
+  response.result = HttpClient::TIMED_OUT;
+  response.error = "Request timed out";
+  http_sdk_stop_timer(req);
+  req->wrap->finish_request(req->id, &response);
 }
 
-HttpWrapper::HttpWrapper() {
-  m_http = new Http();
+static void http_sdk_response_callback(artik_error result, int status,
+  char *response, void *user_data) {
+  HttpSdkRequest* req = reinterpret_cast<HttpSdkRequest*>(user_data);
+  std::string body(response ? response : "");
+
+  log_dbg("");
+
+  GlibLoop::Instance()->invoke(req->wrap, [req, result, status, body]() {
+    HttpClient::Response response;
+
+    if (result != S_OK) {
+      response.result = HttpClient::FAILED;
+      response.error = error_msg(result);
+    } else {
+      response.status = status;
+      response.body = body;
+    }
+
+    req->wrap->finish_request(req->id, &response);
+    req->wrap->release_sdk_request(req);
+  });
+}
+
+static void http_async_close_cb(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+static void copy_ssl_buffer(Local<Value> ssl_config, const char* name,
+    std::string* out) {
+  auto value = js_object_attribute_to_cpp<Local<Value>>(ssl_config, name);
+
+  if (value && node::Buffer::HasInstance(value.value()))
+    out->assign(node::Buffer::Data(value.value()),
+                node::Buffer::Length(value.value()));
+}
+
+HttpWrapper::HttpWrapper(const HttpClient::Options& options) {
+  {
+    GlibLoop::SdkLock lock;
+
+    m_http = new Http();
+  }
   m_loop = GlibLoop::Instance();
-  m_loop->attach();
+  m_loop->attach(true);
+  m_client = NULL;
+  m_client_options = options;
+  m_next_request = 1;
+  m_busy = false;
+  m_async = new uv_async_t;
+  m_async->data = this;
+  uv_async_init(uv_default_loop(), m_async, request_async_cb);
+  uv_unref(reinterpret_cast<uv_handle_t*>(m_async));
 }
 
 HttpWrapper::~HttpWrapper() {
-  m_loop->detach();
-  delete m_http;
+  /* Joins the client thread, nothing gets queued past this point */
+  delete m_client;
+  m_tasks.clear();
+  for (auto& item : m_requests)
+    delete item.second;
+  for (auto& item : m_progress)
+    delete item.second;
+  for (auto& item : m_bodies) {
+    item.second->Reset();
+    delete item.second;
+  }
+  uv_close(reinterpret_cast<uv_handle_t*>(m_async), http_async_close_cb);
+  m_data_cb.Reset();
+  m_error_cb.Reset();
+  m_response_get_cb.Reset();
+  m_response_post_cb.Reset();
+  m_response_put_cb.Reset();
+  m_response_del_cb.Reset();
+
+  {
+    GlibLoop::SdkLock lock;
+
+    delete m_http;
+  }
+  m_loop->cancel(this);
+  m_loop->detach(true);
+}
+
+HttpClient* HttpWrapper::client() {
+  if (!m_client)
+    m_client = new HttpClient(m_client_options,
+        [this](uint64_t id, HttpClient::Response* response) {
+          on_request_done(id, response);
+        });
+
+  return m_client;
+}
+
+void HttpWrapper::post_task(std::function<void()> task) {
+  std::lock_guard<std::mutex> l(m_tasks_lock);
+
+  m_tasks.push_back(task);
+  uv_async_send(m_async);
+}
+
+void HttpWrapper::on_request_done(uint64_t id,
+    HttpClient::Response* response) {
+  std::shared_ptr<HttpClient::Response> done(
+      new HttpClient::Response(std::move(*response)));
+
+  post_task([this, id, done]() {
+    release_body(id);
+    finish_request(id, done.get());
+  });
+}
+
+void HttpWrapper::release_progress(uint64_t id) {
+  auto it = m_progress.find(id);
+
+  if (it == m_progress.end())
+    return;
+
+  delete it->second;
+  m_progress.erase(it);
+}
+
+void HttpWrapper::release_body(uint64_t id) {
+  auto it = m_bodies.find(id);
+
+  if (it == m_bodies.end())
+    return;
+
+  it->second->Reset();
+  delete it->second;
+  m_bodies.erase(it);
+}
+
+void HttpWrapper::request_async_cb(uv_async_t* handle) {
+  HttpWrapper* wrap = reinterpret_cast<HttpWrapper*>(handle->data);
+  std::deque<std::function<void()>> tasks;
+
+  {
+    std::lock_guard<std::mutex> l(wrap->m_tasks_lock);
+    tasks.swap(wrap->m_tasks);
+  }
+
+  for (auto& task : tasks)
+    task();
+}
+
+static void free_response_body(char* data, void* hint) {
+  delete reinterpret_cast<std::string*>(hint);
+}
+
+/*
+ * Names are lower-cased, repeated headers get their values joined by
+ * commas except Set-Cookie which comes as an array.
+ */
+static Local<Object> response_headers(Isolate* isolate,
+    const HttpClient::Response& response) {
+  Local<Object> headers = Object::New(isolate);
+
+  for (auto& header : response.headers) {
+    std::string name(header.first);
+
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    Local<String> key = String::NewFromUtf8(isolate, name.c_str());
+    Local<String> value = String::NewFromUtf8(isolate, header.second.data(),
+        String::kNormalString, header.second.size());
+    Local<Value> previous = headers->Get(key);
+
+    if (name == "set-cookie") {
+      Local<Array> cookies = previous->IsArray() ?
+          Local<Array>::Cast(previous) : Array::New(isolate);
+
+      cookies->Set(cookies->Length(), value);
+      headers->Set(key, cookies);
+    } else if (previous->IsString()) {
+      headers->Set(key, String::Concat(previous.As<String>(),
+          String::Concat(String::NewFromUtf8(isolate, ", "), value)));
+    } else {
+      headers->Set(key, value);
+    }
+  }
+
+  return headers;
+}
+
+void HttpWrapper::finish_request(uint64_t id,
+    HttpClient::Response* response) {
+  auto it = m_requests.find(id);
+
+  /* Already completed by a timeout or a cancellation */
+  if (it == m_requests.end())
+    return;
+
+  Nan::HandleScope scope;
+  Isolate* isolate = Isolate::GetCurrent();
+  Nan::Callback* callback = it->second;
+  Local<Value> err = Nan::Null();
+  Local<Value> download = Nan::Undefined();
+
+  m_requests.erase(it);
+  release_progress(id);
+
+  if (response->result != HttpClient::OK) {
+    Local<Object> error = Nan::Error(response->error.c_str()).As<Object>();
+
+    if (response->result == HttpClient::TIMED_OUT)
+      error->Set(String::NewFromUtf8(isolate, "code"),
+                 String::NewFromUtf8(isolate, "ETIMEDOUT"));
+    else if (response->result == HttpClient::CANCELLED)
+      error->Set(String::NewFromUtf8(isolate, "code"),
+                 String::NewFromUtf8(isolate, "ECANCELED"));
+    err = error;
+  }
+
+  /* The Buffer takes over the body rather than copying it */
+  std::string* body = new std::string();
+
+  body->swap(response->body);
+
+  if (response->download) {
+    Local<Object> info = Object::New(isolate);
+
+    info->Set(String::NewFromUtf8(isolate, "size"),
+              Number::New(isolate, response->file_size));
+    info->Set(String::NewFromUtf8(isolate, "resumed"),
+              v8::Boolean::New(isolate, response->resumed));
+    if (!response->sha256.empty())
+      info->Set(String::NewFromUtf8(isolate, "sha256"),
+                String::NewFromUtf8(isolate, response->sha256.c_str()));
+    download = info;
+  }
+
+  Local<Value> argv[5] = {
+    err,
+    Nan::New<Number>(response->status),
+    Nan::NewBuffer(const_cast<char*>(body->data()), body->size(),
+                   free_response_body, body).ToLocalChecked(),
+    response_headers(isolate, *response),
+    download
+  };
+
+  callback->Call(5, argv);
+  delete callback;
+
+  if (m_requests.empty() && m_busy) {
+    m_busy = false;
+    uv_unref(reinterpret_cast<uv_handle_t*>(m_async));
+    Unref();
+  }
+}
+
+void HttpWrapper::release_sdk_request(HttpSdkRequest* req) {
+  http_sdk_stop_timer(req);
+  m_sdk_requests.erase(req->id);
+  delete req;
+  Unref();
 }
 
 void HttpWrapper::Init(Local<Object> exports) {
@@ -196,6 +533,12 @@ void HttpWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(tpl, "post", post);
   NODE_SET_PROTOTYPE_METHOD(tpl, "put", put);
   NODE_SET_PROTOTYPE_METHOD(tpl, "del", del);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "request", request);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "cancel", cancel);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "write_body", write_body);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "end_body", end_body);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "download", download);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get_pool_stats", get_pool_stats);
 
   constructor.Reset(isolate, tpl->GetFunction());
   exports->Set(String::NewFromUtf8(isolate, "http"),
@@ -207,14 +550,38 @@ void HttpWrapper::New(const FunctionCallbackInfo<Value>& args) {
 
   log_dbg("Create Http JS Wrapper");
   if (args.IsConstructCall()) {
-    HttpWrapper* obj = new HttpWrapper();
+    HttpClient::Options options;
+
+    if (!args[0]->IsUndefined() && !args[0]->IsObject()) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+      return;
+    }
+
+    auto per_host = js_object_attribute_to_cpp<uint32_t>(args[0],
+        "max_connections_per_host");
+    auto total = js_object_attribute_to_cpp<uint32_t>(args[0],
+        "max_connections");
+    auto idle = js_object_attribute_to_cpp<uint32_t>(args[0],
+        "max_idle_connections");
+    auto keep_alive = js_object_attribute_to_cpp<uint32_t>(args[0],
+        "keep_alive");
+
+    options.max_host_connections = per_host ? per_host.value() : 0;
+    options.max_total_connections = total ? total.value() : 0;
+    options.max_idle_connections = idle ? idle.value() : 0;
+    options.keep_alive = keep_alive ? keep_alive.value() : 0;
+
+    HttpWrapper* obj = new HttpWrapper(options);
     obj->Wrap(args.This());
     args.GetReturnValue().Set(args.This());
   } else {
+    const int argc = 1;
+    Local<Value> argv[argc] = { args[0] };
     Local<Context> context = isolate->GetCurrentContext();
     Local<Function> cons = Local<Function>::New(isolate, constructor);
     args.GetReturnValue().Set(
-        cons->NewInstance(context, 0, NULL).ToLocalChecked());
+        cons->NewInstance(context, argc, argv).ToLocalChecked());
   }
 }
 
@@ -222,7 +589,6 @@ void HttpWrapper::get_stream(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
   Http* http = obj->getObj();
-  artik_http_headers* headers = NULL;
   std::unique_ptr<artik_ssl_config> ssl_config(nullptr);
 
   log_dbg("");
@@ -233,41 +599,9 @@ void HttpWrapper::get_stream(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  /* Copy headers */
-  if (args[1]->IsArray()) {
-    Local<Array> array = Local<Array>::Cast(args[1]);
-
-    if (array->Length() > 2) {
-      int num_headers = array->Length()/2;
-      artik_http_header_field* fields =
-        reinterpret_cast<artik_http_header_field*>(malloc(
-        num_headers*sizeof(artik_http_header_field)));
-      if (!fields) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      for (int i=0; i < num_headers; i++) {
-        v8::String::Utf8Value name(array->Get(i*2)->ToString());
-        v8::String::Utf8Value data(array->Get((i*2)+1)->ToString());
-
-        fields[i].name = strndup(*name, MAX_HEADER_SIZE);
-        fields[i].data = strndup(*data, MAX_HEADER_SIZE);
-      }
-
-      headers = reinterpret_cast<artik_http_headers*>(
-        malloc(sizeof(artik_http_headers)));
-      if (!headers) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      headers->num_fields = num_headers;
-      headers->fields = fields;
-    }
-  }
+  /* Marshaled into a single block, freed with its last user */
+  std::shared_ptr<HttpHeaderArena> arena = HttpHeadersWrapper::from_js(args[1]);
+  artik_http_headers* headers = arena ? arena->sdk() : NULL;
 
   /* SSL Configuration */
   if (args[2]->IsObject()) {
@@ -278,21 +612,28 @@ void HttpWrapper::get_stream(const FunctionCallbackInfo<Value>& args) {
   }
 
   /* Data Callback */
-  if (args[3]->IsFunction()) {
-    obj->m_data_cb = new v8::Persistent<v8::Function>();
-    obj->m_data_cb->Reset(isolate, Local<Function>::Cast(args[3]));
-  }
+  if (args[3]->IsFunction())
+    obj->m_data_cb.Reset(isolate, Local<Function>::Cast(args[3]));
 
   /* Error Callback */
-  if (args[4]->IsFunction()) {
-    obj->m_error_cb = new v8::Persistent<v8::Function>();
-    obj->m_error_cb->Reset(isolate, Local<Function>::Cast(args[4]));
-  }
+  if (args[4]->IsFunction())
+    obj->m_error_cb.Reset(isolate, Local<Function>::Cast(args[4]));
 
   v8::String::Utf8Value param0(args[0]->ToString());
   const char *url = *param0;
-  artik_error ret = http->get_stream_async(url, headers, on_http_data,
-    on_http_error, reinterpret_cast<void*>(obj), ssl_config.get());
+  artik_error ret = S_OK;
+
+  HttpLegacyRequest* legacy = new HttpLegacyRequest(obj, arena);
+
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = http->get_stream_async(url, headers, on_http_data,
+      on_http_error, legacy, ssl_config.get());
+  }
+
+  if (ret != S_OK)
+    delete legacy;
 
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
@@ -301,52 +642,20 @@ void HttpWrapper::get(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
   Http* http = obj->getObj();
-  artik_http_headers* headers = NULL;
   std::unique_ptr<artik_ssl_config> ssl_config(nullptr);
 
   log_dbg("");
 
-  if (!args[0]->IsString()) {
+  /* Only the callback form lands here, the others go through request() */
+  if (!args[0]->IsString() || !args[3]->IsFunction()) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
       isolate, "Wrong arguments")));
     return;
   }
 
-  /* Copy headers */
-  if (args[1]->IsArray()) {
-    Local<Array> array = Local<Array>::Cast(args[1]);
-
-    if (array->Length() > 2) {
-      int num_headers = array->Length() / 2;
-      artik_http_header_field *fields =
-          reinterpret_cast<artik_http_header_field*>(malloc(
-          num_headers * sizeof(artik_http_header_field)));
-      if (!fields) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      for (int i = 0; i < num_headers; i++) {
-        v8::String::Utf8Value name(array->Get(i*2)->ToString());
-        v8::String::Utf8Value data(array->Get((i*2)+1)->ToString());
-
-        fields[i].name = strndup(*name, MAX_HEADER_SIZE);
-        fields[i].data = strndup(*data, MAX_HEADER_SIZE);
-      }
-
-      headers = reinterpret_cast<artik_http_headers*>(malloc(
-          sizeof(artik_http_headers)));
-      if (!headers) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      headers->num_fields = num_headers;
-      headers->fields = fields;
-    }
-  }
+  /* Marshaled into a single block, freed with its last user */
+  std::shared_ptr<HttpHeaderArena> arena = HttpHeadersWrapper::from_js(args[1]);
+  artik_http_headers* headers = arena ? arena->sdk() : NULL;
 
   /* SSL Configuration */
   if (args[2]->IsObject()) {
@@ -356,85 +665,46 @@ void HttpWrapper::get(const FunctionCallbackInfo<Value>& args) {
     }
   }
 
-  /* If callback is provided, make the call asynchronous */
-  if (args[3]->IsFunction()) {
-    obj->m_response_get_cb = new v8::Persistent<v8::Function>();
-    obj->m_response_get_cb->Reset(isolate, Local<Function>::Cast(args[3]));
+  obj->m_response_get_cb.Reset(isolate, Local<Function>::Cast(args[3]));
 
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    artik_error ret = http->get_async(
-      url, headers, http_response_get_callback,
-      reinterpret_cast<void*>(obj), ssl_config.get());
+  v8::String::Utf8Value param0(args[0]->ToString());
+  const char *url = *param0;
+  artik_error ret = S_OK;
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
+  HttpLegacyRequest* legacy = new HttpLegacyRequest(obj, arena);
 
-  } else { /* Otherwise make the call directly */
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    char *response = NULL;
-    artik_error ret =
-      http->get(url, headers, &response, NULL, ssl_config.get());
+  {
+    GlibLoop::SdkLock lock;
 
-    if (ret != S_OK)
-      response = strndup(error_msg(ret), MAX_ERRR_MSG_LEN);
+    ret = http->get_async(
+      url, headers, http_response_get_callback,
+      legacy, ssl_config.get());
+  }
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, response));
+  if (ret != S_OK)
+    delete legacy;
 
-    free(response);
-  }
+  args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
 
 void HttpWrapper::post(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
   Http* http = obj->getObj();
-  artik_http_headers* headers = NULL;
   std::unique_ptr<artik_ssl_config> ssl_config(nullptr);
 
   log_dbg("");
 
-  if (!args[0]->IsString()) {
+  /* Only the callback form lands here, the others go through request() */
+  if (!args[0]->IsString() || !args[4]->IsFunction()) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
       isolate, "Wrong arguments")));
     return;
   }
 
-  /* Copy headers */
-  if (args[1]->IsArray()) {
-    Local<Array> array = Local<Array>::Cast(args[1]);
-
-    if (array->Length() > 2) {
-      int num_headers = array->Length()/2;
-      artik_http_header_field* fields =
-          reinterpret_cast<artik_http_header_field*>(malloc(
-          num_headers * sizeof(artik_http_header_field)));
-      if (!fields) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      for (int i = 0; i < num_headers; i++) {
-        v8::String::Utf8Value name(array->Get(i*2)->ToString());
-        v8::String::Utf8Value data(array->Get((i*2)+1)->ToString());
-
-        fields[i].name = strndup(*name, MAX_HEADER_SIZE);
-        fields[i].data = strndup(*data, MAX_HEADER_SIZE);
-      }
-
-      headers = reinterpret_cast<artik_http_headers*>(malloc(
-          sizeof(artik_http_headers)));
-      if (!headers) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      headers->num_fields = num_headers;
-      headers->fields = fields;
-    }
-  }
+  /* Marshaled into a single block, freed with its last user */
+  std::shared_ptr<HttpHeaderArena> arena = HttpHeadersWrapper::from_js(args[1]);
+  artik_http_headers* headers = arena ? arena->sdk() : NULL;
 
   /* SSL Configuration */
   if (args[3]->IsObject()) {
@@ -444,244 +714,534 @@ void HttpWrapper::post(const FunctionCallbackInfo<Value>& args) {
     }
   }
 
-  /* If callback is provided, make the call asynchronous */
-  if (args[4]->IsFunction()) {
-    obj->m_response_post_cb = new v8::Persistent<v8::Function>();
-    obj->m_response_post_cb->Reset(isolate, Local<Function>::Cast(args[4]));
+  obj->m_response_post_cb.Reset(isolate, Local<Function>::Cast(args[4]));
 
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    const char *body = NULL;
+  v8::String::Utf8Value param0(args[0]->ToString());
+  const char *url = *param0;
+  artik_error ret = S_OK;
 
-    /* copy body data if provided */
-    if (args[2]->IsString()) {
-      v8::String::Utf8Value param2(args[2]->ToString());
-      body = strndup(*param2, strlen(*param2));
-    }
+  HttpLegacyRequest* legacy = new HttpLegacyRequest(obj, arena);
+  const char *body = NULL;
 
-    artik_error ret = http->post_async(
+  /* Kept along with the request until the SDK is done with it */
+  if (args[2]->IsString()) {
+    legacy->body = *v8::String::Utf8Value(args[2]->ToString());
+    body = legacy->body.c_str();
+  }
+
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = http->post_async(
       url, headers, body,
       http_response_post_callback,
-      reinterpret_cast<void*>(obj), ssl_config.get());
+      legacy, ssl_config.get());
+  }
+
+  if (ret != S_OK)
+    delete legacy;
+
+  args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
+}
+
+void HttpWrapper::put(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
+  Http* http = obj->getObj();
+  std::unique_ptr<artik_ssl_config> ssl_config(nullptr);
+
+  log_dbg("");
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
+  /* Only the callback form lands here, the others go through request() */
+  if (!args[0]->IsString() || !args[4]->IsFunction()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+      isolate, "Wrong arguments")));
+    return;
+  }
 
-  } else { /* Otherwise make the call directly */
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    const char *body = NULL;
-    char *response = NULL;
-    artik_error ret = S_OK;
+  /* Marshaled into a single block, freed with its last user */
+  std::shared_ptr<HttpHeaderArena> arena = HttpHeadersWrapper::from_js(args[1]);
+  artik_http_headers* headers = arena ? arena->sdk() : NULL;
 
-    /* copy body data if provided */
-    if (args[2]->IsString()) {
-      v8::String::Utf8Value param2(args[2]->ToString());
-      body = strndup(*param2, strlen(*param2));
+  /* SSL Configuration */
+  if (args[3]->IsObject()) {
+    ssl_config = SSLConfigConverter::convert(isolate, args[3]);
+    if (!ssl_config) {
+      return;
     }
+  }
 
-    ret = http->post(url, headers, body, &response, NULL, ssl_config.get());
+  obj->m_response_put_cb.Reset(isolate, Local<Function>::Cast(args[4]));
 
-    if (ret != S_OK)
-      response = strndup(error_msg(ret), MAX_ERRR_MSG_LEN);
+  v8::String::Utf8Value param0(args[0]->ToString());
+  const char *url = *param0;
+  artik_error ret = S_OK;
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, response));
+  HttpLegacyRequest* legacy = new HttpLegacyRequest(obj, arena);
+  const char *body = NULL;
 
-    free(response);
+  /* Kept along with the request until the SDK is done with it */
+  if (args[2]->IsString()) {
+    legacy->body = *v8::String::Utf8Value(args[2]->ToString());
+    body = legacy->body.c_str();
   }
+
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = http->put_async(
+      url, headers, body,
+      http_response_put_callback,
+      legacy, ssl_config.get());
+  }
+
+  if (ret != S_OK)
+    delete legacy;
+
+  args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
 
-void HttpWrapper::put(const FunctionCallbackInfo<Value>& args) {
+void HttpWrapper::del(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
   Http* http = obj->getObj();
-  artik_http_headers* headers = NULL;
   std::unique_ptr<artik_ssl_config> ssl_config(nullptr);
 
   log_dbg("");
 
-  if (!args[0]->IsString()) {
+  /* Only the callback form lands here, the others go through request() */
+  if (!args[0]->IsString() || !args[3]->IsFunction()) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
       isolate, "Wrong arguments")));
     return;
   }
 
-  /* Copy headers */
-  if (args[1]->IsArray()) {
-    Local<Array> array = Local<Array>::Cast(args[1]);
-
-    if (array->Length() > 2) {
-      int num_headers = array->Length()/2;
-      artik_http_header_field* fields =
-          reinterpret_cast<artik_http_header_field*>(malloc(
-          num_headers * sizeof(artik_http_header_field)));
-      if (!fields) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      for (int i = 0; i < num_headers; i++) {
-        v8::String::Utf8Value name(array->Get(i*2)->ToString());
-        v8::String::Utf8Value data(array->Get((i*2)+1)->ToString());
-
-        fields[i].name = strndup(*name, MAX_HEADER_SIZE);
-        fields[i].data = strndup(*data, MAX_HEADER_SIZE);
-      }
-
-      headers = reinterpret_cast<artik_http_headers*>(malloc(
-          sizeof(artik_http_headers)));
-      if (!headers) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      headers->num_fields = num_headers;
-      headers->fields = fields;
+  /* Marshaled into a single block, freed with its last user */
+  std::shared_ptr<HttpHeaderArena> arena = HttpHeadersWrapper::from_js(args[1]);
+  artik_http_headers* headers = arena ? arena->sdk() : NULL;
+
+  /* SSL Configuration */
+  if (args[2]->IsObject()) {
+    ssl_config = SSLConfigConverter::convert(isolate, args[2]);
+    if (!ssl_config) {
+      return;
     }
   }
 
+  obj->m_response_del_cb.Reset(isolate, Local<Function>::Cast(args[3]));
+
+  v8::String::Utf8Value param0(args[0]->ToString());
+  const char *url = *param0;
+  artik_error ret = S_OK;
+
+  HttpLegacyRequest* legacy = new HttpLegacyRequest(obj, arena);
+
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = http->del_async(url, headers,
+      http_response_del_callback, legacy,
+      ssl_config.get());
+  }
+
+  if (ret != S_OK)
+    delete legacy;
+
+  args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
+}
+
+/*
+ * Headers, SSL configuration and options common to the requests of the
+ * native client. Returns false with an exception pending on errors.
+ */
+static bool client_request_args(Isolate* isolate, Local<Value> headers,
+    Local<Value> ssl, Local<Value> options, HttpClient::Request* req,
+    std::unique_ptr<artik_ssl_config>* ssl_config) {
+  /* Shared as is with HttpHeaders, marshaled once otherwise */
+  req->shared_headers = HttpHeadersWrapper::from_js(headers);
+
   /* SSL Configuration */
-  if (args[3]->IsObject()) {
-    ssl_config = SSLConfigConverter::convert(isolate, args[3]);
-    if (!ssl_config) {
+  if (ssl->IsObject()) {
+    *ssl_config = SSLConfigConverter::convert(isolate, ssl);
+    if (!*ssl_config)
+      return false;
+
+    copy_ssl_buffer(ssl, "ca_cert", &req->ca_cert);
+    copy_ssl_buffer(ssl, "client_cert", &req->client_cert);
+    copy_ssl_buffer(ssl, "client_key", &req->client_key);
+    switch ((*ssl_config)->verify_cert) {
+    case ARTIK_SSL_VERIFY_REQUIRED:
+      req->verify = HttpClient::VERIFY_REQUIRED;
+      break;
+    case ARTIK_SSL_VERIFY_OPTIONAL:
+      req->verify = HttpClient::VERIFY_OPTIONAL;
+      break;
+    default:
+      req->verify = HttpClient::VERIFY_NONE;
+      break;
+    }
+  }
+
+  auto timeout = js_object_attribute_to_cpp<uint32_t>(options, "timeout");
+  auto connect_timeout = js_object_attribute_to_cpp<uint32_t>(options,
+      "connect_timeout");
+
+  req->timeout = timeout ? timeout.value() : 0;
+  req->connect_timeout = connect_timeout ? connect_timeout.value() : 0;
+
+  return true;
+}
+
+/* The client got its own copy of the certificates */
+static void free_ssl_certs(artik_ssl_config* ssl_config) {
+  if (!ssl_config)
+    return;
+
+  free(const_cast<char*>(ssl_config->ca_cert.data));
+  free(const_cast<char*>(ssl_config->client_cert.data));
+  free(const_cast<char*>(ssl_config->client_key.data));
+}
+
+void HttpWrapper::request(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
+  std::unique_ptr<HttpClient::Request> req(new HttpClient::Request());
+  std::unique_ptr<artik_ssl_config> ssl_config(nullptr);
+
+  log_dbg("");
+
+  if (!args[0]->IsString() || !args[1]->IsString() || !args[6]->IsFunction()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+      isolate, "Wrong arguments")));
+    return;
+  }
+
+  req->method = *v8::String::Utf8Value(args[0]);
+  req->url = *v8::String::Utf8Value(args[1]);
+  if (req->method != "GET" && req->method != "POST" && req->method != "PUT" &&
+      req->method != "DELETE") {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+      isolate, "Unsupported HTTP method")));
+    return;
+  }
+
+  /*
+   * Bodies are a String, a Buffer sent in place, a file sent from a
+   * mapping or a stream fed with write_body()
+   */
+  if (args[3]->IsString()) {
+    v8::String::Utf8Value body(args[3]);
+
+    req->body.assign(*body, body.length());
+    req->body_type = HttpClient::BODY_STRING;
+  } else if (node::Buffer::HasInstance(args[3])) {
+    req->body_data = node::Buffer::Data(args[3]);
+    req->body_size = node::Buffer::Length(args[3]);
+    req->body_type = HttpClient::BODY_BUFFER;
+  } else if (args[3]->IsObject()) {
+    auto file = js_object_attribute_to_cpp<std::string>(args[3], "file");
+    auto stream = js_object_attribute_to_cpp<bool>(args[3], "stream");
+
+    if (file) {
+      req->body = file.value();
+      req->body_type = HttpClient::BODY_FILE;
+    } else if (stream && stream.value()) {
+      req->body_type = HttpClient::BODY_STREAM;
+    } else {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
       return;
     }
   }
 
-  /* If callback is provided, make the call asynchronous */
-  if (args[4]->IsFunction()) {
-    obj->m_response_put_cb = new v8::Persistent<v8::Function>();
-    obj->m_response_put_cb->Reset(isolate, Local<Function>::Cast(args[4]));
+  if (!client_request_args(isolate, args[2], args[4], args[5], req.get(),
+      &ssl_config))
+    return;
 
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    const char *body = NULL;
+  uint64_t id = obj->m_next_request++;
 
-    /* copy body data if provided */
-    if (args[2]->IsString()) {
-      v8::String::Utf8Value param2(args[2]->ToString());
-      body = strndup(*param2, strlen(*param2));
+  if (ssl_config && ssl_config->se_config.use_se) {
+    HttpSdkRequest* sdk;
+    artik_error ret;
+
+    if (req->body_type != HttpClient::BODY_NONE &&
+        req->body_type != HttpClient::BODY_STRING) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Secure Element requests only take String bodies")));
+      return;
     }
 
-    artik_error ret = http->put_async(
-      url, headers, body,
-      http_response_put_callback,
-      reinterpret_cast<void*>(obj), ssl_config.get());
+    sdk = new HttpSdkRequest();
+
+    sdk->wrap = obj;
+    sdk->id = id;
+    sdk->timer = NULL;
+    sdk->body = req->body;
+    sdk->headers = req->shared_headers;
+    sdk->ssl_config = std::move(ssl_config);
+
+    artik_http_headers* headers = sdk->headers ? sdk->headers->sdk() : NULL;
+    const char* body = req->body_type == HttpClient::BODY_STRING ?
+        sdk->body.c_str() : NULL;
+
+    obj->m_sdk_requests[id] = sdk;
+    obj->Ref();
+
+    {
+      GlibLoop::SdkLock lock;
+
+      if (req->method == "GET")
+        ret = obj->m_http->get_async(req->url.c_str(), headers,
+            http_sdk_response_callback, sdk, sdk->ssl_config.get());
+      else if (req->method == "POST")
+        ret = obj->m_http->post_async(req->url.c_str(), headers, body,
+            http_sdk_response_callback, sdk, sdk->ssl_config.get());
+      else if (req->method == "PUT")
+        ret = obj->m_http->put_async(req->url.c_str(), headers, body,
+            http_sdk_response_callback, sdk, sdk->ssl_config.get());
+      else
+        ret = obj->m_http->del_async(req->url.c_str(), headers,
+            http_sdk_response_callback, sdk, sdk->ssl_config.get());
+    }
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
+    if (ret != S_OK) {
+      obj->release_sdk_request(sdk);
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, error_msg(ret))));
+      return;
+    }
 
-  } else { /* Otherwise make the call directly */
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    const char *body = NULL;
-    char *response = NULL;
-    artik_error ret = S_OK;
+    if (req->timeout) {
+      sdk->timer = new uv_timer_t;
+      sdk->timer->data = sdk;
+      uv_timer_init(uv_default_loop(), sdk->timer);
+      uv_timer_start(sdk->timer, http_sdk_timeout_cb, req->timeout, 0);
+    }
+  } else {
+    std::string error;
+    bool pin = req->body_type == HttpClient::BODY_BUFFER;
+
+    free_ssl_certs(ssl_config.get());
 
-    /* copy body data if provided */
-    if (args[2]->IsString()) {
-      v8::String::Utf8Value param2(args[2]->ToString());
-      body = strndup(*param2, strlen(*param2));
+    if (!obj->client()->submit(id, std::move(req), &error)) {
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, error.c_str())));
+      return;
     }
 
-    ret = http->put(url, headers, body, &response, NULL, ssl_config.get());
+    /* Sent without a copy, the Buffer must outlive even a cancellation */
+    if (pin)
+      obj->m_bodies[id] = new Nan::Persistent<Object>(args[3].As<Object>());
+  }
 
-    if (ret != S_OK)
-      response = strndup(error_msg(ret), MAX_ERRR_MSG_LEN);
+  obj->track_request(id, args[6].As<Function>());
+  args.GetReturnValue().Set(Number::New(isolate, id));
+}
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, response));
+void HttpWrapper::track_request(uint64_t id, Local<Function> callback) {
+  m_requests[id] = new Nan::Callback(callback);
 
-    free(response);
+  /* Keep the wrapper and the loop alive until every request completes */
+  if (!m_busy) {
+    m_busy = true;
+    uv_ref(reinterpret_cast<uv_handle_t*>(m_async));
+    Ref();
   }
 }
 
-void HttpWrapper::del(const FunctionCallbackInfo<Value>& args) {
+void HttpWrapper::download(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
-  Http* http = obj->getObj();
-  artik_http_headers* headers = NULL;
+  std::unique_ptr<HttpClient::Request> req(new HttpClient::Request());
   std::unique_ptr<artik_ssl_config> ssl_config(nullptr);
+  std::string error;
 
   log_dbg("");
 
-  if (!args[0]->IsString()) {
+  if (!args[0]->IsString() || !args[1]->IsString() || !args[6]->IsFunction()) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
       isolate, "Wrong arguments")));
     return;
   }
 
-  /* Copy headers */
-  if (args[1]->IsArray()) {
-    Local<Array> array = Local<Array>::Cast(args[1]);
-
-    if (array->Length() > 2) {
-      int num_headers = array->Length()/2;
-      artik_http_header_field *fields =
-          reinterpret_cast<artik_http_header_field*>(malloc(
-          num_headers * sizeof(artik_http_header_field)));
-      if (!fields) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      for (int i = 0; i < num_headers; i++) {
-        v8::String::Utf8Value name(array->Get(i*2)->ToString());
-        v8::String::Utf8Value data(array->Get((i*2)+1)->ToString());
-
-        fields[i].name = strndup(*name, MAX_HEADER_SIZE);
-        fields[i].data = strndup(*data, MAX_HEADER_SIZE);
-      }
-
-      headers = reinterpret_cast<artik_http_headers*>(malloc(
-          sizeof(artik_http_headers)));
-      if (!headers) {
-        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
-          isolate, "Memory allocation error")));
-        return;
-      }
-
-      headers->num_fields = num_headers;
-      headers->fields = fields;
-    }
-  }
+  req->method = "GET";
+  req->url = *v8::String::Utf8Value(args[0]);
+  req->download_path = *v8::String::Utf8Value(args[1]);
 
-  /* SSL Configuration */
-  if (args[2]->IsObject()) {
-    ssl_config = SSLConfigConverter::convert(isolate, args[2]);
-    if (!ssl_config) {
+  if (!client_request_args(isolate, args[2], args[3], args[4], req.get(),
+      &ssl_config))
+    return;
+
+  if (ssl_config && ssl_config->se_config.use_se) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+      isolate, "Downloads cannot use the Secure Element")));
+    return;
+  }
+  free_ssl_certs(ssl_config.get());
+
+  auto resume = js_object_attribute_to_cpp<bool>(args[4], "resume");
+  auto sha256 = js_object_attribute_to_cpp<bool>(args[4], "sha256");
+  auto sync = js_object_attribute_to_cpp<Local<Value>>(args[4], "sync");
+  auto interval = js_object_attribute_to_cpp<uint32_t>(args[4],
+      "progress_interval");
+
+  req->download_resume = resume && resume.value();
+  req->download_sha256 = sha256 && sha256.value();
+  req->progress_interval = interval ? interval.value() : 0;
+
+  /* "end" by default, "none" or a number of bytes between two syncs */
+  if (sync && sync.value()->IsNumber() && sync.value()->NumberValue() > 0) {
+    req->download_sync = sync.value()->NumberValue();
+  } else if (sync && sync.value()->IsString()) {
+    std::string policy(*v8::String::Utf8Value(sync.value()));
+
+    if (policy == "none") {
+      req->download_sync = -1;
+    } else if (policy != "end") {
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Wrong sync policy")));
       return;
     }
+  } else if (sync && !sync.value()->IsUndefined()) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+      isolate, "Wrong sync policy")));
+    return;
+  }
+
+  uint64_t id = obj->m_next_request++;
+
+  if (args[5]->IsFunction()) {
+    obj->m_progress[id] = new Nan::Callback(args[5].As<Function>());
+    req->progress = [obj, id](uint64_t received, uint64_t total) {
+      obj->post_task([obj, id, received, total]() {
+        auto it = obj->m_progress.find(id);
+
+        if (it == obj->m_progress.end())
+          return;
+
+        Nan::HandleScope scope;
+        Local<Value> argv[2] = {
+          Nan::New<Number>(received),
+          Nan::New<Number>(total)
+        };
+
+        it->second->Call(2, argv);
+      });
+    };
   }
 
-  /* If callback is provided, make the call asynchronous */
-  if (args[3]->IsFunction()) {
-    obj->m_response_del_cb = new v8::Persistent<v8::Function>();
-    obj->m_response_del_cb->Reset(isolate, Local<Function>::Cast(args[3]));
+  if (!obj->client()->submit(id, std::move(req), &error)) {
+    obj->release_progress(id);
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+      isolate, error.c_str())));
+    return;
+  }
 
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    artik_error ret =
-      http->del_async(url, headers, http_response_del_callback,
-                      reinterpret_cast<void*>(obj), ssl_config.get());
+  obj->track_request(id, args[6].As<Function>());
+  args.GetReturnValue().Set(Number::New(isolate, id));
+}
+
+void HttpWrapper::cancel(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
+  if (!args[0]->IsNumber()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+      isolate, "Wrong arguments")));
+    return;
+  }
 
-  } else { /* Otherwise make the call directly */
-    v8::String::Utf8Value param0(args[0]->ToString());
-    const char *url = *param0;
-    char *response = NULL;
-    artik_error ret = S_OK;
+  uint64_t id = args[0]->NumberValue();
+  HttpClient::Response response;
 
-    ret = http->del(url, headers, &response, NULL, ssl_config.get());
+  /* Settle right away, the transfer result is dropped if it races */
+  if (obj->m_client)
+    obj->m_client->cancel(id);
 
-    if (ret != S_OK)
-      response = strndup(error_msg(ret), MAX_ERRR_MSG_LEN);
+  auto sdk = obj->m_sdk_requests.find(id);
 
-    args.GetReturnValue().Set(String::NewFromUtf8(isolate, response));
+  if (sdk != obj->m_sdk_requests.end())
+    http_sdk_stop_timer(sdk->second);
 
-    free(response);
+  response.result = HttpClient::CANCELLED;
+  response.error = "Request cancelled";
+  obj->finish_request(id, &response);
+}
+
+/* A chunk of a streamed body, pinned until the client is done with it */
+struct HttpPinnedChunk {
+  Nan::Persistent<Object> buffer;
+  Nan::Callback callback;
+};
+
+void HttpWrapper::write_body(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
+
+  if (!args[0]->IsNumber() || !node::Buffer::HasInstance(args[1])) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+      isolate, "Wrong arguments")));
+    return;
   }
+
+  uint64_t id = args[0]->NumberValue();
+  HttpPinnedChunk* chunk = new HttpPinnedChunk();
+
+  chunk->buffer.Reset(args[1].As<Object>());
+  if (args[2]->IsFunction())
+    chunk->callback.Reset(args[2].As<Function>());
+
+  obj->client()->write_body(id, node::Buffer::Data(args[1]),
+      node::Buffer::Length(args[1]), [obj, chunk]() {
+        obj->post_task([chunk]() {
+          Nan::HandleScope scope;
+
+          chunk->buffer.Reset();
+          if (!chunk->callback.IsEmpty())
+            chunk->callback.Call(0, NULL);
+          delete chunk;
+        });
+      });
+}
+
+void HttpWrapper::end_body(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
+
+  if (!args[0]->IsNumber()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+      isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (obj->m_client)
+    obj->m_client->end_body(args[0]->NumberValue());
+}
+
+void HttpWrapper::get_pool_stats(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HttpWrapper* obj = ObjectWrap::Unwrap<HttpWrapper>(args.Holder());
+  HttpClient::Stats stats = {};
+  Local<Object> result = Object::New(isolate);
+
+  if (obj->m_client)
+    stats = obj->m_client->stats();
+
+  double requests = stats.requests;
+  double reused = stats.requests - stats.connections;
+
+  result->Set(String::NewFromUtf8(isolate, "requests"),
+              Number::New(isolate, requests));
+  result->Set(String::NewFromUtf8(isolate, "connections"),
+              Number::New(isolate, stats.connections));
+  result->Set(String::NewFromUtf8(isolate, "reused"),
+              Number::New(isolate, reused));
+  result->Set(String::NewFromUtf8(isolate, "reuse_ratio"),
+              Number::New(isolate, requests ? reused / requests : 0));
+  result->Set(String::NewFromUtf8(isolate, "handshakes"),
+              Number::New(isolate, stats.handshakes));
+
+  args.GetReturnValue().Set(result);
 }
 
 }  // namespace artik
@@ -20,35 +20,51 @@
 #define ADDON_HTTP_HTTP_H_
 
 #include <node.h>
+#include <nan.h>
 #include <node_object_wrap.h>
 #include <uv.h>
 
 #include <artik_http.hh>
 
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
 #include <utils.h>
 
 #include <loop.h>
 
+#include "http/http_client.h"
+
 namespace artik {
 
+struct HttpSdkRequest;
+
 class HttpWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object> exports);
 
   Http* getObj() { return m_http; }
-  v8::Persistent<v8::Function>* getDataCb() { return m_data_cb; }
-  v8::Persistent<v8::Function>* getErrorCb() { return m_error_cb; }
-  v8::Persistent<v8::Function>* getResponseGetCb()
+  v8::Persistent<v8::Function>& getDataCb() { return m_data_cb; }
+  v8::Persistent<v8::Function>& getErrorCb() { return m_error_cb; }
+  v8::Persistent<v8::Function>& getResponseGetCb()
                                                 { return m_response_get_cb; }
-  v8::Persistent<v8::Function>* getResponsePostCb()
+  v8::Persistent<v8::Function>& getResponsePostCb()
                                                 { return m_response_post_cb; }
-  v8::Persistent<v8::Function>* getResponsePutCb()
+  v8::Persistent<v8::Function>& getResponsePutCb()
                                                 { return m_response_put_cb; }
-  v8::Persistent<v8::Function>* getResponseDelCb()
+  v8::Persistent<v8::Function>& getResponseDelCb()
                                                 { return m_response_del_cb; }
 
+  void finish_request(uint64_t id, HttpClient::Response* response);
+  /* The SDK is done with a Secure Element request, even a settled one */
+  void release_sdk_request(HttpSdkRequest* req);
+
  private:
-  HttpWrapper();
+  explicit HttpWrapper(const HttpClient::Options& options);
   ~HttpWrapper();
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -59,15 +75,46 @@ class HttpWrapper : public node::ObjectWrap {
   static void post(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void put(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void del(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void request(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void cancel(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void write_body(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void end_body(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void download(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_pool_stats(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  static void request_async_cb(uv_async_t* handle);
+  void on_request_done(uint64_t id, HttpClient::Response* response);
+  HttpClient* client();
+  void post_task(std::function<void()> task);
+  void release_body(uint64_t id);
+  void release_progress(uint64_t id);
+  void track_request(uint64_t id, v8::Local<v8::Function> callback);
 
   Http* m_http;
-  v8::Persistent<v8::Function>* m_data_cb;
-  v8::Persistent<v8::Function>* m_error_cb;
-  v8::Persistent<v8::Function>* m_response_get_cb;
-  v8::Persistent<v8::Function>* m_response_post_cb;
-  v8::Persistent<v8::Function>* m_response_put_cb;
-  v8::Persistent<v8::Function>* m_response_del_cb;
+  /* Latest callbacks of the callback forms, replaced by each call */
+  v8::Persistent<v8::Function> m_data_cb;
+  v8::Persistent<v8::Function> m_error_cb;
+  v8::Persistent<v8::Function> m_response_get_cb;
+  v8::Persistent<v8::Function> m_response_post_cb;
+  v8::Persistent<v8::Function> m_response_put_cb;
+  v8::Persistent<v8::Function> m_response_del_cb;
   GlibLoop* m_loop;
+
+  /* Requests started by request(), by identifier */
+  HttpClient* m_client;
+  HttpClient::Options m_client_options;
+  std::map<uint64_t, Nan::Callback*> m_requests;
+  std::map<uint64_t, Nan::Callback*> m_progress;
+  /* Secure Element requests until the SDK calls back, holding a Ref() */
+  std::map<uint64_t, HttpSdkRequest*> m_sdk_requests;
+  /* Buffer bodies, pinned until the transfer is over */
+  std::map<uint64_t, Nan::Persistent<v8::Object>*> m_bodies;
+  uint64_t m_next_request;
+  bool m_busy;
+  uv_async_t* m_async;
+  /* Work handed over by the client thread */
+  std::mutex m_tasks_lock;
+  std::deque<std::function<void()>> m_tasks;
 };
 
 }  // namespace artik
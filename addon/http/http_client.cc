@@ -0,0 +1,1112 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "http/http_client.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <utility>
+
+#include "base/sha256.h"
+#include "http/header_arena.h"
+
+/* Announced lengths are not trusted beyond this */
+#define MAX_BODY_RESERVE (16 * 1024 * 1024)
+
+/* In-memory PEM options, 0 where the libcurl headers predate them */
+#if LIBCURL_VERSION_NUM >= 0x074d00
+#define CAINFO_BLOB CURLOPT_CAINFO_BLOB
+#else
+#define CAINFO_BLOB 0
+#endif
+#if LIBCURL_VERSION_NUM >= 0x074700
+#define SSLCERT_BLOB CURLOPT_SSLCERT_BLOB
+#define SSLKEY_BLOB CURLOPT_SSLKEY_BLOB
+#else
+#define SSLCERT_BLOB 0
+#define SSLKEY_BLOB 0
+#endif
+
+namespace artik {
+
+struct HttpBodyChunk {
+  const char* data;
+  size_t size;
+  size_t offset;
+  HttpClient::Consumed consumed;
+};
+
+struct HttpBodyStream {
+  std::mutex lock;
+  std::deque<HttpBodyChunk> chunks;
+  bool ended;
+  bool paused;
+};
+
+/*
+ * Runs the disk work of downloads that may stall for long, flushes and
+ * digests of data already on disk, away from the client thread shared by
+ * all the transfers. Jobs run in order, all of them before it goes away.
+ */
+class HttpDiskWorker {
+ public:
+  HttpDiskWorker() : m_quit(false) {}
+
+  ~HttpDiskWorker() {
+    {
+      std::lock_guard<std::mutex> l(m_lock);
+      m_quit = true;
+    }
+    m_cond.notify_one();
+    if (m_thread.joinable())
+      m_thread.join();
+  }
+
+  void post(std::function<void()> job) {
+    {
+      std::lock_guard<std::mutex> l(m_lock);
+      m_jobs.push_back(job);
+      if (!m_thread.joinable())
+        m_thread = std::thread(&HttpDiskWorker::run, this);
+    }
+    m_cond.notify_one();
+  }
+
+ private:
+  void run() {
+    for (;;) {
+      std::function<void()> job;
+
+      {
+        std::unique_lock<std::mutex> l(m_lock);
+
+        m_cond.wait(l, [this] { return m_quit || !m_jobs.empty(); });
+        if (m_jobs.empty())
+          return;
+        job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+      }
+
+      job();
+    }
+  }
+
+  std::thread m_thread;
+  std::mutex m_lock;
+  std::condition_variable m_cond;
+  std::deque<std::function<void()>> m_jobs;
+  bool m_quit;
+};
+
+struct HttpTransfer {
+  uint64_t id;
+  std::unique_ptr<HttpClient::Request> request;
+  CURL* easy;
+  /* Own lines, their tail linked to the shared headers if any */
+  struct curl_slist* headers;
+  struct curl_slist* tail;
+  char error[CURL_ERROR_SIZE];
+  /* BODY_FILE, read as it is sent */
+  int body_fd;
+  uint64_t body_offset;
+  uint64_t body_size;
+  std::shared_ptr<HttpBodyStream> stream;
+  HttpClient::Response response;
+  /* Download mode */
+  HttpDiskWorker* disk;
+  int fd;
+  bool started;
+  bool created;
+  /* The server answered the Range wrong, the request is sent again */
+  bool restart;
+  /* Resumed with a digest, the whole file is read once complete */
+  bool rehash;
+  /* A flush is queued on the disk worker, the next one waits for it */
+  std::atomic<bool> sync_queued;
+  uint64_t offset;
+  uint64_t received;
+  uint64_t total;
+  uint64_t unsynced;
+  std::unique_ptr<Sha256> sha256;
+  std::chrono::steady_clock::time_point progress_time;
+  /* Takes over the libcurl message when a callback failed */
+  std::string failure;
+};
+
+/* Detach the shared headers first, they are not ours to free */
+static void free_headers(HttpTransfer* transfer) {
+  if (transfer->tail)
+    transfer->tail->next = NULL;
+  curl_slist_free_all(transfer->headers);
+}
+
+static bool is_success(long status) {
+  return status >= 200 && status < 300;
+}
+
+static const std::string* find_header(const HttpClient::Response& response,
+    const char* name) {
+  for (auto& header : response.headers) {
+    if (strcasecmp(header.first.c_str(), name) == 0)
+      return &header.second;
+  }
+
+  return NULL;
+}
+
+static bool hash_file(int fd, uint64_t size, Sha256* sha256) {
+  char buf[64 * 1024];
+  uint64_t done = 0;
+
+  while (done < size) {
+    ssize_t n = pread(fd, buf, std::min<uint64_t>(sizeof(buf), size - done),
+        done);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    sha256->update(buf, n);
+    done += n;
+  }
+
+  return true;
+}
+
+/*
+ * Open the file once the status is known, so that an error page leaves
+ * it untouched. A 206 carries on after what the file holds, whatever
+ * else starts over, a 206 for another range by sending the request again
+ * without one. A 416 tells the file is already complete when the remote
+ * size matches it.
+ */
+static bool begin_download(HttpTransfer* transfer, long status) {
+  const HttpClient::Request* req = transfer->request.get();
+  const std::string* range =
+      find_header(transfer->response, "Content-Range");
+  bool resume = false;
+
+  transfer->started = true;
+
+  if (transfer->offset && range) {
+    unsigned long long first = 0;
+    unsigned long long size = 0;
+
+    if (status == 206)
+      resume = sscanf(range->c_str(), "bytes %llu-", &first) == 1 &&
+          first == transfer->offset;
+    else if (status == 416)
+      resume = sscanf(range->c_str(), "bytes */%llu", &size) == 1 &&
+          size == transfer->offset;
+  }
+
+  if (status == 416 && !resume)
+    return true;
+
+  if (status == 206 && !resume) {
+    transfer->failure = "Unexpected partial content for " +
+        req->download_path;
+    /* Only once, and as long as the body can be sent again */
+    transfer->restart = transfer->offset &&
+        req->body_type != HttpClient::BODY_STREAM;
+    return false;
+  }
+
+  if (resume) {
+    transfer->fd = open(req->download_path.c_str(),
+        O_RDWR | O_APPEND | O_CLOEXEC);
+  } else {
+    transfer->offset = 0;
+    transfer->created = access(req->download_path.c_str(), F_OK) != 0;
+    transfer->fd = open(req->download_path.c_str(),
+        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  }
+
+  if (transfer->fd < 0) {
+    transfer->failure = "Cannot open " + req->download_path + ": " +
+        strerror(errno);
+    return false;
+  }
+
+  /* Reading back what the file holds could stall the other transfers */
+  if (req->download_sha256 && resume)
+    transfer->rehash = true;
+  else if (req->download_sha256)
+    transfer->sha256.reset(new Sha256());
+
+  transfer->response.resumed = resume;
+
+  /* Nothing to write, the body of a 416 is not part of the file */
+  if (status == 416) {
+    close(transfer->fd);
+    transfer->fd = -1;
+    return true;
+  }
+
+#if LIBCURL_VERSION_NUM >= 0x073700
+  curl_off_t length = -1;
+
+  curl_easy_getinfo(transfer->easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+      &length);
+#else
+  double length = -1;
+
+  curl_easy_getinfo(transfer->easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD,
+      &length);
+#endif
+  transfer->total = length >= 0 ? transfer->offset + length : 0;
+  return true;
+}
+
+static bool write_download(HttpTransfer* transfer, const char* data,
+    size_t size) {
+  const HttpClient::Request* req = transfer->request.get();
+
+  for (size_t done = 0; done < size;) {
+    ssize_t n = write(transfer->fd, data + done, size - done);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0) {
+      transfer->failure = "Cannot write " + req->download_path + ": " +
+          strerror(errno);
+      return false;
+    }
+    done += n;
+  }
+
+  if (transfer->sha256)
+    transfer->sha256->update(data, size);
+  transfer->received += size;
+  transfer->unsynced += size;
+
+  if (req->download_sync > 0 &&
+      transfer->unsynced >= static_cast<uint64_t>(req->download_sync)) {
+    transfer->unsynced = 0;
+    /* The file is closed by a later job, once the transfer is over */
+    if (!transfer->sync_queued.exchange(true)) {
+      transfer->disk->post([transfer] {
+        fdatasync(transfer->fd);
+        transfer->sync_queued = false;
+      });
+    }
+  }
+
+  if (req->progress) {
+    auto now = std::chrono::steady_clock::now();
+
+    if (now - transfer->progress_time >=
+        std::chrono::milliseconds(req->progress_interval)) {
+      transfer->progress_time = now;
+      req->progress(transfer->offset + transfer->received, transfer->total);
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Flush as the policy says, a failed transfer keeps what it got. Runs on
+ * the disk worker.
+ */
+static void end_download(HttpTransfer* transfer, bool ok) {
+  const HttpClient::Request* req = transfer->request.get();
+  HttpClient::Response* response = &transfer->response;
+
+  response->download = true;
+  response->file_size = transfer->offset + transfer->received;
+  if (ok && transfer->sha256)
+    response->sha256 = transfer->sha256->hex_digest();
+
+  if (ok && transfer->rehash) {
+    int fd = open(req->download_path.c_str(), O_RDONLY | O_CLOEXEC);
+    Sha256 sha256;
+
+    if (fd >= 0 && hash_file(fd, response->file_size, &sha256)) {
+      response->sha256 = sha256.hex_digest();
+    } else {
+      response->result = HttpClient::FAILED;
+      response->error = "Cannot read " + req->download_path;
+    }
+    if (fd >= 0)
+      close(fd);
+  }
+
+  if (transfer->fd < 0)
+    return;
+
+  if (req->download_sync >= 0)
+    fsync(transfer->fd);
+  close(transfer->fd);
+  transfer->fd = -1;
+
+  /* Make the new directory entry durable too */
+  if (transfer->created && req->download_sync >= 0) {
+    size_t slash = req->download_path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." :
+        slash == 0 ? "/" : req->download_path.substr(0, slash);
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd >= 0) {
+      fsync(fd);
+      close(fd);
+    }
+  }
+}
+
+static std::once_flag curl_init;
+
+static size_t on_body(char* data, size_t size, size_t nmemb, void* user) {
+  HttpTransfer* transfer = reinterpret_cast<HttpTransfer*>(user);
+
+  if (!transfer->request->download_path.empty()) {
+    if (!transfer->started) {
+      long status = 0;
+
+      curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &status);
+      if ((is_success(status) || status == 416) &&
+          !begin_download(transfer, status))
+        return 0;
+      transfer->started = true;
+    }
+
+    if (transfer->fd >= 0)
+      return write_download(transfer, data, size * nmemb) ? size * nmemb : 0;
+  }
+
+  transfer->response.body.append(data, size * nmemb);
+  return size * nmemb;
+}
+
+static size_t on_header(char* data, size_t size, size_t nmemb, void* user) {
+  HttpTransfer* transfer = reinterpret_cast<HttpTransfer*>(user);
+  HttpClient::Response* response = &transfer->response;
+  size_t len = size * nmemb;
+  std::string line(data, len);
+  size_t colon = line.find(':');
+
+  /* A new status line, after an interim response such as 100 Continue */
+  if (line.compare(0, 5, "HTTP/") == 0) {
+    response->headers.clear();
+    return len;
+  }
+
+  if (colon == std::string::npos || colon == 0)
+    return len;
+
+  std::string name(line, 0, colon);
+  size_t start = line.find_first_not_of(" \t", colon + 1);
+  size_t end = line.find_last_not_of(" \t\r\n");
+  std::string value;
+
+  if (start != std::string::npos && end != std::string::npos && start <= end)
+    value.assign(line, start, end - start + 1);
+
+  /* Grow the body once rather than as it comes */
+  if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+    uint64_t length = strtoull(value.c_str(), NULL, 10);
+
+    response->body.reserve(std::min<uint64_t>(length, MAX_BODY_RESERVE));
+  }
+
+  response->headers.push_back(std::make_pair(name, value));
+  return len;
+}
+
+static size_t on_upload(char* out, size_t size, size_t nmemb, void* user) {
+  HttpBodyStream* stream =
+      reinterpret_cast<HttpTransfer*>(user)->stream.get();
+  std::vector<HttpClient::Consumed> consumed;
+  size_t max = size * nmemb;
+  size_t len = 0;
+  bool pause = false;
+
+  {
+    std::lock_guard<std::mutex> l(stream->lock);
+
+    while (len < max && !stream->chunks.empty()) {
+      HttpBodyChunk& chunk = stream->chunks.front();
+      size_t n = std::min(max - len, chunk.size - chunk.offset);
+
+      memcpy(out + len, chunk.data + chunk.offset, n);
+      len += n;
+      chunk.offset += n;
+      if (chunk.offset == chunk.size) {
+        consumed.push_back(chunk.consumed);
+        stream->chunks.pop_front();
+      }
+    }
+
+    /* Wait for the next chunk, an empty read would end the body */
+    if (len == 0 && !stream->ended)
+      pause = stream->paused = true;
+  }
+
+  for (auto& cb : consumed)
+    cb();
+
+  return pause ? CURL_READFUNC_PAUSE : len;
+}
+
+/*
+ * A file that shrinks while being sent fails the transfer: the announced
+ * length can no longer be honoured.
+ */
+static size_t on_upload_file(char* out, size_t size, size_t nmemb,
+    void* user) {
+  HttpTransfer* transfer = reinterpret_cast<HttpTransfer*>(user);
+  size_t max = std::min<uint64_t>(size * nmemb,
+      transfer->body_size - transfer->body_offset);
+  ssize_t ret;
+
+  if (!max)
+    return 0;
+
+  do {
+    ret = pread(transfer->body_fd, out, max, transfer->body_offset);
+  } while (ret < 0 && errno == EINTR);
+
+  if (ret < 0) {
+    transfer->failure = "Cannot read " + transfer->request->body + ": " +
+        strerror(errno);
+    return CURL_READFUNC_ABORT;
+  }
+  if (ret == 0) {
+    transfer->failure = transfer->request->body +
+        " was truncated while being sent";
+    return CURL_READFUNC_ABORT;
+  }
+
+  transfer->body_offset += ret;
+  return ret;
+}
+
+/*
+ * Rewinds the file when libcurl sends the body again, e.g. when a reused
+ * connection was closed by the server or an authentication needs a retry.
+ * Redirects are not followed.
+ */
+static int on_seek_file(void* user, curl_off_t offset, int origin) {
+  HttpTransfer* transfer = reinterpret_cast<HttpTransfer*>(user);
+
+  if (origin != SEEK_SET || offset < 0 ||
+      static_cast<uint64_t>(offset) > transfer->body_size)
+    return CURL_SEEKFUNC_FAIL;
+
+  transfer->body_offset = offset;
+  return CURL_SEEKFUNC_OK;
+}
+
+static void release_stream(HttpBodyStream* stream) {
+  std::deque<HttpBodyChunk> chunks;
+
+  {
+    std::lock_guard<std::mutex> l(stream->lock);
+    chunks.swap(stream->chunks);
+    stream->ended = true;
+  }
+
+  for (auto& chunk : chunks)
+    chunk.consumed();
+}
+
+HttpClient::HttpClient(const Options& options, Callback done)
+  : m_done(done),
+    m_options(options),
+    m_quit(false),
+    m_stats(),
+    m_disk(new HttpDiskWorker()) {
+  std::call_once(curl_init, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+  m_multi = curl_multi_init();
+  if (m_multi) {
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+        options.max_host_connections);
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+        options.max_total_connections);
+    if (options.max_idle_connections)
+      curl_multi_setopt(m_multi, CURLMOPT_MAXCONNECTS,
+          options.max_idle_connections);
+  }
+
+  /* Only the client thread uses the handles, no locking needed */
+  m_share = curl_share_init();
+  if (m_share) {
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  }
+
+  if (pipe2(m_wakeup, O_NONBLOCK | O_CLOEXEC) < 0)
+    m_wakeup[0] = m_wakeup[1] = -1;
+  m_thread = std::thread(&HttpClient::run, this);
+}
+
+HttpClient::~HttpClient() {
+  {
+    std::lock_guard<std::mutex> l(m_lock);
+    m_quit = true;
+  }
+  wakeup();
+  m_thread.join();
+  /* Finishes the downloads already over, before their files go away */
+  m_disk.reset();
+
+  /* Nobody listens for the results anymore */
+  for (auto& item : m_running) {
+    curl_multi_remove_handle(m_multi, item.second->easy);
+    curl_easy_cleanup(item.second->easy);
+    free_headers(item.second);
+    if (item.second->body_fd >= 0)
+      close(item.second->body_fd);
+    if (item.second->fd >= 0)
+      close(item.second->fd);
+    delete item.second;
+  }
+  for (auto transfer : m_pending)
+    delete transfer;
+
+  curl_multi_cleanup(m_multi);
+  curl_share_cleanup(m_share);
+  for (auto& item : m_pem_files)
+    unlink(item.second.c_str());
+  close(m_wakeup[0]);
+  close(m_wakeup[1]);
+}
+
+bool HttpClient::submit(uint64_t id, std::unique_ptr<Request> request,
+    std::string* error) {
+  if (m_wakeup[0] < 0 || !m_multi) {
+    *error = "HTTP client not available";
+    return false;
+  }
+
+  HttpTransfer* transfer = new HttpTransfer();
+
+  transfer->id = id;
+  transfer->request = std::move(request);
+  transfer->easy = NULL;
+  transfer->headers = NULL;
+  transfer->tail = NULL;
+  transfer->error[0] = '\0';
+  transfer->body_fd = -1;
+  transfer->body_offset = 0;
+  transfer->body_size = 0;
+  transfer->disk = m_disk.get();
+  transfer->fd = -1;
+  transfer->started = false;
+  transfer->created = false;
+  transfer->restart = false;
+  transfer->rehash = false;
+  transfer->sync_queued = false;
+  transfer->offset = 0;
+  transfer->received = 0;
+  transfer->total = 0;
+  transfer->unsynced = 0;
+  if (transfer->request->body_type == BODY_STREAM) {
+    transfer->stream = std::make_shared<HttpBodyStream>();
+    transfer->stream->ended = false;
+    transfer->stream->paused = false;
+  }
+
+  {
+    std::lock_guard<std::mutex> l(m_lock);
+    m_pending.push_back(transfer);
+    if (transfer->stream)
+      m_streams[id] = transfer->stream;
+  }
+  wakeup();
+
+  return true;
+}
+
+void HttpClient::cancel(uint64_t id) {
+  {
+    std::lock_guard<std::mutex> l(m_lock);
+    m_cancelled.push_back(id);
+  }
+  wakeup();
+}
+
+void HttpClient::write_body(uint64_t id, const char* data, size_t size,
+    Consumed consumed) {
+  std::shared_ptr<HttpBodyStream> stream;
+  bool resume = false;
+
+  {
+    std::lock_guard<std::mutex> l(m_lock);
+    auto it = m_streams.find(id);
+
+    if (it != m_streams.end())
+      stream = it->second;
+  }
+
+  if (stream) {
+    std::lock_guard<std::mutex> l(stream->lock);
+
+    if (!stream->ended) {
+      HttpBodyChunk chunk = { data, size, 0, consumed };
+
+      stream->chunks.push_back(chunk);
+      resume = stream->paused;
+      stream->paused = false;
+      consumed = nullptr;
+    }
+  }
+
+  /* The transfer is over */
+  if (consumed) {
+    consumed();
+    return;
+  }
+
+  if (resume) {
+    {
+      std::lock_guard<std::mutex> l(m_lock);
+      m_resumed.push_back(id);
+    }
+    wakeup();
+  }
+}
+
+void HttpClient::end_body(uint64_t id) {
+  std::shared_ptr<HttpBodyStream> stream;
+  bool resume = false;
+
+  {
+    std::lock_guard<std::mutex> l(m_lock);
+    auto it = m_streams.find(id);
+
+    if (it == m_streams.end())
+      return;
+    stream = it->second;
+  }
+
+  {
+    std::lock_guard<std::mutex> l(stream->lock);
+    stream->ended = true;
+    resume = stream->paused;
+    stream->paused = false;
+  }
+
+  if (resume) {
+    {
+      std::lock_guard<std::mutex> l(m_lock);
+      m_resumed.push_back(id);
+    }
+    wakeup();
+  }
+}
+
+HttpClient::Stats HttpClient::stats() {
+  std::lock_guard<std::mutex> l(m_lock);
+
+  return m_stats;
+}
+
+void HttpClient::wakeup() {
+  char c = 0;
+
+  if (write(m_wakeup[1], &c, 1) < 0) {
+    /* The pipe is full, a wake up is already pending */
+  }
+}
+
+bool HttpClient::start(HttpTransfer* transfer) {
+  Request* req = transfer->request.get();
+  CURL* easy = curl_easy_init();
+
+  if (!easy)
+    return false;
+
+  transfer->easy = easy;
+  curl_easy_setopt(easy, CURLOPT_PRIVATE, transfer);
+  curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer->error);
+  curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(easy, CURLOPT_URL, req->url.c_str());
+  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, on_body);
+  curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer);
+  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, on_header);
+  curl_easy_setopt(easy, CURLOPT_HEADERDATA, transfer);
+  curl_easy_setopt(easy, CURLOPT_SHARE, m_share);
+  curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+#if LIBCURL_VERSION_NUM >= 0x074100
+  if (m_options.keep_alive)
+    curl_easy_setopt(easy, CURLOPT_MAXAGE_CONN,
+        (m_options.keep_alive + 999) / 1000);
+#endif
+
+  if (req->method == "POST")
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+  else if (req->method != "GET")
+    curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, req->method.c_str());
+
+  const char* body = NULL;
+  size_t body_size = 0;
+
+  switch (req->body_type) {
+  case BODY_NONE:
+    break;
+  case BODY_STRING:
+    body = req->body.data();
+    body_size = req->body.size();
+    break;
+  case BODY_BUFFER:
+    body = req->body_data ? req->body_data : "";
+    body_size = req->body_size;
+    break;
+  case BODY_FILE: {
+    int fd = open(req->body.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st) < 0) {
+      snprintf(transfer->error, CURL_ERROR_SIZE, "Cannot open %s: %s",
+          req->body.c_str(), strerror(errno));
+      if (fd >= 0)
+        close(fd);
+      return false;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    transfer->body_fd = fd;
+    transfer->body_size = st.st_size;
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy, CURLOPT_READFUNCTION, on_upload_file);
+    curl_easy_setopt(easy, CURLOPT_READDATA, transfer);
+    curl_easy_setopt(easy, CURLOPT_SEEKFUNCTION, on_seek_file);
+    curl_easy_setopt(easy, CURLOPT_SEEKDATA, transfer);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE,
+        static_cast<curl_off_t>(st.st_size));
+    break;
+  }
+  case BODY_STREAM:
+    curl_easy_setopt(easy, CURLOPT_POST, 1L);
+    curl_easy_setopt(easy, CURLOPT_READFUNCTION, on_upload);
+    curl_easy_setopt(easy, CURLOPT_READDATA, transfer);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE,
+        static_cast<curl_off_t>(-1));
+    break;
+  }
+
+  if (body) {
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE,
+        static_cast<curl_off_t>(body_size));
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, body);
+  }
+
+  for (auto& header : req->headers)
+    transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+  if (!req->download_path.empty() && req->download_resume) {
+    struct stat st;
+
+    if (stat(req->download_path.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+        st.st_size > 0) {
+      std::string range = "Range: bytes=" + std::to_string(st.st_size) + "-";
+
+      transfer->offset = st.st_size;
+      transfer->headers = curl_slist_append(transfer->headers, range.c_str());
+    }
+  }
+  /* Send the body right away rather than waiting for 100 Continue */
+  if (req->body_type != BODY_NONE)
+    transfer->headers = curl_slist_append(transfer->headers, "Expect:");
+
+  struct curl_slist* shared =
+      req->shared_headers ? req->shared_headers->curl() : NULL;
+  struct curl_slist* list = transfer->headers ? transfer->headers : shared;
+
+  if (transfer->headers && shared) {
+    for (transfer->tail = transfer->headers; transfer->tail->next;
+        transfer->tail = transfer->tail->next) {}
+    transfer->tail->next = shared;
+  }
+  curl_easy_setopt(easy, CURLOPT_HTTPHEADER, list);
+
+  if (req->connect_timeout)
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, req->connect_timeout);
+  if (req->timeout)
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, req->timeout);
+
+  /*
+   * Optional verification lets the handshake go on whatever the outcome,
+   * and libcurl has no way to verify without failing it: so only required
+   * verification checks anything.
+   */
+  curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER,
+      req->verify == VERIFY_REQUIRED ? 1L : 0L);
+  curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST,
+      req->verify == VERIFY_REQUIRED ? 2L : 0L);
+
+  if (!req->ca_cert.empty() &&
+      !set_pem(transfer, CAINFO_BLOB, CURLOPT_CAINFO, &req->ca_cert))
+    return false;
+  if (!req->client_cert.empty()) {
+    if (!set_pem(transfer, SSLCERT_BLOB, CURLOPT_SSLCERT, &req->client_cert))
+      return false;
+    curl_easy_setopt(easy, CURLOPT_SSLCERTTYPE, "PEM");
+  }
+  if (!req->client_key.empty()) {
+    /* Unlike the certificates, the key never goes through a file */
+    if (!set_pem_blob(transfer, SSLKEY_BLOB, &req->client_key)) {
+      snprintf(transfer->error, CURL_ERROR_SIZE,
+          "In-memory client keys need libcurl 7.71.0 or newer");
+      return false;
+    }
+    curl_easy_setopt(easy, CURLOPT_SSLKEYTYPE, "PEM");
+  }
+
+  if (curl_multi_add_handle(m_multi, easy) != CURLM_OK)
+    return false;
+
+  m_running[transfer->id] = transfer;
+  return true;
+}
+
+bool HttpClient::set_pem_blob(HttpTransfer* transfer, int blob_option,
+    std::string* pem) {
+#if LIBCURL_VERSION_NUM >= 0x074700
+  struct curl_blob blob = { &(*pem)[0], pem->size(), CURL_BLOB_COPY };
+
+  /* The library may still be older than the headers */
+  return blob_option && curl_easy_setopt(transfer->easy,
+      static_cast<CURLoption>(blob_option), &blob) == CURLE_OK;
+#else
+  return false;
+#endif
+}
+
+bool HttpClient::set_pem(HttpTransfer* transfer, int blob_option,
+    CURLoption file_option, std::string* pem) {
+  if (set_pem_blob(transfer, blob_option, pem))
+    return true;
+
+  /*
+   * Otherwise go through a private file, one per distinct content so that
+   * the connections and sessions set up with it can still be reused.
+   */
+  Sha256 hash;
+
+  hash.update(pem->data(), pem->size());
+
+  std::string digest = hash.hex_digest();
+  auto it = m_pem_files.find(digest);
+
+  if (it == m_pem_files.end()) {
+    const char* dir = getenv("TMPDIR");
+    std::string path = std::string(dir && *dir ? dir : "/tmp") +
+        "/artik-http-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    size_t written = 0;
+
+    while (fd >= 0 && written < pem->size()) {
+      ssize_t ret = write(fd, pem->data() + written, pem->size() - written);
+
+      if (ret < 0 && errno == EINTR)
+        continue;
+      if (ret <= 0)
+        break;
+      written += ret;
+    }
+
+    if (fd < 0 || written < pem->size()) {
+      snprintf(transfer->error, CURL_ERROR_SIZE,
+          "Cannot store the certificate: %s", strerror(errno));
+      if (fd >= 0) {
+        close(fd);
+        unlink(path.c_str());
+      }
+      return false;
+    }
+
+    close(fd);
+    it = m_pem_files.insert(std::make_pair(digest, path)).first;
+  }
+
+  curl_easy_setopt(transfer->easy, file_option, it->second.c_str());
+  return true;
+}
+
+void HttpClient::complete(HttpTransfer* transfer, Result result,
+    const char* error) {
+  if (result != OK && !transfer->failure.empty())
+    error = transfer->failure.c_str();
+
+  if (transfer->easy) {
+    long status = 0;
+    long connects = 0;
+    double handshake = 0;
+
+    curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &status);
+    transfer->response.status = status;
+
+    /* An empty body never went through on_body() */
+    if (!transfer->request->download_path.empty() && result == OK &&
+        !transfer->started && (is_success(status) || status == 416) &&
+        !begin_download(transfer, status)) {
+      result = FAILED;
+      error = transfer->failure.c_str();
+    }
+
+    /* A reused connection reports neither a connect nor a handshake */
+    if (m_running.count(transfer->id)) {
+      curl_easy_getinfo(transfer->easy, CURLINFO_NUM_CONNECTS, &connects);
+      curl_easy_getinfo(transfer->easy, CURLINFO_APPCONNECT_TIME, &handshake);
+
+      std::lock_guard<std::mutex> l(m_lock);
+      m_stats.requests++;
+      m_stats.connections += connects;
+      if (connects && handshake > 0)
+        m_stats.handshakes++;
+    }
+
+    if (m_running.erase(transfer->id))
+      curl_multi_remove_handle(m_multi, transfer->easy);
+    curl_easy_cleanup(transfer->easy);
+    transfer->easy = NULL;
+  }
+  free_headers(transfer);
+  transfer->headers = transfer->tail = NULL;
+  if (transfer->body_fd >= 0)
+    close(transfer->body_fd);
+  transfer->body_fd = -1;
+
+  if (transfer->restart) {
+    restart(transfer);
+    return;
+  }
+
+  if (transfer->stream) {
+    {
+      std::lock_guard<std::mutex> l(m_lock);
+      m_streams.erase(transfer->id);
+    }
+    release_stream(transfer->stream.get());
+  }
+
+  transfer->response.result = result;
+  if (result != OK)
+    transfer->response.error = error;
+
+  if (!transfer->request->download_path.empty()) {
+    bool ok = result == OK;
+
+    m_disk->post([this, transfer, ok] {
+      end_download(transfer, ok);
+      m_done(transfer->id, &transfer->response);
+      delete transfer;
+    });
+    return;
+  }
+
+  m_done(transfer->id, &transfer->response);
+  delete transfer;
+}
+
+void HttpClient::restart(HttpTransfer* transfer) {
+  transfer->request->download_resume = false;
+  transfer->restart = false;
+  transfer->started = false;
+  transfer->offset = 0;
+  transfer->error[0] = '\0';
+  transfer->failure.clear();
+  transfer->response = Response();
+
+  if (!start(transfer))
+    complete(transfer, FAILED, transfer->error[0] ? transfer->error :
+        "Cannot start the HTTP request");
+}
+
+void HttpClient::run() {
+  for (;;) {
+    std::deque<HttpTransfer*> pending;
+    std::vector<uint64_t> cancelled;
+    std::vector<uint64_t> resumed;
+
+    {
+      std::lock_guard<std::mutex> l(m_lock);
+      if (m_quit)
+        return;
+      pending.swap(m_pending);
+      cancelled.swap(m_cancelled);
+      resumed.swap(m_resumed);
+    }
+
+    for (auto transfer : pending) {
+      if (!start(transfer))
+        complete(transfer, FAILED, transfer->error[0] ? transfer->error :
+            "Cannot start the HTTP request");
+    }
+
+    for (auto id : resumed) {
+      auto it = m_running.find(id);
+
+      if (it != m_running.end())
+        curl_easy_pause(it->second->easy, CURLPAUSE_CONT);
+    }
+
+    for (auto id : cancelled) {
+      auto it = m_running.find(id);
+
+      if (it != m_running.end())
+        complete(it->second, CANCELLED, "Request cancelled");
+    }
+
+    int running;
+    CURLMsg* msg;
+    int left;
+
+    curl_multi_perform(m_multi, &running);
+    while ((msg = curl_multi_info_read(m_multi, &left))) {
+      HttpTransfer* transfer;
+
+      if (msg->msg != CURLMSG_DONE)
+        continue;
+
+      CURLcode code = msg->data.result;
+
+      curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+      if (code == CURLE_OK)
+        complete(transfer, OK, NULL);
+      else
+        complete(transfer, code == CURLE_OPERATION_TIMEDOUT ? TIMED_OUT :
+            FAILED, transfer->error[0] ? transfer->error :
+            curl_easy_strerror(code));
+    }
+
+    struct curl_waitfd extra = { m_wakeup[0], CURL_WAIT_POLLIN, 0 };
+
+    curl_multi_wait(m_multi, &extra, 1, 1000, NULL);
+    if (extra.revents) {
+      char buf[64];
+
+      while (read(m_wakeup[0], buf, sizeof(buf)) > 0) {}
+    }
+  }
+}
+
+}  // namespace artik
@@ -0,0 +1,198 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_HTTP_HTTP_CLIENT_H_
+#define ADDON_HTTP_HTTP_CLIENT_H_
+
+#include <stdint.h>
+#include <curl/curl.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace artik {
+
+struct HttpTransfer;
+struct HttpBodyStream;
+class HttpDiskWorker;
+class HttpHeaderArena;
+
+/*
+ * Runs HTTP transfers with libcurl on a dedicated thread, so that DNS
+ * resolution, TLS handshakes and transfers never block the JS thread.
+ * Transfers may be aborted at any time and time out on their own. Results
+ * are handed to the completion callback on the client thread, or for
+ * downloads on a second thread flushing their files to the disk.
+ *
+ * Connections are kept alive in a pool shared by all the transfers of the
+ * client, and TLS sessions are cached so that a new connection to a known
+ * host resumes its session instead of running a full handshake.
+ */
+class HttpClient {
+ public:
+  enum Verify { VERIFY_NONE, VERIFY_OPTIONAL, VERIFY_REQUIRED };
+
+  enum BodyType { BODY_NONE, BODY_STRING, BODY_BUFFER, BODY_FILE,
+      BODY_STREAM };
+
+  struct Request {
+    std::string method;
+    std::string url;
+    /* Headers shared with other requests, sent after 'headers' */
+    std::shared_ptr<HttpHeaderArena> shared_headers;
+    /* "Name: value" lines */
+    std::vector<std::string> headers;
+    BodyType body_type;
+    /* The body itself, or the path of the file to send */
+    std::string body;
+    /* BODY_BUFFER, owned by the caller until the transfer completes */
+    const char* body_data;
+    size_t body_size;
+    /* In milliseconds, 0 for no limit */
+    long connect_timeout;
+    long timeout;
+    std::string ca_cert;
+    std::string client_cert;
+    std::string client_key;
+    Verify verify;
+    /*
+     * Download mode: the body of a 2xx response goes to this file, other
+     * bodies to the response. With 'download_resume', the transfer
+     * carries on from the current size of the file.
+     */
+    std::string download_path;
+    bool download_resume;
+    /* fdatasync() every that many bytes, 0 only once done, -1 never */
+    int64_t download_sync;
+    bool download_sha256;
+    /* Called from the client thread at most every 'progress_interval' ms */
+    std::function<void(uint64_t received, uint64_t total)> progress;
+    uint32_t progress_interval;
+
+    Request() : body_type(BODY_NONE), body_data(NULL), body_size(0),
+        connect_timeout(0), timeout(0), verify(VERIFY_NONE),
+        download_resume(false), download_sync(0), download_sha256(false),
+        progress_interval(0) {}
+  };
+
+  enum Result { OK, FAILED, TIMED_OUT, CANCELLED };
+
+  struct Response {
+    Result result;
+    std::string error;
+    int status;
+    std::string body;
+    /* Of the final response, in order of arrival */
+    std::vector<std::pair<std::string, std::string>> headers;
+    /* Download mode, 'file_size' counts the resumed part as well */
+    bool download;
+    bool resumed;
+    uint64_t file_size;
+    std::string sha256;
+
+    Response() : result(OK), status(0), download(false), resumed(false),
+        file_size(0) {}
+  };
+
+  struct Options {
+    /* 0 for no limit */
+    long max_host_connections;
+    long max_total_connections;
+    /* Idle connections kept in the pool */
+    long max_idle_connections;
+    /* Milliseconds an idle connection is kept, 0 for the libcurl default */
+    long keep_alive;
+
+    Options() : max_host_connections(0), max_total_connections(0),
+        max_idle_connections(0), keep_alive(0) {}
+  };
+
+  struct Stats {
+    uint64_t requests;
+    /* New connections, the other requests reused a pooled one */
+    uint64_t connections;
+    /* TLS handshakes, libcurl does not tell the resumed ones apart */
+    uint64_t handshakes;
+  };
+
+  typedef std::function<void(uint64_t id, Response* response)> Callback;
+  typedef std::function<void()> Consumed;
+
+  HttpClient(const Options& options, Callback done);
+  ~HttpClient();
+
+  /* 'id' identifies the transfer in the completion and in cancel() */
+  bool submit(uint64_t id, std::unique_ptr<Request> request,
+      std::string* error);
+  /* The transfer completes as CANCELLED unless it already completed */
+  void cancel(uint64_t id);
+
+  /*
+   * Feed the body of a BODY_STREAM transfer, sent with the chunked
+   * encoding. 'data' must stay valid until 'consumed' is called, from any
+   * thread, once the chunk is sent or the transfer is over.
+   */
+  void write_body(uint64_t id, const char* data, size_t size,
+      Consumed consumed);
+  void end_body(uint64_t id);
+
+  Stats stats();
+
+ private:
+  void run();
+  void wakeup();
+  bool start(HttpTransfer* transfer);
+  void complete(HttpTransfer* transfer, Result result, const char* error);
+  /* Send a download again from the start of the file */
+  void restart(HttpTransfer* transfer);
+  /* Hand a PEM over in memory, false when libcurl cannot take it */
+  bool set_pem_blob(HttpTransfer* transfer, int blob_option,
+      std::string* pem);
+  /* Hand a PEM certificate over in memory, or through a file */
+  bool set_pem(HttpTransfer* transfer, int blob_option,
+      CURLoption file_option, std::string* pem);
+
+  Callback m_done;
+  Options m_options;
+  CURLM* m_multi;
+  CURLSH* m_share;
+  int m_wakeup[2];
+  std::thread m_thread;
+  std::mutex m_lock;
+  bool m_quit;
+  std::deque<HttpTransfer*> m_pending;
+  std::vector<uint64_t> m_cancelled;
+  std::vector<uint64_t> m_resumed;
+  std::map<uint64_t, std::shared_ptr<HttpBodyStream>> m_streams;
+  Stats m_stats;
+  std::unique_ptr<HttpDiskWorker> m_disk;
+  /* Only touched by the client thread */
+  std::map<uint64_t, HttpTransfer*> m_running;
+  /* Files standing for in-memory certificates, by SHA-256 of content */
+  std::map<std::string, std::string> m_pem_files;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_HTTP_HTTP_CLIENT_H_
@@ -0,0 +1,128 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "http/http_headers.h"
+
+#include <string>
+#include <vector>
+
+namespace artik {
+
+using v8::Array;
+using v8::Exception;
+using v8::Function;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Isolate;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::Persistent;
+using v8::String;
+using v8::Value;
+using v8::Context;
+
+Persistent<Function> HttpHeadersWrapper::constructor;
+Persistent<FunctionTemplate> HttpHeadersWrapper::tmpl;
+
+static std::shared_ptr<HttpHeaderArena> arena_from_array(
+    Local<Array> array) {
+  std::vector<std::string> pairs;
+
+  pairs.reserve(array->Length());
+  for (unsigned int i = 0; i < array->Length(); i++) {
+    String::Utf8Value item(array->Get(i)->ToString());
+
+    pairs.push_back(std::string(*item, item.length()));
+  }
+
+  return std::make_shared<HttpHeaderArena>(pairs);
+}
+
+HttpHeadersWrapper::HttpHeadersWrapper(
+    std::shared_ptr<HttpHeaderArena> arena) : m_arena(arena) {
+}
+
+HttpHeadersWrapper::~HttpHeadersWrapper() {
+  /* Requests in flight keep the arena alive */
+}
+
+std::shared_ptr<HttpHeaderArena> HttpHeadersWrapper::from_js(
+    Local<Value> value) {
+  Isolate* isolate = Isolate::GetCurrent();
+
+  if (value->IsArray())
+    return arena_from_array(Local<Array>::Cast(value));
+
+  if (!Local<FunctionTemplate>::New(isolate, tmpl)->HasInstance(value))
+    return nullptr;
+
+  return ObjectWrap::Unwrap<HttpHeadersWrapper>(value.As<Object>())->m_arena;
+}
+
+void HttpHeadersWrapper::Init(Local<Object> exports) {
+  Isolate* isolate = exports->GetIsolate();
+
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(String::NewFromUtf8(isolate, "http_headers"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototypes
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get_count", get_count);
+
+  constructor.Reset(isolate, tpl->GetFunction());
+  tmpl.Reset(isolate, tpl);
+  exports->Set(String::NewFromUtf8(isolate, "http_headers"),
+               tpl->GetFunction());
+}
+
+void HttpHeadersWrapper::New(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (!args.IsConstructCall()) {
+    const int argc = 1;
+    Local<Value> argv[argc] = { args[0] };
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Function> cons = Local<Function>::New(isolate, constructor);
+    args.GetReturnValue().Set(
+        cons->NewInstance(context, argc, argv).ToLocalChecked());
+    return;
+  }
+
+  if (!args[0]->IsArray()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  HttpHeadersWrapper* obj = new HttpHeadersWrapper(
+      arena_from_array(Local<Array>::Cast(args[0])));
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void HttpHeadersWrapper::get_count(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  HttpHeadersWrapper* obj =
+      ObjectWrap::Unwrap<HttpHeadersWrapper>(args.Holder());
+
+  args.GetReturnValue().Set(Number::New(isolate, obj->m_arena->size()));
+}
+
+}  // namespace artik
@@ -0,0 +1,61 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_HTTP_HTTP_HEADERS_H_
+#define ADDON_HTTP_HTTP_HEADERS_H_
+
+#include <node.h>
+#include <nan.h>
+#include <node_object_wrap.h>
+
+#include <memory>
+
+#include "http/header_arena.h"
+
+namespace artik {
+
+/*
+ * Headers built once from JS and passed to any number of requests, which
+ * then share them instead of marshaling the array again.
+ */
+class HttpHeadersWrapper : public node::ObjectWrap {
+ public:
+  static void Init(v8::Local<v8::Object> exports);
+
+  /*
+   * Headers wrapped by 'value', or built from a [name, value, ...] array.
+   * NULL for anything else.
+   */
+  static std::shared_ptr<HttpHeaderArena> from_js(v8::Local<v8::Value> value);
+
+ private:
+  explicit HttpHeadersWrapper(std::shared_ptr<HttpHeaderArena> arena);
+  ~HttpHeadersWrapper();
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
+
+  static void get_count(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  std::shared_ptr<HttpHeaderArena> m_arena;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_HTTP_HTTP_HEADERS_H_
@@ -22,6 +22,10 @@
 #include <node_buffer.h>
 #include <nan.h>
 
+#include <mutex>
+#include <string>
+#include <vector>
+
 #define MAX_ARG_STR_LEN 32
 
 namespace artik {
@@ -41,6 +45,161 @@ using v8::Context;
 
 Persistent<Function> I2cWrapper::constructor;
 
+/*
+ * Runs one bus transaction on the libuv thread pool. The target buffer
+ * (either supplied by the caller or allocated up front) and the wrapper
+ * object are kept alive until the callback has been called, so the
+ * transfer happens in place without any intermediate copy.
+ */
+class I2cWorker : public Nan::AsyncWorker {
+ public:
+  enum Op { READ, WRITE, READ_REGISTER, WRITE_REGISTER };
+
+  I2cWorker(Nan::Callback* callback, Local<Object> holder, Op op,
+            unsigned int address, Local<Object> buffer)
+    : Nan::AsyncWorker(callback),
+      m_wrap(node::ObjectWrap::Unwrap<I2cWrapper>(holder)),
+      m_op(op),
+      m_address(address),
+      m_data(node::Buffer::Data(buffer)),
+      m_length(node::Buffer::Length(buffer)) {
+    SaveToPersistent("i2c", holder);
+    SaveToPersistent("buffer", buffer);
+  }
+
+  void Execute() {
+    std::lock_guard<std::mutex> lock(m_wrap->getLock());
+    I2c* obj = m_wrap->getObj();
+    artik_error ret = S_OK;
+
+    switch (m_op) {
+    case READ:
+      ret = obj->read(m_data, m_length);
+      break;
+    case WRITE:
+      ret = obj->write(m_data, m_length);
+      break;
+    case READ_REGISTER:
+      ret = obj->read_register(m_address, m_data, m_length);
+      break;
+    case WRITE_REGISTER:
+      ret = obj->write_register(m_address, m_data, m_length);
+      break;
+    }
+
+    if (ret != S_OK)
+      SetErrorMessage(error_msg(ret));
+  }
+
+  void HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    Local<Value> argv[2] = {
+      Nan::Null(),
+      GetFromPersistent("buffer")
+    };
+
+    if (m_op == READ || m_op == READ_REGISTER)
+      callback->Call(2, argv);
+    else
+      callback->Call(1, argv);
+  }
+
+ private:
+  I2cWrapper* m_wrap;
+  Op m_op;
+  unsigned int m_address;
+  char* m_data;
+  size_t m_length;
+};
+
+/*
+ * Runs a list of register reads and writes as a single batch on the libuv
+ * thread pool, holding the bus for the whole batch. Register reads land
+ * in the output buffer at their offset, data to write is copied into one
+ * contiguous block when the batch is built.
+ */
+class I2cTransferWorker : public Nan::AsyncWorker {
+ public:
+  struct Segment {
+    bool write;
+    unsigned int address;
+    size_t offset;  /* into the output buffer or the write data */
+    size_t length;
+  };
+
+  I2cTransferWorker(Nan::Callback* callback, Local<Object> holder,
+                    Local<Value> out, std::vector<Segment>* segments,
+                    std::string* write_data)
+    : Nan::AsyncWorker(callback),
+      m_wrap(node::ObjectWrap::Unwrap<I2cWrapper>(holder)),
+      m_out(NULL) {
+    m_segments.swap(*segments);
+    m_write_data.swap(*write_data);
+    SaveToPersistent("i2c", holder);
+    if (node::Buffer::HasInstance(out)) {
+      m_out = node::Buffer::Data(out);
+      SaveToPersistent("buffer", out);
+    }
+  }
+
+  void Execute() {
+    std::lock_guard<std::mutex> lock(m_wrap->getLock());
+    I2c* obj = m_wrap->getObj();
+
+    for (size_t i = 0; i < m_segments.size(); i++) {
+      const Segment& seg = m_segments[i];
+      artik_error ret;
+
+      if (seg.write)
+        ret = obj->write_register(seg.address, &m_write_data[seg.offset],
+                                  seg.length);
+      else
+        ret = obj->read_register(seg.address, m_out + seg.offset, seg.length);
+
+      if (ret != S_OK) {
+        std::string msg = "Transfer " + std::to_string(i) + " failed: " +
+                          error_msg(ret);
+        SetErrorMessage(msg.c_str());
+        return;
+      }
+    }
+  }
+
+  void HandleOKCallback() {
+    Nan::HandleScope scope;
+
+    Local<Value> argv[2] = {
+      Nan::Null(),
+      m_out ? GetFromPersistent("buffer") : Nan::Undefined()
+    };
+
+    callback->Call(2, argv);
+  }
+
+ private:
+  I2cWrapper* m_wrap;
+  char* m_out;
+  std::vector<Segment> m_segments;
+  std::string m_write_data;
+};
+
+/*
+ * A read target is either a length, in which case a new Buffer is
+ * allocated, or a Buffer to fill in place.
+ */
+static bool get_read_buffer(Local<Value> arg, Local<Object>* buffer) {
+  if (node::Buffer::HasInstance(arg)) {
+    *buffer = arg->ToObject();
+    return true;
+  }
+
+  if (!arg->IsNumber() || arg->NumberValue() < 0)
+    return false;
+
+  return Nan::NewBuffer(arg->NumberValue()).ToLocal(buffer);
+}
+
 I2cWrapper::I2cWrapper(artik_i2c_id id, int frequency,
     artik_i2c_wordsize_t wordsize, unsigned int address) {
   m_i2c = new I2c(id, frequency, wordsize, address);
@@ -65,6 +224,12 @@ void I2cWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(tpl, "write", write);
   NODE_SET_PROTOTYPE_METHOD(tpl, "read_register", read_register);
   NODE_SET_PROTOTYPE_METHOD(tpl, "write_register", write_register);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "read_async", read_async);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "write_async", write_async);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "read_register_async", read_register_async);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "write_register_async",
+                            write_register_async);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "transfer", transfer);
 
   constructor.Reset(isolate, tpl->GetFunction());
   exports->Set(String::NewFromUtf8(isolate, "i2c"),
@@ -117,8 +282,9 @@ void I2cWrapper::New(const FunctionCallbackInfo<Value>& args) {
 void I2cWrapper::request(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
 
-  I2c* obj = ObjectWrap::Unwrap<I2cWrapper>(args.Holder())->getObj();
-  artik_error ret = obj->request();
+  I2cWrapper* wrap = ObjectWrap::Unwrap<I2cWrapper>(args.Holder());
+  std::lock_guard<std::mutex> lock(wrap->getLock());
+  artik_error ret = wrap->getObj()->request();
 
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
@@ -126,8 +292,9 @@ void I2cWrapper::request(const FunctionCallbackInfo<Value>& args) {
 void I2cWrapper::release(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
 
-  I2c* obj = ObjectWrap::Unwrap<I2cWrapper>(args.Holder())->getObj();
-  artik_error ret = obj->release();
+  I2cWrapper* wrap = ObjectWrap::Unwrap<I2cWrapper>(args.Holder());
+  std::lock_guard<std::mutex> lock(wrap->getLock());
+  artik_error ret = wrap->getObj()->release();
 
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
@@ -151,7 +318,11 @@ void I2cWrapper::read(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  obj->read(buffer, length);
+  {
+    std::lock_guard<std::mutex> lock(
+        ObjectWrap::Unwrap<I2cWrapper>(args.Holder())->getLock());
+    obj->read(buffer, length);
+  }
 
   args.GetReturnValue().Set(Nan::CopyBuffer(buffer, length).ToLocalChecked());
 
@@ -176,9 +347,10 @@ void I2cWrapper::write(const FunctionCallbackInfo<Value>& args) {
   char * buffer = node::Buffer::Data(args[0]);
   size_t length = node::Buffer::Length(args[0]);
 
-  I2c* obj = ObjectWrap::Unwrap<I2cWrapper>(args.Holder())->getObj();
+  I2cWrapper* wrap = ObjectWrap::Unwrap<I2cWrapper>(args.Holder());
+  std::lock_guard<std::mutex> lock(wrap->getLock());
 
-  artik_error ret = obj->write(buffer, length);
+  artik_error ret = wrap->getObj()->write(buffer, length);
 
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
@@ -203,7 +375,11 @@ void I2cWrapper::read_register(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  obj->read_register(address, buffer, length);
+  {
+    std::lock_guard<std::mutex> lock(
+        ObjectWrap::Unwrap<I2cWrapper>(args.Holder())->getLock());
+    obj->read_register(address, buffer, length);
+  }
 
   args.GetReturnValue().Set(Nan::CopyBuffer(buffer, length).ToLocalChecked());
 
@@ -230,9 +406,161 @@ void I2cWrapper::write_register(const FunctionCallbackInfo<Value>& args) {
   char * buffer = node::Buffer::Data(args[1]);
   size_t length = node::Buffer::Length(args[1]);
 
+  std::lock_guard<std::mutex> lock(
+      ObjectWrap::Unwrap<I2cWrapper>(args.Holder())->getLock());
   artik_error ret = obj->write_register(address, buffer, length);
 
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
 
+void I2cWrapper::read_async(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  Local<Object> buffer;
+
+  if (args.Length() != 2 || !args[1]->IsFunction() ||
+      !get_read_buffer(args[0], &buffer)) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+    return;
+  }
+
+  Nan::AsyncQueueWorker(new I2cWorker(
+      new Nan::Callback(args[1].As<Function>()), args.Holder(),
+      I2cWorker::READ, 0, buffer));
+}
+
+void I2cWrapper::write_async(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() != 2 || !args[1]->IsFunction()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (!node::Buffer::HasInstance(args[0])) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Argument should be a Buffer.")));
+    return;
+  }
+
+  Nan::AsyncQueueWorker(new I2cWorker(
+      new Nan::Callback(args[1].As<Function>()), args.Holder(),
+      I2cWorker::WRITE, 0, args[0]->ToObject()));
+}
+
+void I2cWrapper::read_register_async(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  Local<Object> buffer;
+
+  if (args.Length() != 3 || !args[0]->IsNumber() || !args[2]->IsFunction() ||
+      !get_read_buffer(args[1], &buffer)) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+    return;
+  }
+
+  unsigned int address = args[0]->NumberValue();
+
+  Nan::AsyncQueueWorker(new I2cWorker(
+      new Nan::Callback(args[2].As<Function>()), args.Holder(),
+      I2cWorker::READ_REGISTER, address, buffer));
+}
+
+void I2cWrapper::write_register_async(
+    const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() != 3 || !args[0]->IsNumber() || !args[2]->IsFunction()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (!node::Buffer::HasInstance(args[1])) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Argument should be a Buffer.")));
+    return;
+  }
+
+  unsigned int address = args[0]->NumberValue();
+
+  Nan::AsyncQueueWorker(new I2cWorker(
+      new Nan::Callback(args[2].As<Function>()), args.Holder(),
+      I2cWorker::WRITE_REGISTER, address, args[1]->ToObject()));
+}
+
+void I2cWrapper::transfer(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() != 3 || !args[0]->IsArray() || !args[2]->IsFunction() ||
+      !(node::Buffer::HasInstance(args[1]) || args[1]->IsNull() ||
+        args[1]->IsUndefined())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong arguments")));
+    return;
+  }
+
+  Local<v8::Array> ops = Local<v8::Array>::Cast(args[0]);
+  Local<String> reg_key = String::NewFromUtf8(isolate, "reg");
+  Local<String> len_key = String::NewFromUtf8(isolate, "len");
+  Local<String> data_key = String::NewFromUtf8(isolate, "data");
+  Local<String> offset_key = String::NewFromUtf8(isolate, "offset");
+  size_t out_length = node::Buffer::HasInstance(args[1]) ?
+      node::Buffer::Length(args[1]) : 0;
+  size_t out_offset = 0;
+  std::vector<I2cTransferWorker::Segment> segments;
+  std::string write_data;
+
+  segments.reserve(ops->Length());
+
+  for (unsigned int i = 0; i < ops->Length(); i++) {
+    Local<Value> op = ops->Get(i);
+
+    if (!op->IsObject() || !op->ToObject()->Get(reg_key)->IsNumber()) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+            isolate, "Wrong arguments")));
+      return;
+    }
+
+    Local<Object> obj = op->ToObject();
+    Local<Value> data = obj->Get(data_key);
+    Local<Value> len = obj->Get(len_key);
+    Local<Value> offset = obj->Get(offset_key);
+    I2cTransferWorker::Segment seg;
+
+    seg.address = obj->Get(reg_key)->NumberValue();
+
+    if (node::Buffer::HasInstance(data)) {
+      seg.write = true;
+      seg.offset = write_data.size();
+      seg.length = node::Buffer::Length(data);
+      write_data.append(node::Buffer::Data(data), seg.length);
+    } else if (len->IsNumber() && len->NumberValue() >= 0 &&
+               (offset->IsUndefined() ||
+                (offset->IsNumber() && offset->NumberValue() >= 0))) {
+      seg.write = false;
+      seg.offset = offset->IsUndefined() ? out_offset : offset->NumberValue();
+      seg.length = len->NumberValue();
+      out_offset = seg.offset + seg.length;
+
+      if (out_offset > out_length) {
+        isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+              isolate, "Read does not fit in the output buffer")));
+        return;
+      }
+    } else {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+            isolate, "Wrong arguments")));
+      return;
+    }
+
+    segments.push_back(seg);
+  }
+
+  Nan::AsyncQueueWorker(new I2cTransferWorker(
+      new Nan::Callback(args[2].As<Function>()), args.Holder(), args[1],
+      &segments, &write_data));
+}
+
 }  // namespace artik
@@ -24,6 +24,8 @@
 
 #include <artik_i2c.hh>
 
+#include <mutex>
+
 namespace artik {
 
 class I2cWrapper : public node::ObjectWrap {
@@ -31,6 +33,7 @@ class I2cWrapper : public node::ObjectWrap {
   static void Init(v8::Local<v8::Object> exports);
 
   I2c* getObj() { return m_i2c; }
+  std::mutex& getLock() { return m_lock; }
 
  private:
   explicit I2cWrapper(artik_i2c_id id, int frequency,
@@ -46,8 +49,17 @@ class I2cWrapper : public node::ObjectWrap {
   static void write(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void read_register(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void write_register(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void read_async(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void write_async(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void read_register_async(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void write_register_async(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void transfer(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   I2c* m_i2c;
+  /* Serializes bus transactions between the JS thread and the thread pool */
+  std::mutex m_lock;
 };
 
 }  // namespace artik
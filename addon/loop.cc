@@ -16,7 +16,13 @@
  *
  */
 
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
 
 #include "loop.h"
 
@@ -24,25 +30,140 @@ namespace artik {
 
 GlibLoop* GlibLoop::m_instance = nullptr;
 int GlibLoop::m_refcount = 0;
+int GlibLoop::m_unsafe_refcount = 0;
 uv_prepare_t GlibLoop::m_prepare_h;
-uv_idle_t GlibLoop::m_idle_h;
+uv_check_t GlibLoop::m_check_h;
+uv_timer_t GlibLoop::m_timer_h;
+uv_async_t GlibLoop::m_async_h;
 
-static void prepare_cb(uv_prepare_t *handle) {
+#define GIO_ERROR_EVENTS (G_IO_ERR | G_IO_HUP | G_IO_NVAL)
+
+/*
+ * libuv use epoll, and assert if epoll fail (except EEXIST errno).
+ * Regular files are not supported by epoll (EPERM), so probe each fd
+ * on a private epoll instance before handing it to uv_poll.
+ */
+static bool fd_is_pollable(int fd) {
+  static int probe = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event ev = { EPOLLIN, { 0 } };
+
+  if (epoll_ctl(probe, EPOLL_CTL_ADD, fd, &ev) < 0)
+    return errno == EEXIST;
+
+  epoll_ctl(probe, EPOLL_CTL_DEL, fd, &ev);
+  return true;
+}
+
+static int gio_to_uv_events(gushort events) {
+  int uv_events = 0;
+
+  if (events & G_IO_IN)
+    uv_events |= UV_READABLE;
+  if (events & G_IO_OUT)
+    uv_events |= UV_WRITABLE;
+#if UV_VERSION_MAJOR > 1 || (UV_VERSION_MAJOR == 1 && UV_VERSION_MINOR >= 9)
+  if (events & G_IO_PRI)
+    uv_events |= UV_PRIORITIZED;
+#else
+  if (events & G_IO_PRI)
+    uv_events |= UV_READABLE;
+#endif
+
+  return uv_events;
+}
+
+static gushort uv_to_gio_events(int uv_events) {
+  gushort events = 0;
+
+  if (uv_events & UV_READABLE)
+    events |= G_IO_IN;
+  if (uv_events & UV_WRITABLE)
+    events |= G_IO_OUT;
+#if UV_VERSION_MAJOR > 1 || (UV_VERSION_MAJOR == 1 && UV_VERSION_MINOR >= 9)
+  if (uv_events & UV_PRIORITIZED)
+    events |= G_IO_PRI;
+#endif
+
+  return events;
+}
+
+void GlibLoop::prepare_cb(uv_prepare_t *handle) {
+  reinterpret_cast<GlibLoop*>(handle->data)->prepare();
+}
+
+void GlibLoop::check_cb(uv_check_t *handle) {
+  reinterpret_cast<GlibLoop*>(handle->data)->check();
+}
+
+void GlibLoop::timer_cb(uv_timer_t *handle) {
   /*
-   * trick to use glib's own poll function and prepare/check/dispatch
-   * in libuv's prepare time
+   * Nothing to do, expiring the timer is enough to make libuv leave its
+   * poll phase. Timeouts are dispatched by g_main_context_check().
    */
-  g_main_context_iteration(NULL, FALSE);
 }
 
-static void _idle_cb(uv_idle_t *handle) {
-  usleep(1000);
+void GlibLoop::async_cb(uv_async_t *handle) {
+  /*
+   * Woken up either by the slow fds thread, whose results are collected
+   * in check(), or by the GLib thread handing over callbacks.
+   */
+  reinterpret_cast<GlibLoop*>(handle->data)->drain();
 }
 
-GlibLoop::GlibLoop() {
+void GlibLoop::poll_cb(uv_poll_t *handle, int status, int events) {
+  PollWatcher *watcher = reinterpret_cast<PollWatcher*>(handle->data);
+
+  /*
+   * libuv gives up on the handle after an error, forget its mask so that
+   * the next update starts polling the fd again.
+   */
+  if (status < 0) {
+    watcher->revents |= G_IO_ERR | G_IO_HUP;
+    uv_poll_stop(handle);
+    watcher->events = 0;
+  } else {
+    watcher->revents |= uv_to_gio_events(events);
+  }
+}
+
+void GlibLoop::watcher_close_cb(uv_handle_t *handle) {
+  delete reinterpret_cast<PollWatcher*>(handle->data);
+}
+
+GlibLoop::GlibLoop()
+  : m_context(g_main_context_default()),
+    m_max_priority(0),
+    m_prepared(false),
+    m_fds(16),
+    m_slow_gen(0),
+    m_slow_done_gen(0),
+    m_slow_consumed(false),
+    m_slow_wakeup(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+    m_use_thread(false),
+    m_js_thread(std::this_thread::get_id()),
+    m_glib_quit(false),
+    m_overflowed(false) {
+  uv_prepare_init(uv_default_loop(), &m_prepare_h);
+  m_prepare_h.data = this;
+
+  uv_check_init(uv_default_loop(), &m_check_h);
+  m_check_h.data = this;
+
+  /*
+   * Only the prepare handle keeps the node process alive while a wrapper
+   * is attached, the timer and async handles are just wake up sources.
+   */
+  uv_timer_init(uv_default_loop(), &m_timer_h);
+  uv_unref(reinterpret_cast<uv_handle_t*>(&m_timer_h));
+
+  uv_async_init(uv_default_loop(), &m_async_h, async_cb);
+  m_async_h.data = this;
+  uv_unref(reinterpret_cast<uv_handle_t*>(&m_async_h));
 }
 
 GlibLoop::~GlibLoop() {
+  close_watchers();
+  update_slow_fds(std::vector<GPollFD>());
 }
 
 GlibLoop* GlibLoop::Instance() {
@@ -52,36 +173,481 @@ GlibLoop* GlibLoop::Instance() {
   return m_instance;
 }
 
-void GlibLoop::attach() {
-  if (++m_refcount > 1)
+void GlibLoop::prepare() {
+  std::vector<GPollFD> slow_fds;
+  gint timeout = -1;
+  gint n_fds;
+  bool want_thread = m_use_thread && (m_unsafe_refcount == 0);
+
+  /*
+   * Switching to the GLib thread is only done here, as attach() may be
+   * called from a callback dispatched by g_main_context_dispatch().
+   */
+  if (want_thread && !m_glib_thread.joinable())
+    start_glib_thread();
+  else if (!want_thread && m_glib_thread.joinable())
+    stop_glib_thread();
+
+  if (m_glib_thread.joinable())
     return;
 
+  if (!g_main_context_acquire(m_context))
+    return;
+
+  g_main_context_prepare(m_context, &m_max_priority);
+
+  while ((n_fds = g_main_context_query(m_context, m_max_priority, &timeout,
+      m_fds.data(), m_fds.size())) > static_cast<gint>(m_fds.size()))
+    m_fds.resize(n_fds);
+  m_fds.resize(n_fds);
+
+  update_watchers(&slow_fds);
+  update_slow_fds(slow_fds);
+
   /*
-   * libuv use epoll, and assert if epoll fail (except EEXIST errno).
-   * if we pass the regular file to uv_poll's fd, epoll fail with ENOPERM
-   * and assert. (becasue regular file not support epoll)
-   * so, use glib's own poll function in uv_prepare time.
+   * GLib reports a null timeout when a source is already ready, libuv
+   * then polls without blocking.
    */
-  uv_prepare_init(uv_default_loop(), &m_prepare_h);
-  uv_prepare_start(&m_prepare_h, prepare_cb);
+  if (timeout >= 0)
+    uv_timer_start(&m_timer_h, timer_cb, timeout, 0);
+  else
+    uv_timer_stop(&m_timer_h);
+
+  m_prepared = true;
+}
+
+void GlibLoop::check() {
+  if (!m_prepared)
+    return;
+
+  m_prepared = false;
+
+  {
+    std::lock_guard<std::mutex> lock(m_slow_lock);
+    bool slow_ready = !m_slow_consumed && (m_slow_done_gen == m_slow_gen);
+
+    for (auto& fd : m_fds) {
+      auto it = m_watchers.find(fd.fd);
+      fd.revents = 0;
+
+      if (it != m_watchers.end()) {
+        fd.revents = it->second->revents & (fd.events | GIO_ERROR_EVENTS);
+        continue;
+      }
+
+      if (!slow_ready)
+        continue;
+
+      for (auto& slow : m_slow_fds) {
+        if (slow.fd == fd.fd)
+          fd.revents |= slow.revents & (fd.events | GIO_ERROR_EVENTS);
+      }
+    }
+
+    if (slow_ready)
+      m_slow_consumed = true;
+  }
+
+  if (g_main_context_check(m_context, m_max_priority, m_fds.data(),
+      m_fds.size()))
+    g_main_context_dispatch(m_context);
+
+  g_main_context_release(m_context);
+
+  /* Tasks deferred by the callbacks just dispatched */
+  if (!m_backlog.empty())
+    drain();
+}
+
+void GlibLoop::close_watcher(PollWatcher *watcher) {
+  uv_poll_stop(&watcher->handle);
+  uv_close(reinterpret_cast<uv_handle_t*>(&watcher->handle),
+      watcher_close_cb);
+}
+
+void GlibLoop::update_watchers(std::vector<GPollFD> *slow_fds) {
+  std::map<int, int> wanted;
 
   /*
-   * uv_poll use epoll with infinite timeout(-1) if there are no registered
-   * event source (fd/timer/idle/...)
-   * we do not add glib's poll fd to uv_poll, libuv don't know how many
-   * events are registered.
-   * so, add fake event source(idle) to libuv.
+   * A watcher whose fd now refers to another file is stale: epoll dropped
+   * the old file when it was closed, and the new one was never added.
    */
-  uv_idle_init(uv_default_loop(), &m_idle_h);
-  uv_idle_start(&m_idle_h, _idle_cb);
+  for (auto it = m_watchers.begin(); it != m_watchers.end();) {
+    struct stat st;
+
+    if (fstat(it->first, &st) == 0 && st.st_dev == it->second->dev &&
+        st.st_ino == it->second->ino) {
+      ++it;
+      continue;
+    }
+
+    close_watcher(it->second);
+    it = m_watchers.erase(it);
+  }
+
+  for (auto& fd : m_fds) {
+    if (m_watchers.find(fd.fd) == m_watchers.end() && !fd_is_pollable(fd.fd))
+      slow_fds->push_back(fd);
+    else
+      wanted[fd.fd] |= gio_to_uv_events(fd.events);
+  }
+
+  /* Drop the watchers on fds GLib is no longer interested in */
+  for (auto it = m_watchers.begin(); it != m_watchers.end();) {
+    if (wanted.find(it->first) != wanted.end()) {
+      ++it;
+      continue;
+    }
+
+    close_watcher(it->second);
+    it = m_watchers.erase(it);
+  }
+
+  for (auto& entry : wanted) {
+    PollWatcher *watcher = nullptr;
+    auto it = m_watchers.find(entry.first);
+
+    if (it == m_watchers.end()) {
+      struct stat st;
+
+      watcher = new PollWatcher();
+      watcher->fd = entry.first;
+      watcher->events = 0;
+      watcher->handle.data = watcher;
+
+      if (fstat(watcher->fd, &st) < 0 ||
+          uv_poll_init(uv_default_loop(), &watcher->handle, watcher->fd) < 0) {
+        GPollFD fd = { watcher->fd, 0, 0 };
+
+        for (auto& gfd : m_fds) {
+          if (gfd.fd == watcher->fd)
+            fd.events |= gfd.events;
+        }
+
+        slow_fds->push_back(fd);
+        delete watcher;
+        continue;
+      }
+
+      watcher->dev = st.st_dev;
+      watcher->ino = st.st_ino;
+      watcher->shared = S_ISCHR(st.st_mode) || !(st.st_mode & S_IFMT);
+      m_watchers[watcher->fd] = watcher;
+    } else {
+      watcher = it->second;
+
+      /* Drops the epoll entry so that the next start adds the current file */
+      if (watcher->shared) {
+        uv_poll_stop(&watcher->handle);
+        watcher->events = 0;
+      }
+    }
+
+    watcher->revents = 0;
+
+    if (watcher->events != entry.second) {
+      watcher->events = entry.second;
+      uv_poll_start(&watcher->handle, watcher->events, poll_cb);
+    }
+  }
+}
+
+void GlibLoop::update_slow_fds(const std::vector<GPollFD>& slow_fds) {
+  std::thread stopped;
+
+  {
+    std::lock_guard<std::mutex> lock(m_slow_lock);
+
+    if (!set_slow_fds(slow_fds, &stopped))
+      return;
+  }
+
+  /* Exits as soon as it sees the empty set */
+  if (stopped.joinable())
+    stopped.join();
 }
 
-void GlibLoop::detach() {
-  if ((m_refcount == 0) || (--m_refcount > 0))
+bool GlibLoop::set_slow_fds(const std::vector<GPollFD>& slow_fds,
+    std::thread *stopped) {
+  bool changed = slow_fds.size() != m_slow_fds.size();
+
+  for (size_t i = 0; !changed && i < slow_fds.size(); i++) {
+    changed = (slow_fds[i].fd != m_slow_fds[i].fd) ||
+        (slow_fds[i].events != m_slow_fds[i].events);
+  }
+
+  /* Keep polling the current set until its results have been consumed */
+  if (!changed && !m_slow_consumed)
+    return false;
+
+  if (!changed && m_slow_fds.empty())
+    return false;
+
+  m_slow_fds = slow_fds;
+  m_slow_gen++;
+  m_slow_consumed = false;
+
+  if (!m_slow_fds.empty() && !m_slow_thread.joinable())
+    m_slow_thread = std::thread(&GlibLoop::slow_poll_thread, this);
+  else if (m_slow_fds.empty() && m_slow_thread.joinable())
+    stopped->swap(m_slow_thread);
+
+  if (changed) {
+    uint64_t val = 1;
+
+    if (write(m_slow_wakeup, &val, sizeof(val)) < 0) {
+      /* Counter already signaled, the thread will wake up anyway */
+    }
+  }
+
+  m_slow_cond.notify_one();
+  return true;
+}
+
+void GlibLoop::slow_poll_thread() {
+  std::unique_lock<std::mutex> lock(m_slow_lock);
+
+  for (;;) {
+    /* No slow fd left, update_slow_fds() joins the thread */
+    if (m_slow_fds.empty())
+      return;
+
+    if (m_slow_done_gen == m_slow_gen) {
+      m_slow_cond.wait(lock);
+      continue;
+    }
+
+    unsigned int gen = m_slow_gen;
+    std::vector<struct pollfd> pfds;
+
+    for (auto& fd : m_slow_fds)
+      pfds.push_back({ fd.fd, static_cast<short>(fd.events), 0 });
+    pfds.push_back({ m_slow_wakeup, POLLIN, 0 });
+
+    lock.unlock();
+    int ret = poll(pfds.data(), pfds.size(), -1);
+    lock.lock();
+
+    if (pfds.back().revents & POLLIN) {
+      uint64_t val;
+
+      if (read(m_slow_wakeup, &val, sizeof(val)) < 0) {
+        /* Nothing to drain */
+      }
+    }
+
+    /* Set of fds changed while polling, start over with the new one */
+    if (ret <= 0 || gen != m_slow_gen)
+      continue;
+
+    bool ready = false;
+
+    for (size_t i = 0; i < m_slow_fds.size(); i++) {
+      m_slow_fds[i].revents = pfds[i].revents;
+      ready |= (pfds[i].revents != 0);
+    }
+
+    if (!ready)
+      continue;
+
+    m_slow_done_gen = gen;
+    uv_async_send(&m_async_h);
+  }
+}
+
+void GlibLoop::close_watchers() {
+  for (auto& entry : m_watchers)
+    close_watcher(entry.second);
+
+  m_watchers.clear();
+}
+
+void GlibLoop::start_glib_thread() {
+  close_watchers();
+  update_slow_fds(std::vector<GPollFD>());
+  uv_timer_stop(&m_timer_h);
+
+  m_glib_quit = false;
+  m_glib_thread = std::thread(&GlibLoop::glib_thread, this);
+}
+
+void GlibLoop::stop_glib_thread() {
+  m_glib_quit = true;
+  g_main_context_wakeup(m_context);
+  m_glib_thread.join();
+}
+
+void GlibLoop::glib_thread() {
+  std::vector<GPollFD> fds(16);
+  gint max_priority;
+  gint timeout;
+  gint n_fds;
+
+  g_main_context_acquire(m_context);
+
+  /*
+   * Same steps as g_main_context_iteration(), with the dispatch lock
+   * released only while polling.
+   */
+  while (!m_glib_quit) {
+    std::unique_lock<std::recursive_mutex> lock(m_dispatch_lock);
+
+    g_main_context_prepare(m_context, &max_priority);
+
+    while ((n_fds = g_main_context_query(m_context, max_priority, &timeout,
+        fds.data(), fds.size())) > static_cast<gint>(fds.size()))
+      fds.resize(n_fds);
+    fds.resize(n_fds);
+
+    lock.unlock();
+    g_poll(fds.data(), fds.size(), timeout);
+    lock.lock();
+
+    if (g_main_context_check(m_context, max_priority, fds.data(),
+        fds.size()))
+      g_main_context_dispatch(m_context);
+  }
+
+  g_main_context_release(m_context);
+}
+
+void GlibLoop::set_threaded(bool enable) {
+  m_use_thread = enable;
+
+  /* Starting the thread is deferred to the next prepare() */
+  if (!enable && m_glib_thread.joinable())
+    stop_glib_thread();
+}
+
+void GlibLoop::invoke(void *owner, Task task) {
+  if (std::this_thread::get_id() == m_js_thread) {
+    task();
+    return;
+  }
+
+  queue(new LoopTask { owner, std::move(task) });
+}
+
+void GlibLoop::defer(void *owner, Task task) {
+  LoopTask *t = new LoopTask { owner, std::move(task) };
+
+  if (std::this_thread::get_id() != m_js_thread) {
+    queue(t);
+    return;
+  }
+
+  m_backlog.push_back(t);
+  uv_async_send(&m_async_h);
+}
+
+void GlibLoop::queue(LoopTask *t) {
+  /*
+   * Never block the GLib thread: once the ring is full, tasks go to a
+   * locked overflow list until the JS thread catches up, which also keeps
+   * them ordered.
+   */
+  if (m_overflowed.load(std::memory_order_acquire) || !m_tasks.push(t)) {
+    std::lock_guard<std::mutex> lock(m_overflow_lock);
+
+    m_overflow.push_back(t);
+    m_overflowed.store(true, std::memory_order_release);
+  }
+
+  uv_async_send(&m_async_h);
+}
+
+void GlibLoop::collect_tasks() {
+  LoopTask *t;
+
+  while (m_tasks.pop(&t))
+    m_backlog.push_back(t);
+
+  if (m_overflowed.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(m_overflow_lock);
+
+    m_backlog.insert(m_backlog.end(), m_overflow.begin(), m_overflow.end());
+    m_overflow.clear();
+    m_overflowed.store(false, std::memory_order_release);
+  }
+}
+
+void GlibLoop::drain() {
+  collect_tasks();
+
+  /*
+   * Run the batch collected so far, tasks queued meanwhile are left for
+   * the next wake up so that the GLib thread cannot starve libuv.
+   */
+  size_t batch = m_backlog.size();
+
+  while (batch-- > 0 && !m_backlog.empty()) {
+    LoopTask *t = m_backlog.front();
+
+    m_backlog.pop_front();
+    t->run();
+    delete t;
+  }
+
+  if (!m_backlog.empty())
+    uv_async_send(&m_async_h);
+}
+
+void GlibLoop::cancel(void *owner) {
+  collect_tasks();
+
+  for (auto it = m_backlog.begin(); it != m_backlog.end();) {
+    if ((*it)->owner != owner) {
+      ++it;
+      continue;
+    }
+
+    delete *it;
+    it = m_backlog.erase(it);
+  }
+}
+
+void GlibLoop::attach(bool threadable) {
+  /* Callbacks of this wrapper must run on the JS thread from now on */
+  if (!threadable && (m_unsafe_refcount++ == 0) && m_glib_thread.joinable())
+    stop_glib_thread();
+
+  if (++m_refcount > 1)
+    return;
+
+  /*
+   * Integrate the glib main context into libuv: in prepare time, glib's
+   * poll fds and next timeout are turned into uv_poll/uv_timer handles,
+   * so that libuv blocks in epoll until a glib source needs attention.
+   * Sources are then checked and dispatched in libuv's check time.
+   */
+  uv_prepare_start(&m_prepare_h, prepare_cb);
+  uv_check_start(&m_check_h, check_cb);
+}
+
+void GlibLoop::detach(bool threadable) {
+  if (m_refcount == 0)
     return;
 
-  uv_idle_stop(&m_idle_h);
+  if (!threadable && (m_unsafe_refcount > 0))
+    m_unsafe_refcount--;
+
+  if (--m_refcount > 0)
+    return;
+
+  if (m_glib_thread.joinable())
+    stop_glib_thread();
+
+  uv_timer_stop(&m_timer_h);
+  uv_check_stop(&m_check_h);
   uv_prepare_stop(&m_prepare_h);
+
+  close_watchers();
+  update_slow_fds(std::vector<GPollFD>());
+
+  if (m_prepared) {
+    m_prepared = false;
+    g_main_context_release(m_context);
+  }
 }
 
 }  // namespace artik
@@ -20,23 +20,150 @@
 #define ADDON_LOOP_H_
 
 #include <glib.h>
+#include <sys/types.h>
 #include <uv.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mpsc_ring.h"
+
 namespace artik {
 
 class GlibLoop {
   public:
+    typedef std::function<void()> Task;
+
     static GlibLoop* Instance();
-    void attach();
-    void detach();
+
+    /*
+     * Wrappers passing 'threadable' route all their SDK callbacks through
+     * invoke(), so that the GLib context may run on its own thread while
+     * only such wrappers are attached.
+     */
+    void attach(bool threadable = false);
+    void detach(bool threadable = false);
+
+    void set_threaded(bool enable);
+    bool threaded() const { return m_use_thread; }
+
+    /* Run a task on the JS thread, queue it if called from another one */
+    void invoke(void *owner, Task task);
+    /* Queue a task to run on the JS thread once GLib sources are dispatched */
+    void defer(void *owner, Task task);
+    /* Drop the queued tasks of an owner about to be destroyed */
+    void cancel(void *owner);
+
+    /*
+     * Held by the GLib thread while it dispatches sources. Threadable
+     * wrappers hold it around every call into their SDK object, deleting
+     * it included, so that SDK state is never used by both threads.
+     * Scopes must not allocate V8 objects: a GC may run a destructor that
+     * stops the GLib thread.
+     */
+    class SdkLock {
+      public:
+        SdkLock() : m_lock(Instance()->m_dispatch_lock) {}
+
+      private:
+        std::lock_guard<std::recursive_mutex> m_lock;
+    };
+
   private:
     GlibLoop();
     ~GlibLoop();
 
+    /*
+     * The file is remembered along with the fd number, which the kernel
+     * hands out again as soon as a socket is closed. Character devices and
+     * anonymous inodes share their inode between opens, they are re-armed
+     * on every iteration instead.
+     */
+    struct PollWatcher {
+      uv_poll_t handle;
+      int fd;
+      dev_t dev;
+      ino_t ino;
+      bool shared;
+      int events;
+      int revents;
+    };
+
+    struct LoopTask {
+      void *owner;
+      Task run;
+    };
+
+    static void prepare_cb(uv_prepare_t *handle);
+    static void check_cb(uv_check_t *handle);
+    static void timer_cb(uv_timer_t *handle);
+    static void async_cb(uv_async_t *handle);
+    static void poll_cb(uv_poll_t *handle, int status, int events);
+    static void watcher_close_cb(uv_handle_t *handle);
+
+    void prepare();
+    void check();
+    void update_watchers(std::vector<GPollFD> *slow_fds);
+    void close_watcher(PollWatcher *watcher);
+    void update_slow_fds(const std::vector<GPollFD>& slow_fds);
+    bool set_slow_fds(const std::vector<GPollFD>& slow_fds,
+        std::thread *stopped);
+    void close_watchers();
+    void slow_poll_thread();
+    void start_glib_thread();
+    void stop_glib_thread();
+    void glib_thread();
+    void queue(LoopTask *task);
+    void drain();
+    void collect_tasks();
+
     static GlibLoop* m_instance;
     static int m_refcount;
+    static int m_unsafe_refcount;
     static uv_prepare_t m_prepare_h;
-    static uv_idle_t m_idle_h;
+    static uv_check_t m_check_h;
+    static uv_timer_t m_timer_h;
+    static uv_async_t m_async_h;
+
+    GMainContext *m_context;
+    gint m_max_priority;
+    bool m_prepared;
+    std::vector<GPollFD> m_fds;
+    std::map<int, PollWatcher*> m_watchers;
+
+    /*
+     * File descriptors epoll refuses (regular files) are polled by a
+     * helper thread, which wakes up libuv through m_async_h.
+     */
+    std::thread m_slow_thread;
+    std::mutex m_slow_lock;
+    std::condition_variable m_slow_cond;
+    std::vector<GPollFD> m_slow_fds;
+    unsigned int m_slow_gen;
+    unsigned int m_slow_done_gen;
+    bool m_slow_consumed;
+    int m_slow_wakeup;
+
+    /*
+     * Threaded mode: the GLib context is iterated by m_glib_thread and
+     * callbacks are handed over to the JS thread through m_tasks.
+     */
+    bool m_use_thread;
+    std::thread::id m_js_thread;
+    std::thread m_glib_thread;
+    std::atomic<bool> m_glib_quit;
+    std::recursive_mutex m_dispatch_lock;
+    MpscRing<LoopTask*, 4096> m_tasks;
+    std::mutex m_overflow_lock;
+    std::atomic<bool> m_overflowed;
+    std::vector<LoopTask*> m_overflow;
+    std::deque<LoopTask*> m_backlog;
 };
 
 }  // namespace artik
@@ -0,0 +1,104 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_MPSC_RING_H_
+#define ADDON_MPSC_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace artik {
+
+/*
+ * Bounded lock-free ring, safe for any number of producer threads and a
+ * single consumer thread. Each cell carries a sequence number telling
+ * whether it is free for the producer owning position 'pos' (seq == pos)
+ * or holds a value ready for the consumer (seq == pos + 1).
+ */
+template<typename T, size_t N>
+class MpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0,
+      "Ring size must be a power of two");
+
+ public:
+  MpscRing() : m_head(0), m_tail(0) {
+    for (size_t i = 0; i < N; i++)
+      m_cells[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  /* Returns false if the ring is full */
+  bool push(const T& value) {
+    size_t pos = m_head.load(std::memory_order_relaxed);
+
+    for (;;) {
+      Cell *cell = &m_cells[pos & (N - 1)];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+      if (diff == 0) {
+        if (m_head.compare_exchange_weak(pos, pos + 1,
+            std::memory_order_relaxed)) {
+          cell->value = value;
+          cell->seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /* Must only be called from the consumer thread */
+  bool pop(T *value) {
+    Cell *cell = &m_cells[m_tail & (N - 1)];
+    size_t seq = cell->seq.load(std::memory_order_acquire);
+
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(m_tail + 1) < 0)
+      return false;
+
+    *value = cell->value;
+    cell->seq.store(m_tail + N, std::memory_order_release);
+    m_tail++;
+
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  MpscRing(const MpscRing&);
+  MpscRing& operator=(const MpscRing&);
+
+  /* Keep producers and consumer indexes on separate cache lines */
+  Cell m_cells[N];
+  char m_pad0[64];
+  std::atomic<size_t> m_head;
+  char m_pad1[64];
+  size_t m_tail;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_MPSC_RING_H_
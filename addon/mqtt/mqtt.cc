@@ -50,127 +50,154 @@ Persistent<Function> MqttWrapper::constructor;
 
 static void on_mqtt_connect(artik_mqtt_config *client_config, void *user_data,
     artik_error result) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   MqttWrapper* wrap = reinterpret_cast<MqttWrapper*>(client_config->handle);
 
   log_dbg("");
 
-  if (!wrap->getConnectCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, result]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    if (!wrap->getConnectCb())
+      return;
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, error_msg(result)))
-  };
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, error_msg(result)))
+    };
 
-  Local<Function>::New(isolate, *wrap->getConnectCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+    Local<Function>::New(isolate, *wrap->getConnectCb())->Call(
+        isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 }
 
 static void on_mqtt_disconnect(artik_mqtt_config *client_config,
     void *data_user, artik_error result) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   MqttWrapper* wrap = reinterpret_cast<MqttWrapper*>(client_config->handle);
 
   log_dbg("");
 
-  if (!wrap->getDisconnectCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, result]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    if (!wrap->getDisconnectCb())
+      return;
 
-  Handle<Value> argv[] = {
-    Handle<Value>(String::NewFromUtf8(isolate, error_msg(result)))
-  };
+    Handle<Value> argv[] = {
+      Handle<Value>(String::NewFromUtf8(isolate, error_msg(result)))
+    };
 
-  Local<Function>::New(isolate, *wrap->getDisconnectCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+    Local<Function>::New(isolate, *wrap->getDisconnectCb())->Call(
+        isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 }
 
 static void on_mqtt_subscribe(artik_mqtt_config *client_config, void *data_user,
     int mid, int qos_count, const int *granted_qos) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   MqttWrapper* wrap = reinterpret_cast<MqttWrapper*>(client_config->handle);
 
   log_dbg("");
 
-  if (!wrap->getSubscribeCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, mid]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    if (!wrap->getSubscribeCb())
+      return;
 
-  Handle<Value> argv[] = {
-    Handle<Value>(v8::Integer::New(isolate, mid))
-  };
+    Handle<Value> argv[] = {
+      Handle<Value>(v8::Integer::New(isolate, mid))
+    };
 
-  Local<Function>::New(isolate, *wrap->getSubscribeCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+    Local<Function>::New(isolate, *wrap->getSubscribeCb())->Call(
+        isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 }
 
 static void on_mqtt_unsubscribe(artik_mqtt_config *client_config,
     void *data_user, int mid) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   MqttWrapper* wrap = reinterpret_cast<MqttWrapper*>(client_config->handle);
 
   log_dbg("");
 
-  if (!wrap->getUnsubscribeCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, mid]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    if (!wrap->getUnsubscribeCb())
+      return;
 
-  Handle<Value> argv[] = {
-    Handle<Value>(v8::Integer::New(isolate, mid))
-  };
+    Handle<Value> argv[] = {
+      Handle<Value>(v8::Integer::New(isolate, mid))
+    };
 
-  Local<Function>::New(isolate, *wrap->getUnsubscribeCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+    Local<Function>::New(isolate, *wrap->getUnsubscribeCb())->Call(
+        isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 }
 
 static void on_mqtt_publish(artik_mqtt_config *client_config, void *data_user,
     int mid) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   MqttWrapper* wrap = reinterpret_cast<MqttWrapper*>(client_config->handle);
 
   log_dbg("");
 
-  if (!wrap->getPublishCb())
-    return;
+  GlibLoop::Instance()->invoke(wrap, [wrap, mid]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    if (!wrap->getPublishCb())
+      return;
 
-  Handle<Value> argv[] = {
-    Handle<Value>(v8::Integer::New(isolate, mid))
-  };
+    Handle<Value> argv[] = {
+      Handle<Value>(v8::Integer::New(isolate, mid))
+    };
 
-  Local<Function>::New(isolate, *wrap->getPublishCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+    Local<Function>::New(isolate, *wrap->getPublishCb())->Call(
+        isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 }
 
 static void on_mqtt_message(artik_mqtt_config *client_config, void *data_user,
     artik_mqtt_msg *msg) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   MqttWrapper* wrap = reinterpret_cast<MqttWrapper*>(client_config->handle);
+  int msg_id = msg->msg_id;
+  int qos = msg->qos;
+  bool retain = msg->retain;
+  std::string topic(msg->topic);
+  std::string payload(reinterpret_cast<char*>(msg->payload),
+      msg->payload_len);
 
   log_dbg("");
 
-  if (!wrap->getMessageCb())
-    return;
-
-  Handle<Value> argv[] = {
-    Handle<Value>(v8::Integer::New(isolate, msg->msg_id)),
-    Handle<Value>(String::NewFromUtf8(isolate, msg->topic)),
-    Handle<Value>(Nan::CopyBuffer(reinterpret_cast<char*>(msg->payload),
-        msg->payload_len).ToLocalChecked()),
-    Handle<Value>(v8::Integer::New(isolate, msg->qos)),
-    Handle<Value>(v8::Boolean::New(isolate, msg->retain)),
-  };
-
-  Local<Function>::New(isolate, *wrap->getMessageCb())->Call(
-      isolate->GetCurrentContext()->Global(), 5, argv);
+  GlibLoop::Instance()->invoke(wrap,
+      [wrap, msg_id, topic, payload, qos, retain]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    if (!wrap->getMessageCb())
+      return;
+
+    Handle<Value> argv[] = {
+      Handle<Value>(v8::Integer::New(isolate, msg_id)),
+      Handle<Value>(String::NewFromUtf8(isolate, topic.c_str())),
+      Handle<Value>(Nan::CopyBuffer(payload.data(),
+          payload.size()).ToLocalChecked()),
+      Handle<Value>(v8::Integer::New(isolate, qos)),
+      Handle<Value>(v8::Boolean::New(isolate, retain)),
+    };
+
+    Local<Function>::New(isolate, *wrap->getMessageCb())->Call(
+        isolate->GetCurrentContext()->Global(), 5, argv);
+  });
 }
 
 MqttWrapper::MqttWrapper(artik_mqtt_config const &config) {
   Isolate* isolate = Isolate::GetCurrent();
 
   try {
+    GlibLoop::SdkLock lock;
+
     m_mqtt = new Mqtt(config);
     m_mqtt->config().handle = this;
     m_mqtt->set_connect(on_mqtt_connect, NULL);
@@ -186,12 +213,17 @@ MqttWrapper::MqttWrapper(artik_mqtt_config const &config) {
   }
 
   m_loop = GlibLoop::Instance();
-  m_loop->attach();
+  m_loop->attach(true);
 }
 
 MqttWrapper::~MqttWrapper() {
-  delete m_mqtt;
-  m_loop->detach();
+  {
+    GlibLoop::SdkLock lock;
+
+    delete m_mqtt;
+  }
+  m_loop->cancel(this);
+  m_loop->detach(true);
 }
 
 void MqttWrapper::Init(Local<Object> exports) {
@@ -318,8 +350,12 @@ void MqttWrapper::set_willmsg(const v8::FunctionCallbackInfo<v8::Value>& args) {
   v8::String::Utf8Value will_topic(args[0]->ToString());
   v8::String::Utf8Value will_msg(args[1]->ToString());
 
-  ret = obj->set_willmsg(*will_topic, *will_msg, args[2]->NumberValue(),
-      args[3]->BooleanValue());
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->set_willmsg(*will_topic, *will_msg, args[2]->NumberValue(),
+        args[3]->BooleanValue());
+  }
 
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
@@ -333,7 +369,11 @@ void MqttWrapper::free_willmsg(
 
   log_dbg("");
 
-  ret = obj->free_willmsg();
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->free_willmsg();
+  }
 
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
@@ -347,7 +387,11 @@ void MqttWrapper::clear_willmsg(
 
   log_dbg("");
 
-  ret = obj->clear_willmsg();
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->clear_willmsg();
+  }
 
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
@@ -375,7 +419,11 @@ void MqttWrapper::connect(const v8::FunctionCallbackInfo<v8::Value>& args) {
     wrap->m_connect_cb->Reset(isolate, Local<Function>::Cast(args[2]));
   }
 
-  ret = obj->connect(*host, args[1]->NumberValue());
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->connect(*host, args[1]->NumberValue());
+  }
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
 
@@ -392,7 +440,11 @@ void MqttWrapper::disconnect(const v8::FunctionCallbackInfo<v8::Value>& args) {
     wrap->m_disconnect_cb->Reset(isolate, Local<Function>::Cast(args[0]));
   }
 
-  ret = obj->disconnect();
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->disconnect();
+  }
 
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
@@ -425,7 +477,11 @@ void MqttWrapper::subscribe(const v8::FunctionCallbackInfo<v8::Value>& args) {
     wrap->m_message_cb->Reset(isolate, Local<Function>::Cast(args[3]));
   }
 
-  ret = obj->subscribe(args[0]->BooleanValue(), *msg_topic);
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->subscribe(args[0]->BooleanValue(), *msg_topic);
+  }
 
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
@@ -453,7 +509,11 @@ void MqttWrapper::unsubscribe(const v8::FunctionCallbackInfo<v8::Value>& args) {
 
   v8::String::Utf8Value msg_topic(args[0]->ToString());
 
-  ret = obj->unsubscribe(*msg_topic);
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->unsubscribe(*msg_topic);
+  }
 
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
@@ -493,8 +553,12 @@ void MqttWrapper::publish(const v8::FunctionCallbackInfo<v8::Value>& args) {
     wrap->m_publish_cb->Reset(isolate, Local<Function>::Cast(args[4]));
   }
 
-  ret = obj->publish(args[0]->NumberValue(), args[1]->BooleanValue(),
-                     *msg_topic, length, buffer);
+  {
+    GlibLoop::SdkLock lock;
+
+    ret = obj->publish(args[0]->NumberValue(), args[1]->BooleanValue(),
+                       *msg_topic, length, buffer);
+  }
 
   args.GetReturnValue().Set(String::NewFromUtf8(isolate, error_msg(ret)));
 }
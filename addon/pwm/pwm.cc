@@ -18,6 +18,20 @@
 
 #include "pwm/pwm.h"
 
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <utils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 namespace artik {
 
 using v8::Exception;
@@ -34,16 +48,326 @@ using v8::Value;
 using v8::Context;
 
 Persistent<Function> PwmWrapper::constructor;
+Persistent<FunctionTemplate> PwmWrapper::tmpl;
+
+/*
+ * Waveform playback: a dedicated thread steps through precomputed tables of
+ * duty cycles (and optionally periods) on deadlines of the steady clock.
+ * All the channels of a sequence are written back to back at each step, so
+ * that they stay in phase. The JS callback is only involved once the
+ * sequence is over.
+ */
+struct PwmSequence {
+  struct Channel {
+    PwmWrapper* pwm;
+    std::vector<uint32_t> duty;
+    std::vector<uint32_t> period;
+    uint32_t current_duty;
+    uint32_t current_period;
+  };
+
+  std::vector<PwmWrapper*> wraps;
+  std::vector<Channel> channels;
+  uv_async_t async;
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable wakeup;
+  std::atomic<bool> quit;
+  bool done;
+  artik_error error;
+  std::chrono::nanoseconds interval;
+  size_t steps;
+  uint32_t repeat;
+  Nan::Persistent<v8::Array> handles;
+  Nan::Callback* callback;
+  size_t position;
+  uint32_t cycles;
+  uint64_t late;
+
+  void run();
+  artik_error write(Channel* channel, size_t step);
+};
+
+artik_error PwmSequence::write(Channel* channel, size_t step) {
+  uint32_t duty = channel->duty[step];
+  artik_error ret = S_OK;
+
+  if (!channel->period.empty()) {
+    uint32_t period = channel->period[step];
+
+    /* The duty cycle may never exceed the period, even transiently */
+    if (period != channel->current_period && period < channel->current_duty) {
+      ret = channel->pwm->write_duty_cycle(duty);
+      if (ret != S_OK)
+        return ret;
+      channel->current_duty = duty;
+    }
+    if (period != channel->current_period) {
+      ret = channel->pwm->write_period(period);
+      if (ret != S_OK)
+        return ret;
+      channel->current_period = period;
+    }
+  }
+
+  if (duty != channel->current_duty) {
+    ret = channel->pwm->write_duty_cycle(duty);
+    channel->current_duty = duty;
+  }
+
+  return ret;
+}
+
+void PwmSequence::run() {
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now();
+  size_t step = 0;
+  uint32_t cycle = 0;
+
+  for (;;) {
+    for (size_t c = 0; c < channels.size(); c++) {
+      artik_error ret = write(&channels[c], step);
+
+      if (ret != S_OK) {
+        std::lock_guard<std::mutex> l(lock);
+        error = ret;
+        done = true;
+        uv_async_send(&async);
+        return;
+      }
+    }
+
+    std::unique_lock<std::mutex> l(lock);
+
+    if (++step == steps) {
+      step = 0;
+      cycles = ++cycle;
+      if (repeat && cycle == repeat) {
+        done = true;
+        uv_async_send(&async);
+        return;
+      }
+    }
+    position = step;
+
+    /* Skip the steps that could not be honored instead of bursting */
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    deadline += interval;
+    while (deadline < now && step + 1 < steps) {
+      late++;
+      deadline += interval;
+      position = ++step;
+    }
+
+    if (wakeup.wait_until(l, deadline, [this] { return quit.load(); }))
+      return;
+  }
+}
+
+static void pwm_sequence_async_cb(uv_async_t* handle) {
+  PwmSequence* sequence = reinterpret_cast<PwmSequence*>(handle->data);
+  Nan::HandleScope scope;
+  artik_error error;
+  uint32_t cycles;
+
+  {
+    std::lock_guard<std::mutex> l(sequence->lock);
+    if (!sequence->done || sequence->wraps.empty())
+      return;
+    error = sequence->error;
+    cycles = sequence->cycles;
+  }
+
+  Nan::Callback* callback = sequence->callback;
+
+  /* Keep the callback alive past the sequence teardown */
+  sequence->callback = NULL;
+  sequence->wraps[0]->stop_sequence();
+
+  if (callback) {
+    Local<Value> err = Nan::Null();
+
+    if (error != S_OK)
+      err = Nan::Error(error_msg(error));
+
+    Local<Value> argv[2] = { err, Nan::New<Number>(cycles) };
+
+    callback->Call(2, argv);
+    delete callback;
+  }
+}
+
+static void pwm_sequence_close_cb(uv_handle_t* handle) {
+  PwmSequence* sequence = reinterpret_cast<PwmSequence*>(handle->data);
+
+  sequence->handles.Reset();
+  delete sequence->callback;
+  delete sequence;
+}
+
+/*
+ * Fill 'table' from either an Array or a typed array of numbers, or from a
+ * curve description: { shape, from, to, steps }.
+ */
+static bool sequence_table(Local<Value> val, std::vector<uint32_t>* table) {
+  if (val->IsArray() || val->IsTypedArray()) {
+    Local<Object> array = val.As<Object>();
+    auto length = js_object_attribute_to_cpp<uint32_t>(array, "length");
+
+    if (!length)
+      return false;
+
+    for (uint32_t i = 0; i < length.value(); i++) {
+      Local<Value> item = Nan::Get(array, i).ToLocalChecked();
+      double value = item->NumberValue();
+
+      if (!item->IsNumber() || value < 0 || value > UINT32_MAX)
+        return false;
+      table->push_back(static_cast<uint32_t>(value));
+    }
+
+    return !table->empty();
+  }
+
+  if (!val->IsObject())
+    return false;
+
+  auto shape = js_object_attribute_to_cpp<std::string>(val, "shape");
+  auto from = js_object_attribute_to_cpp<double>(val, "from");
+  auto to = js_object_attribute_to_cpp<double>(val, "to");
+  auto steps = js_object_attribute_to_cpp<uint32_t>(val, "steps");
+
+  if (!shape || !from || !to || !steps || steps.value() < 2 ||
+      from.value() < 0 || to.value() < 0 || from.value() > UINT32_MAX ||
+      to.value() > UINT32_MAX)
+    return false;
+
+  for (uint32_t i = 0; i < steps.value(); i++) {
+    double t = static_cast<double>(i) / (steps.value() - 1);
+    double y;
+
+    if (shape.value() == "linear") {
+      y = t;
+    } else if (shape.value() == "sine") {
+      /* One full period, starting and ending on 'from' */
+      t = static_cast<double>(i) / steps.value();
+      y = (1 - cos(2 * M_PI * t)) / 2;
+    } else if (shape.value() == "ease-in") {
+      y = t * t;
+    } else if (shape.value() == "ease-out") {
+      y = 1 - (1 - t) * (1 - t);
+    } else if (shape.value() == "ease-in-out") {
+      y = (1 - cos(M_PI * t)) / 2;
+    } else {
+      return false;
+    }
+
+    table->push_back(static_cast<uint32_t>(
+        lround(from.value() + (to.value() - from.value()) * y)));
+  }
+
+  return true;
+}
+
+static bool sequence_channel(Local<Value> options, PwmWrapper* pwm,
+    PwmSequence::Channel* channel) {
+  auto duty = js_object_attribute_to_cpp<Local<Value>>(options, "duty");
+  auto period = js_object_attribute_to_cpp<Local<Value>>(options, "period");
+
+  if (!duty || !sequence_table(duty.value(), &channel->duty))
+    return false;
+
+  if (period) {
+    if (!sequence_table(period.value(), &channel->period) ||
+        channel->period.size() != channel->duty.size())
+      return false;
+
+    for (size_t i = 0; i < channel->duty.size(); i++) {
+      if (channel->duty[i] > channel->period[i])
+        return false;
+    }
+  }
+
+  channel->pwm = pwm;
+  channel->current_duty = pwm->duty_cycle();
+  channel->current_period = pwm->period();
+
+  return true;
+}
 
 PwmWrapper::PwmWrapper(unsigned int pin_num, char *name, unsigned int period,
     artik_pwm_polarity_t  polarity, unsigned int duty_cycle) {
   m_pwm = new Pwm(pin_num, name, period, polarity, duty_cycle);
+  m_sequence = NULL;
 }
 
 PwmWrapper::~PwmWrapper() {
+  stop_sequence();
   delete m_pwm;
 }
 
+artik_error PwmWrapper::write_duty_cycle(unsigned int duty_cycle) {
+  if (m_fast_duty)
+    return m_fast_duty->write_int(duty_cycle);
+
+  return m_pwm->set_duty_cycle(duty_cycle);
+}
+
+artik_error PwmWrapper::write_period(unsigned int period) {
+  if (m_fast_period)
+    return m_fast_period->write_int(period);
+
+  return m_pwm->set_period(period);
+}
+
+unsigned int PwmWrapper::duty_cycle() {
+  int val;
+
+  if (m_fast_duty && m_fast_duty->read_int(&val) == S_OK)
+    return val;
+
+  return m_pwm->get_duty_cycle();
+}
+
+unsigned int PwmWrapper::period() {
+  int val;
+
+  if (m_fast_period && m_fast_period->read_int(&val) == S_OK)
+    return val;
+
+  return m_pwm->get_period();
+}
+
+void PwmWrapper::stop_sequence() {
+  PwmSequence* sequence = m_sequence;
+
+  if (!sequence)
+    return;
+
+  sequence->quit = true;
+  {
+    std::lock_guard<std::mutex> l(sequence->lock);
+    sequence->wakeup.notify_all();
+  }
+  sequence->thread.join();
+
+  std::vector<PwmWrapper*> wraps;
+
+  {
+    std::lock_guard<std::mutex> l(sequence->lock);
+    wraps.swap(sequence->wraps);
+  }
+
+  uv_close(reinterpret_cast<uv_handle_t*>(&sequence->async),
+           pwm_sequence_close_cb);
+
+  for (size_t i = 0; i < wraps.size(); i++) {
+    wraps[i]->m_sequence = NULL;
+    wraps[i]->Unref();
+  }
+}
+
 void PwmWrapper::Init(Local<Object> exports) {
   Isolate* isolate = exports->GetIsolate();
   Local<FunctionTemplate> modal = FunctionTemplate::New(isolate, New);
@@ -68,7 +392,14 @@ void PwmWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "set_pin_num", set_pin_num);
   NODE_SET_PROTOTYPE_METHOD(modal, "set_name", set_name);
 
+  NODE_SET_PROTOTYPE_METHOD(modal, "play", play);
+  NODE_SET_PROTOTYPE_METHOD(modal, "stop", stop);
+  NODE_SET_PROTOTYPE_METHOD(modal, "get_sequence_stats", get_sequence_stats);
+  NODE_SET_PROTOTYPE_METHOD(modal, "enable_fast_io", enable_fast_io);
+  NODE_SET_PROTOTYPE_METHOD(modal, "disable_fast_io", disable_fast_io);
+
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "pwm"),
       modal->GetFunction());
 }
@@ -124,8 +455,12 @@ void PwmWrapper::release(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  Pwm* obj = ObjectWrap::Unwrap<PwmWrapper>(args.Holder())->getObj();
-  args.GetReturnValue().Set(Number::New(isolate, obj->release()));
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
+
+  wrap->stop_sequence();
+  wrap->m_fast_duty.reset();
+  wrap->m_fast_period.reset();
+  args.GetReturnValue().Set(Number::New(isolate, wrap->getObj()->release()));
 }
 
 void PwmWrapper::enable(const FunctionCallbackInfo<Value>& args) {
@@ -154,9 +489,17 @@ void PwmWrapper::set_period(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  Pwm* obj = ObjectWrap::Unwrap<PwmWrapper>(args.Holder())->getObj();
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
+
+  /* The sequence thread owns the channel until it is over */
+  if (wrap->m_sequence) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "A sequence is already playing")));
+    return;
+  }
+
   args.GetReturnValue().Set(Number::New(isolate,
-      obj->set_period(static_cast<unsigned int>(args[0]->NumberValue()))));
+      wrap->write_period(static_cast<unsigned int>(args[0]->NumberValue()))));
 }
 
 void PwmWrapper::set_polarity(const FunctionCallbackInfo<Value>& args) {
@@ -176,9 +519,17 @@ void PwmWrapper::set_duty_cycle(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  Pwm* obj = ObjectWrap::Unwrap<PwmWrapper>(args.Holder())->getObj();
-  args.GetReturnValue().Set(Number::New(isolate,
-      obj->set_duty_cycle(static_cast<unsigned int>(args[0]->NumberValue()))));
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
+
+  /* The sequence thread owns the channel until it is over */
+  if (wrap->m_sequence) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "A sequence is already playing")));
+    return;
+  }
+
+  args.GetReturnValue().Set(Number::New(isolate, wrap->write_duty_cycle(
+      static_cast<unsigned int>(args[0]->NumberValue()))));
 }
 
 void PwmWrapper::get_pin_num(const FunctionCallbackInfo<Value>& args) {
@@ -208,9 +559,9 @@ void PwmWrapper::get_period(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  Pwm* obj = ObjectWrap::Unwrap<PwmWrapper>(args.Holder())->getObj();
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
   args.GetReturnValue().Set(
-      Number::New(isolate, static_cast<int>(obj->get_period())));
+      Number::New(isolate, static_cast<int>(wrap->period())));
 }
 
 void PwmWrapper::get_polarity(const FunctionCallbackInfo<Value>& args) {
@@ -229,8 +580,8 @@ void PwmWrapper::get_duty_cycle(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  Pwm* obj = ObjectWrap::Unwrap<PwmWrapper>(args.Holder())->getObj();
-  args.GetReturnValue().Set(Number::New(isolate, obj->get_duty_cycle()));
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
+  args.GetReturnValue().Set(Number::New(isolate, wrap->duty_cycle()));
 }
 
 void PwmWrapper::set_pin_num(const FunctionCallbackInfo<Value>& args) {
@@ -255,5 +606,197 @@ void PwmWrapper::set_name(const FunctionCallbackInfo<Value>& args) {
   obj->set_name(*val);
 }
 
-}  // namespace artik
+void PwmWrapper::play(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
+
+  if (args.Length() < 1 || args.Length() > 2 || !args[0]->IsObject() ||
+      (args.Length() == 2 && !args[1]->IsFunction())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  auto interval = js_object_attribute_to_cpp<double>(args[0], "interval");
+  auto mode = js_object_attribute_to_cpp<std::string>(args[0], "mode");
+  auto repeat = js_object_attribute_to_cpp<uint32_t>(args[0], "repeat");
+  auto sync = js_object_attribute_to_cpp<Local<v8::Array>>(args[0], "sync");
+
+  if (!interval || interval.value() <= 0 ||
+      (mode && mode.value() != "once" && mode.value() != "loop")) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Invalid sequence settings")));
+    return;
+  }
+
+  PwmSequence* sequence = new PwmSequence();
+  Local<v8::Array> handles = Nan::New<v8::Array>();
+
+  /* This PWM always comes first, then the synchronized channels in order */
+  sequence->wraps.push_back(wrap);
+  sequence->channels.resize(1);
+  if (!sequence_channel(args[0], wrap, &sequence->channels[0])) {
+    delete sequence;
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Invalid sequence table")));
+    return;
+  }
+
+  if (sync) {
+    Local<v8::Array> array = sync.value();
+    Local<FunctionTemplate> pwm_tmpl = Local<FunctionTemplate>::New(isolate,
+        tmpl);
+
+    for (unsigned int i = 0; i < array->Length(); i++) {
+      Local<Value> item = Nan::Get(array, i).ToLocalChecked();
+      auto pwm = js_object_attribute_to_cpp<Local<Value>>(item, "pwm");
+
+      if (!pwm || !pwm_tmpl->HasInstance(pwm.value())) {
+        delete sequence;
+        isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+            isolate, "Synchronized channels need a PWM instance")));
+        return;
+      }
+
+      PwmWrapper* other = ObjectWrap::Unwrap<PwmWrapper>(
+          pwm.value().As<Object>());
+      PwmSequence::Channel channel;
+
+      /* Two tables driving the same output would fight at each step */
+      if (std::find(sequence->wraps.begin(), sequence->wraps.end(), other) !=
+          sequence->wraps.end()) {
+        delete sequence;
+        isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+            isolate, "A PWM appears more than once in the sequence")));
+        return;
+      }
+
+      if (!sequence_channel(item, other, &channel) ||
+          channel.duty.size() != sequence->channels[0].duty.size()) {
+        delete sequence;
+        isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+            isolate, "Invalid sequence table")));
+        return;
+      }
+
+      sequence->wraps.push_back(other);
+      sequence->channels.push_back(channel);
+      Nan::Set(handles, i, pwm.value());
+    }
+  }
+
+  for (size_t i = 0; i < sequence->wraps.size(); i++) {
+    if (sequence->wraps[i]->m_sequence) {
+      delete sequence;
+      isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+          isolate, "A sequence is already playing")));
+      return;
+    }
+  }
+
+  sequence->quit = false;
+  sequence->done = false;
+  sequence->error = S_OK;
+  sequence->interval = std::chrono::nanoseconds(
+      static_cast<int64_t>(interval.value() * 1e6));
+  sequence->steps = sequence->channels[0].duty.size();
+  if (repeat)
+    sequence->repeat = repeat.value();
+  else
+    sequence->repeat = (mode && mode.value() == "loop") ? 0 : 1;
+  sequence->handles.Reset(handles);
+  sequence->callback = (args.Length() == 2) ?
+      new Nan::Callback(args[1].As<Function>()) : NULL;
+  sequence->position = 0;
+  sequence->cycles = 0;
+  sequence->late = 0;
+
+  sequence->async.data = sequence;
+  uv_async_init(uv_default_loop(), &sequence->async, pwm_sequence_async_cb);
+
+  /* Keep every wrapper alive for as long as the sequence plays */
+  for (size_t i = 0; i < sequence->wraps.size(); i++) {
+    sequence->wraps[i]->Ref();
+    sequence->wraps[i]->m_sequence = sequence;
+  }
+  sequence->thread = std::thread(&PwmSequence::run, sequence);
+}
+
+void PwmWrapper::stop(const FunctionCallbackInfo<Value>& args) {
+  ObjectWrap::Unwrap<PwmWrapper>(args.Holder())->stop_sequence();
+}
+
+void PwmWrapper::get_sequence_stats(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  PwmSequence* sequence =
+      ObjectWrap::Unwrap<PwmWrapper>(args.Holder())->m_sequence;
+  Local<Object> stats = Object::New(isolate);
+
+  if (sequence) {
+    std::lock_guard<std::mutex> l(sequence->lock);
+    stats->Set(String::NewFromUtf8(isolate, "position"),
+               Number::New(isolate, sequence->position));
+    stats->Set(String::NewFromUtf8(isolate, "cycles"),
+               Number::New(isolate, sequence->cycles));
+    stats->Set(String::NewFromUtf8(isolate, "late"),
+               Number::New(isolate, sequence->late));
+  }
+
+  args.GetReturnValue().Set(stats);
+}
+
+void PwmWrapper::enable_fast_io(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
+
+  if (args.Length() > 1 || (args.Length() == 1 && !args[0]->IsString())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (wrap->m_sequence) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "A sequence is already playing")));
+    return;
+  }
+
+  /* The pin number holds the chip in its upper byte */
+  unsigned int pin = wrap->getObj()->get_pin_num();
+  std::string root = args.Length() ? *v8::String::Utf8Value(args[0]) : "";
+  std::string dir = sysfs_path(root, "class/pwm/pwmchip" +
+      std::to_string(pin >> 8) + "/pwm" + std::to_string(pin & 0xff) + "/");
+  std::unique_ptr<SysfsFile> duty(new SysfsFile());
+  std::unique_ptr<SysfsFile> period(new SysfsFile());
+  int err = duty->open(dir + "duty_cycle", O_RDWR);
+
+  if (err == 0)
+    err = period->open(dir + "period", O_RDWR);
+
+  if (err < 0) {
+    std::string msg = "Cannot open " + dir + ": " + strerror(-err);
+
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, msg.c_str())));
+    return;
+  }
 
+  wrap->m_fast_duty = std::move(duty);
+  wrap->m_fast_period = std::move(period);
+}
+
+void PwmWrapper::disable_fast_io(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  PwmWrapper* wrap = ObjectWrap::Unwrap<PwmWrapper>(args.Holder());
+
+  if (wrap->m_sequence) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "A sequence is already playing")));
+    return;
+  }
+
+  wrap->m_fast_duty.reset();
+  wrap->m_fast_period.reset();
+}
+
+}  // namespace artik
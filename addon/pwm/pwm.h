@@ -26,14 +26,28 @@
 #include <uv.h>
 #include <artik_pwm.hh>
 
+#include <memory>
+
+#include "base/sysfs_file.h"
+
 namespace artik {
 
+struct PwmSequence;
+
 class PwmWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
 
   Pwm* getObj() { return m_pwm; }
 
+  void stop_sequence();
+
+  /* Go through the cached attributes when fast I/O is enabled */
+  artik_error write_duty_cycle(unsigned int duty_cycle);
+  artik_error write_period(unsigned int period);
+  unsigned int duty_cycle();
+  unsigned int period();
+
  private:
   PwmWrapper(unsigned int, char*, unsigned int, artik_pwm_polarity_t,
       unsigned int);
@@ -42,6 +56,7 @@ class PwmWrapper : public node::ObjectWrap {
 
   static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
   static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   static void request(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void release(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -60,7 +75,18 @@ class PwmWrapper : public node::ObjectWrap {
   static void set_pin_num(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void set_name(const v8::FunctionCallbackInfo<v8::Value>& args);
 
+  static void play(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stop(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_sequence_stats(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void enable_fast_io(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void disable_fast_io(
+      const v8::FunctionCallbackInfo<v8::Value>& args);
+
   Pwm *m_pwm;
+  PwmSequence* m_sequence;
+  std::unique_ptr<SysfsFile> m_fast_duty;
+  std::unique_ptr<SysfsFile> m_fast_period;
 };
 
 }  // namespace artik
@@ -0,0 +1,263 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "recorder/recorder.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <utils.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace artik {
+
+using v8::Exception;
+using v8::Function;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Isolate;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::Persistent;
+using v8::String;
+using v8::Value;
+using v8::Context;
+
+Persistent<Function> RecorderWrapper::constructor;
+Persistent<FunctionTemplate> RecorderWrapper::tmpl;
+
+static Local<v8::Float64Array> to_float64_array(Isolate* isolate,
+    const std::vector<double>& values) {
+  size_t size = values.size() * sizeof(double);
+  Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, size);
+
+  if (size)
+    memcpy(buffer->GetContents().Data(), values.data(), size);
+
+  return v8::Float64Array::New(buffer, 0, values.size());
+}
+
+RecorderWrapper::RecorderWrapper(RingFile* file) : m_file(file) {
+}
+
+RecorderWrapper::~RecorderWrapper() {
+  /* Hubs and streams still holding the file keep it open */
+}
+
+RecorderWrapper* RecorderWrapper::from_js(Local<Value> value) {
+  Isolate* isolate = Isolate::GetCurrent();
+
+  if (!Local<FunctionTemplate>::New(isolate, tmpl)->HasInstance(value))
+    return NULL;
+
+  return ObjectWrap::Unwrap<RecorderWrapper>(value.As<Object>());
+}
+
+void RecorderWrapper::Init(Local<Object> exports) {
+  Isolate* isolate = exports->GetIsolate();
+
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(String::NewFromUtf8(isolate, "recorder"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototypes
+  NODE_SET_PROTOTYPE_METHOD(tpl, "append", append);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "query", query);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get_info", get_info);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "sync", sync);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "close", close);
+
+  constructor.Reset(isolate, tpl->GetFunction());
+  tmpl.Reset(isolate, tpl);
+  exports->Set(String::NewFromUtf8(isolate, "recorder"),
+               tpl->GetFunction());
+}
+
+void RecorderWrapper::New(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (!args.IsConstructCall()) {
+    const int argc = 2;
+    Local<Value> argv[argc] = { args[0], args[1] };
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Function> cons = Local<Function>::New(isolate, constructor);
+    args.GetReturnValue().Set(
+        cons->NewInstance(context, argc, argv).ToLocalChecked());
+    return;
+  }
+
+  if (!args[0]->IsString() ||
+      (!args[1]->IsUndefined() && !args[1]->IsObject())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  auto channels = js_object_attribute_to_cpp<uint32_t>(args[1], "channels");
+  auto capacity = js_object_attribute_to_cpp<double>(args[1], "capacity");
+
+  if ((channels && (channels.value() == 0 || channels.value() > 4096)) ||
+      (capacity && (!(capacity.value() >= 1) || capacity.value() > 1e9 ||
+                    capacity.value() != floor(capacity.value())))) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Invalid recorder settings")));
+    return;
+  }
+
+  std::string error;
+  RingFile* file = RingFile::open(*String::Utf8Value(args[0]),
+      channels ? channels.value() : 0,
+      capacity ? static_cast<uint64_t>(capacity.value()) : 0, &error);
+
+  if (!file) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, error.c_str())));
+    return;
+  }
+
+  RecorderWrapper* obj = new RecorderWrapper(file);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void RecorderWrapper::append(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  RingFile* file =
+      ObjectWrap::Unwrap<RecorderWrapper>(args.Holder())->m_file.get();
+  std::vector<double> values;
+
+  if (args.Length() < 1 || args.Length() > 2 ||
+      (args.Length() == 2 && !args[1]->IsNumber())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (args[0]->IsFloat64Array()) {
+    Nan::TypedArrayContents<double> contents(args[0]);
+
+    values.assign(*contents, *contents + contents.length());
+  } else if (args[0]->IsArray()) {
+    Local<v8::Array> array = args[0].As<v8::Array>();
+
+    for (unsigned int i = 0; i < array->Length(); i++)
+      values.push_back(Nan::Get(array, i).ToLocalChecked()->NumberValue());
+  } else {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (values.size() != file->channels()) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Values do not match the channels of the recorder")));
+    return;
+  }
+
+  double timestamp = args.Length() == 2 ? args[1]->NumberValue() :
+      RingFile::now();
+
+  if (!file->append(&timestamp, values.data(), 1)) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Recorder is closed")));
+    return;
+  }
+}
+
+void RecorderWrapper::query(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  RingFile* file =
+      ObjectWrap::Unwrap<RecorderWrapper>(args.Holder())->m_file.get();
+
+  if (args.Length() < 2 || args.Length() > 3 || !args[0]->IsNumber() ||
+      !args[1]->IsNumber() || (args.Length() == 3 && !args[2]->IsNumber())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  double max = args.Length() == 3 ? args[2]->NumberValue() :
+      std::numeric_limits<double>::infinity();
+
+  if (!(max >= 0)) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Invalid maximum count")));
+    return;
+  }
+
+  std::vector<double> timestamps;
+  std::vector<double> values;
+  Local<Object> result = Object::New(isolate);
+
+  file->query(args[0]->NumberValue(), args[1]->NumberValue(),
+      max < SIZE_MAX ? static_cast<size_t>(max) : SIZE_MAX, &timestamps,
+      &values);
+
+  result->Set(String::NewFromUtf8(isolate, "timestamps"),
+              to_float64_array(isolate, timestamps));
+  result->Set(String::NewFromUtf8(isolate, "values"),
+              to_float64_array(isolate, values));
+
+  args.GetReturnValue().Set(result);
+}
+
+void RecorderWrapper::get_info(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  RingFile::Info info =
+      ObjectWrap::Unwrap<RecorderWrapper>(args.Holder())->m_file->info();
+  Local<Object> result = Object::New(isolate);
+
+  result->Set(String::NewFromUtf8(isolate, "channels"),
+              Number::New(isolate, info.channels));
+  result->Set(String::NewFromUtf8(isolate, "capacity"),
+              Number::New(isolate, info.capacity));
+  result->Set(String::NewFromUtf8(isolate, "count"),
+              Number::New(isolate, info.count));
+  result->Set(String::NewFromUtf8(isolate, "written"),
+              Number::New(isolate, info.written));
+  result->Set(String::NewFromUtf8(isolate, "first"),
+              Number::New(isolate, info.first));
+  result->Set(String::NewFromUtf8(isolate, "last"),
+              Number::New(isolate, info.last));
+
+  args.GetReturnValue().Set(result);
+}
+
+void RecorderWrapper::sync(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  int err = ObjectWrap::Unwrap<RecorderWrapper>(args.Holder())->m_file->sync();
+
+  if (err < 0) {
+    std::string msg = std::string("Cannot sync the recorder: ") +
+        strerror(-err);
+
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, msg.c_str())));
+  }
+}
+
+void RecorderWrapper::close(const FunctionCallbackInfo<Value>& args) {
+  ObjectWrap::Unwrap<RecorderWrapper>(args.Holder())->m_file->close();
+}
+
+}  // namespace artik
@@ -0,0 +1,61 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_RECORDER_RECORDER_H_
+#define ADDON_RECORDER_RECORDER_H_
+
+#include <node.h>
+#include <nan.h>
+#include <node_object_wrap.h>
+
+#include <memory>
+
+#include "recorder/ring_file.h"
+
+namespace artik {
+
+class RecorderWrapper : public node::ObjectWrap {
+ public:
+  static void Init(v8::Local<v8::Object> exports);
+
+  /* Recorder wrapped by 'value', NULL if it is something else */
+  static RecorderWrapper* from_js(v8::Local<v8::Value> value);
+
+  /* Shared with the sensor hubs and ADC streams feeding the recorder */
+  std::shared_ptr<RingFile> getFile() { return m_file; }
+
+ private:
+  explicit RecorderWrapper(RingFile* file);
+  ~RecorderWrapper();
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static v8::Persistent<v8::Function> constructor;
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
+
+  static void append(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void query(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_info(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void sync(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void close(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  std::shared_ptr<RingFile> m_file;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_RECORDER_RECORDER_H_
@@ -0,0 +1,341 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "recorder/ring_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+
+#define RING_FILE_MAGIC "ARTIKREC"
+#define RING_FILE_VERSION 1
+#define RING_FILE_HEADER_SIZE 4096
+
+namespace artik {
+
+struct RingFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t channels;
+  uint64_t capacity;
+  uint64_t record_size;
+  /* Covers the fields above */
+  uint64_t checksum;
+  uint64_t written;
+  double last_timestamp;
+};
+
+struct RingFileRecord {
+  /* Sequence number plus one, 0 while the record is being written */
+  uint64_t seq;
+  double timestamp;
+  double values[];
+};
+
+static uint64_t header_checksum(const RingFileHeader* header) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(header);
+  uint64_t hash = 14695981039346656037ULL;
+
+  /* FNV-1a */
+  for (size_t i = 0; i < offsetof(RingFileHeader, checksum); i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+/*
+ * Size of a file of the given layout, false if it cannot be mapped in the
+ * address space or does not fit in a file offset.
+ */
+static bool file_size(uint64_t channels, uint64_t capacity, size_t* size) {
+  uint64_t record_size = sizeof(RingFileRecord) + channels * sizeof(double);
+  uint64_t max_size = std::min<uint64_t>(SIZE_MAX,
+      std::numeric_limits<off_t>::max());
+
+  if (!capacity || capacity > (max_size - RING_FILE_HEADER_SIZE) / record_size)
+    return false;
+
+  *size = RING_FILE_HEADER_SIZE + capacity * record_size;
+  return true;
+}
+
+RingFile::RingFile()
+  : m_fd(-1),
+    m_map(NULL),
+    m_size(0),
+    m_header(NULL),
+    m_channels(0),
+    m_capacity(0),
+    m_record_size(0) {
+}
+
+RingFile::~RingFile() {
+  close();
+}
+
+RingFile* RingFile::open(const std::string& path, uint32_t channels,
+    uint64_t capacity, std::string* error) {
+  RingFile* file = new RingFile();
+  struct stat st;
+  size_t expected_size;
+  bool created;
+
+  file->m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (file->m_fd < 0 || fstat(file->m_fd, &st) < 0) {
+    *error = "Cannot open " + path + ": " + strerror(errno);
+    delete file;
+    return NULL;
+  }
+
+  created = (st.st_size == 0);
+  if (created) {
+    if (!channels || !capacity) {
+      *error = "Channels and capacity are needed to create " + path;
+      delete file;
+      return NULL;
+    }
+
+    if (!file_size(channels, capacity, &file->m_size)) {
+      *error = "Capacity too large for " + path;
+      delete file;
+      return NULL;
+    }
+
+    /* Reserve the blocks now rather than fault on a full disk later */
+    int err = posix_fallocate(file->m_fd, 0, file->m_size);
+
+    if (err) {
+      *error = "Cannot allocate " + path + ": " + strerror(err);
+      /* Back to empty so that the creation can be retried */
+      if (ftruncate(file->m_fd, 0) < 0) {
+        /* Otherwise rejected as corrupted when reopened */
+      }
+      delete file;
+      return NULL;
+    }
+  } else {
+    if (st.st_size < RING_FILE_HEADER_SIZE ||
+        static_cast<uint64_t>(st.st_size) > SIZE_MAX) {
+      *error = path + " is not a recorder file";
+      delete file;
+      return NULL;
+    }
+    file->m_size = st.st_size;
+  }
+
+  void* map = mmap(NULL, file->m_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+      file->m_fd, 0);
+
+  if (map == MAP_FAILED) {
+    *error = "Cannot map " + path + ": " + strerror(errno);
+    delete file;
+    return NULL;
+  }
+
+  file->m_map = reinterpret_cast<uint8_t*>(map);
+  file->m_header = reinterpret_cast<RingFileHeader*>(map);
+
+  RingFileHeader* header = file->m_header;
+
+  if (created) {
+    header->version = RING_FILE_VERSION;
+    header->channels = channels;
+    header->capacity = capacity;
+    header->record_size = sizeof(RingFileRecord) + channels * sizeof(double);
+    memcpy(header->magic, RING_FILE_MAGIC, sizeof(header->magic));
+    header->checksum = header_checksum(header);
+    header->written = 0;
+    header->last_timestamp = -INFINITY;
+    msync(map, RING_FILE_HEADER_SIZE, MS_SYNC);
+  } else if (memcmp(header->magic, RING_FILE_MAGIC, sizeof(header->magic)) ||
+             header->version != RING_FILE_VERSION ||
+             header->checksum != header_checksum(header) ||
+             header->record_size !=
+                 sizeof(RingFileRecord) +
+                 static_cast<uint64_t>(header->channels) * sizeof(double) ||
+             !file_size(header->channels, header->capacity,
+                 &expected_size) ||
+             file->m_size != expected_size) {
+    *error = path + " is not a recorder file or is corrupted";
+    delete file;
+    return NULL;
+  } else if ((channels && channels != header->channels) ||
+             (capacity && capacity != header->capacity)) {
+    *error = path + " was created with a different layout";
+    delete file;
+    return NULL;
+  }
+
+  file->m_channels = header->channels;
+  file->m_capacity = header->capacity;
+  file->m_record_size = header->record_size;
+
+  /* Pick up the records written after the last update of the header */
+  uint64_t written = header->written;
+
+  for (uint64_t i = 0; i < file->m_capacity; i++) {
+    RingFileRecord* rec =
+        reinterpret_cast<RingFileRecord*>(file->record(written));
+
+    if (rec->seq != written + 1)
+      break;
+    header->last_timestamp = rec->timestamp;
+    written++;
+  }
+  header->written = written;
+
+  return file;
+}
+
+double RingFile::now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return static_cast<double>(ts.tv_sec) * 1e3 + ts.tv_nsec / 1e6;
+}
+
+uint8_t* RingFile::record(uint64_t seq) {
+  return m_map + RING_FILE_HEADER_SIZE + (seq % m_capacity) * m_record_size;
+}
+
+double RingFile::timestamp(uint64_t seq) {
+  return reinterpret_cast<RingFileRecord*>(record(seq))->timestamp;
+}
+
+bool RingFile::append(const double* timestamps, const double* values,
+    size_t count) {
+  std::lock_guard<std::mutex> l(m_lock);
+
+  if (!m_map)
+    return false;
+
+  for (size_t i = 0; i < count; i++) {
+    uint64_t seq = m_header->written;
+    RingFileRecord* rec = reinterpret_cast<RingFileRecord*>(record(seq));
+    double ts = timestamps[i];
+
+    /* Keep the timestamps sorted for the binary search */
+    if (!(ts >= m_header->last_timestamp))
+      ts = m_header->last_timestamp;
+
+    __atomic_store_n(&rec->seq, 0, __ATOMIC_RELEASE);
+    rec->timestamp = ts;
+    memcpy(rec->values, values + i * m_channels, m_channels * sizeof(double));
+    __atomic_store_n(&rec->seq, seq + 1, __ATOMIC_RELEASE);
+
+    m_header->last_timestamp = ts;
+    __atomic_store_n(&m_header->written, seq + 1, __ATOMIC_RELEASE);
+  }
+
+  return true;
+}
+
+uint64_t RingFile::lower_bound(uint64_t first, uint64_t last, double ts,
+    bool upper) {
+  while (first < last) {
+    uint64_t mid = first + (last - first) / 2;
+    double t = timestamp(mid);
+
+    if (upper ? t <= ts : t < ts)
+      first = mid + 1;
+    else
+      last = mid;
+  }
+
+  return first;
+}
+
+size_t RingFile::query(double from, double to, size_t max,
+    std::vector<double>* timestamps, std::vector<double>* values) {
+  std::lock_guard<std::mutex> l(m_lock);
+
+  timestamps->clear();
+  values->clear();
+  if (!m_map)
+    return 0;
+
+  uint64_t written = m_header->written;
+  uint64_t first = written > m_capacity ? written - m_capacity : 0;
+  uint64_t begin = lower_bound(first, written, from, false);
+  uint64_t end = lower_bound(begin, written, to, true);
+
+  for (uint64_t seq = begin; seq < end && timestamps->size() < max; seq++) {
+    RingFileRecord* rec = reinterpret_cast<RingFileRecord*>(record(seq));
+
+    /* Skip a record torn by a crash */
+    if (rec->seq != seq + 1)
+      continue;
+
+    timestamps->push_back(rec->timestamp);
+    values->insert(values->end(), rec->values, rec->values + m_channels);
+  }
+
+  return timestamps->size();
+}
+
+RingFile::Info RingFile::info() {
+  std::lock_guard<std::mutex> l(m_lock);
+  Info info;
+
+  info.channels = m_channels;
+  info.capacity = m_capacity;
+  info.written = m_map ? m_header->written : 0;
+  info.count = std::min(info.written, m_capacity);
+  info.first = info.count ? timestamp(info.written - info.count) : NAN;
+  info.last = info.count ? m_header->last_timestamp : NAN;
+
+  return info;
+}
+
+int RingFile::sync() {
+  std::lock_guard<std::mutex> l(m_lock);
+
+  if (!m_map)
+    return -EBADF;
+
+  return msync(m_map, m_size, MS_SYNC) < 0 ? -errno : 0;
+}
+
+void RingFile::close() {
+  std::lock_guard<std::mutex> l(m_lock);
+
+  if (m_map) {
+    msync(m_map, m_size, MS_SYNC);
+    munmap(m_map, m_size);
+    m_map = NULL;
+    m_header = NULL;
+  }
+
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+}
+
+}  // namespace artik
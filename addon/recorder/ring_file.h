@@ -0,0 +1,96 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_RECORDER_RING_FILE_H_
+#define ADDON_RECORDER_RING_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace artik {
+
+struct RingFileHeader;
+
+/*
+ * Circular file of fixed-size records, mapped in memory. Each record holds
+ * a timestamp and a fixed number of doubles. Timestamps never decrease, so
+ * the records of a time range are found by binary search.
+ *
+ * A record is written before its sequence number, and the sequence number
+ * before the count of records in the header. After a crash, reopening the
+ * file picks up every record whose sequence number made it to the mapping,
+ * even if the header was not updated.
+ */
+class RingFile {
+ public:
+  struct Info {
+    uint32_t channels;
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t written;
+    double first;
+    double last;
+  };
+
+  ~RingFile();
+
+  /* Create or reopen 'path', returns NULL and sets 'error' on failure */
+  static RingFile* open(const std::string& path, uint32_t channels,
+      uint64_t capacity, std::string* error);
+
+  /* 'values' holds 'count' records of channels() doubles each */
+  bool append(const double* timestamps, const double* values, size_t count);
+
+  /* Records with from <= timestamp <= to, at most 'max' of them */
+  size_t query(double from, double to, size_t max,
+      std::vector<double>* timestamps, std::vector<double>* values);
+
+  Info info();
+  int sync();
+  void close();
+
+  uint32_t channels() const { return m_channels; }
+
+  /* Milliseconds since the epoch, the usual timestamp of a record */
+  static double now();
+
+ private:
+  RingFile();
+
+  uint8_t* record(uint64_t seq);
+  double timestamp(uint64_t seq);
+  uint64_t lower_bound(uint64_t first, uint64_t last, double ts,
+      bool upper);
+
+  std::mutex m_lock;
+  int m_fd;
+  uint8_t* m_map;
+  size_t m_size;
+  RingFileHeader* m_header;
+  uint32_t m_channels;
+  uint64_t m_capacity;
+  size_t m_record_size;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_RECORDER_RING_FILE_H_
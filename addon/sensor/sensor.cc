@@ -18,6 +18,8 @@
 
 #include "sensor/sensor.h"
 
+#include <mutex>
+
 namespace artik {
 
 using v8::Exception;
@@ -38,14 +40,23 @@ using v8::Context;
 Persistent<Function> SensorWrapper::constructor;
 Persistent<Function> SensorDeviceWrapper::constructor;
 Persistent<Function> AccelerometerWrapper::constructor;
+Persistent<FunctionTemplate> AccelerometerWrapper::tmpl;
 Persistent<Function> HumidityWrapper::constructor;
+Persistent<FunctionTemplate> HumidityWrapper::tmpl;
 Persistent<Function> LightWrapper::constructor;
+Persistent<FunctionTemplate> LightWrapper::tmpl;
 Persistent<Function> TemperatureWrapper::constructor;
+Persistent<FunctionTemplate> TemperatureWrapper::tmpl;
 Persistent<Function> ProximityWrapper::constructor;
+Persistent<FunctionTemplate> ProximityWrapper::tmpl;
 Persistent<Function> FlameWrapper::constructor;
+Persistent<FunctionTemplate> FlameWrapper::tmpl;
 Persistent<Function> GyroWrapper::constructor;
+Persistent<FunctionTemplate> GyroWrapper::tmpl;
 Persistent<Function> PressureWrapper::constructor;
+Persistent<FunctionTemplate> PressureWrapper::tmpl;
 Persistent<Function> HallWrapper::constructor;
+Persistent<FunctionTemplate> HallWrapper::tmpl;
 
 v8::Handle<FunctionTemplate> SensorDeviceWrapper::modal;
 v8::Handle<FunctionTemplate> AccelerometerWrapper::modal;
@@ -58,6 +69,53 @@ v8::Handle<FunctionTemplate> PressureWrapper::modal;
 v8::Handle<FunctionTemplate> GyroWrapper::modal;
 v8::Handle<FunctionTemplate> HallWrapper::modal;
 
+/*
+ * Common part of the read_all() methods: fill the Float32Array passed by
+ * the caller, at an optional offset, or a new one.
+ */
+static void return_axes(const FunctionCallbackInfo<Value>& args,
+    const double* axes) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() == 0) {
+    Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate,
+        3 * sizeof(float));
+    float* out = reinterpret_cast<float*>(buffer->GetContents().Data());
+
+    for (int i = 0; i < 3; i++)
+      out[i] = axes[i];
+    args.GetReturnValue().Set(v8::Float32Array::New(buffer, 0, 3));
+    return;
+  }
+
+  Nan::TypedArrayContents<float> out(args[0]);
+  size_t offset = args.Length() > 1 ? args[1]->Uint32Value() : 0;
+
+  if (offset > out.length() || out.length() - offset < 3) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Array too small for the sample")));
+    return;
+  }
+
+  for (int i = 0; i < 3; i++)
+    (*out)[offset + i] = axes[i];
+  args.GetReturnValue().Set(args[0]);
+}
+
+static bool check_axes_args(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() > 2 ||
+      (args.Length() > 0 && !args[0]->IsFloat32Array()) ||
+      (args.Length() > 1 && !args[1]->IsUint32())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return false;
+  }
+
+  return true;
+}
+
 // SENSORDEVICE BASE IMPLEMENTATION
 
 SensorDeviceWrapper::SensorDeviceWrapper(SensorDevice *obj) {
@@ -229,8 +287,10 @@ void AccelerometerWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "get_speed_x", get_speed_x);
   NODE_SET_PROTOTYPE_METHOD(modal, "get_speed_y", get_speed_y);
   NODE_SET_PROTOTYPE_METHOD(modal, "get_speed_z", get_speed_z);
+  NODE_SET_PROTOTYPE_METHOD(modal, "read_all", read_all);
 
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Accelerometer"),
       modal->GetFunction());
 }
@@ -288,8 +348,10 @@ void AccelerometerWrapper::get_speed_x(
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  AccelerometerSensor* obj = ObjectWrap::Unwrap<AccelerometerWrapper>(
-      args.Holder())->getObj();
+  AccelerometerWrapper* wrap = ObjectWrap::Unwrap<AccelerometerWrapper>(
+      args.Holder());
+  AccelerometerSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_speed_x()));
 }
@@ -301,8 +363,10 @@ void AccelerometerWrapper::get_speed_y(
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  AccelerometerSensor* obj = ObjectWrap::Unwrap<AccelerometerWrapper>(
-      args.Holder())->getObj();
+  AccelerometerWrapper* wrap = ObjectWrap::Unwrap<AccelerometerWrapper>(
+      args.Holder());
+  AccelerometerSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_speed_y()));
 }
@@ -314,12 +378,40 @@ void AccelerometerWrapper::get_speed_z(
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  AccelerometerSensor* obj = ObjectWrap::Unwrap<AccelerometerWrapper>(
-      args.Holder())->getObj();
+  AccelerometerWrapper* wrap = ObjectWrap::Unwrap<AccelerometerWrapper>(
+      args.Holder());
+  AccelerometerSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_speed_z()));
 }
 
+void AccelerometerWrapper::sample(double* out) {
+  std::lock_guard<std::mutex> io(m_lock);
+
+  out[0] = m_sensor->get_speed_x();
+  out[1] = m_sensor->get_speed_y();
+  out[2] = m_sensor->get_speed_z();
+}
+
+void AccelerometerWrapper::read_all(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  double axes[3];
+
+  if (!check_axes_args(args))
+    return;
+
+  try {
+    ObjectWrap::Unwrap<AccelerometerWrapper>(args.Holder())->sample(axes);
+  } catch (artik::ArtikException e) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, e.what())));
+    return;
+  }
+
+  return_axes(args, axes);
+}
+
 // GYROMETER DEVICE IMPLEMENTATION
 
 GyroWrapper::GyroWrapper(GyroSensor *obj) {
@@ -351,8 +443,10 @@ void GyroWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "get_yaw", get_yaw);
   NODE_SET_PROTOTYPE_METHOD(modal, "get_pitch", get_pitch);
   NODE_SET_PROTOTYPE_METHOD(modal, "get_roll", get_roll);
+  NODE_SET_PROTOTYPE_METHOD(modal, "read_all", read_all);
 
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Gyro"),
       modal->GetFunction());
 }
@@ -409,7 +503,9 @@ void GyroWrapper::get_yaw(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  GyroSensor* obj = ObjectWrap::Unwrap<GyroWrapper>(args.Holder())->getObj();
+  GyroWrapper* wrap = ObjectWrap::Unwrap<GyroWrapper>(args.Holder());
+  GyroSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_yaw()));
 }
@@ -420,7 +516,9 @@ void GyroWrapper::get_pitch(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  GyroSensor* obj = ObjectWrap::Unwrap<GyroWrapper>(args.Holder())->getObj();
+  GyroWrapper* wrap = ObjectWrap::Unwrap<GyroWrapper>(args.Holder());
+  GyroSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_pitch()));
 }
@@ -431,11 +529,39 @@ void GyroWrapper::get_roll(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  GyroSensor* obj = ObjectWrap::Unwrap<GyroWrapper>(args.Holder())->getObj();
+  GyroWrapper* wrap = ObjectWrap::Unwrap<GyroWrapper>(args.Holder());
+  GyroSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_roll()));
 }
 
+void GyroWrapper::sample(double* out) {
+  std::lock_guard<std::mutex> io(m_lock);
+
+  out[0] = m_sensor->get_yaw();
+  out[1] = m_sensor->get_pitch();
+  out[2] = m_sensor->get_roll();
+}
+
+void GyroWrapper::read_all(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  double axes[3];
+
+  if (!check_axes_args(args))
+    return;
+
+  try {
+    ObjectWrap::Unwrap<GyroWrapper>(args.Holder())->sample(axes);
+  } catch (artik::ArtikException e) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, e.what())));
+    return;
+  }
+
+  return_axes(args, axes);
+}
+
 // HUMIDITY DEVICE IMPLEMENTATION
 
 HumidityWrapper::HumidityWrapper(HumiditySensor *obj) {
@@ -467,6 +593,7 @@ void HumidityWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "get_humidity", get_humidity);
 
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Humidity"),
       modal->GetFunction());
 }
@@ -523,8 +650,9 @@ void HumidityWrapper::get_humidity(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  HumiditySensor* obj = ObjectWrap::Unwrap<HumidityWrapper>(
-      args.Holder())->getObj();
+  HumidityWrapper* wrap = ObjectWrap::Unwrap<HumidityWrapper>(args.Holder());
+  HumiditySensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_humidity()));
 }
@@ -560,6 +688,7 @@ void LightWrapper::Init(Local<Object> exports) {
   // Prototypes
   NODE_SET_PROTOTYPE_METHOD(modal, "get_intensity", get_intensity);
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Light"),
       modal->GetFunction());
 }
@@ -614,7 +743,9 @@ void LightWrapper::get_intensity(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  LightSensor* obj = ObjectWrap::Unwrap<LightWrapper>(args.Holder())->getObj();
+  LightWrapper* wrap = ObjectWrap::Unwrap<LightWrapper>(args.Holder());
+  LightSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_intensity()));
 }
@@ -651,6 +782,7 @@ void TemperatureWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "get_fahrenheit", get_fahrenheit);
 
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Temperature"),
       modal->GetFunction());
 }
@@ -706,8 +838,10 @@ void TemperatureWrapper::get_celsius(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  TemperatureSensor* obj = ObjectWrap::Unwrap<TemperatureWrapper>(
-      args.Holder())->getObj();
+  TemperatureWrapper* wrap = ObjectWrap::Unwrap<TemperatureWrapper>(
+      args.Holder());
+  TemperatureSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_celsius()));
 }
@@ -719,8 +853,10 @@ void TemperatureWrapper::get_fahrenheit(
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  TemperatureSensor* obj = ObjectWrap::Unwrap<TemperatureWrapper>(
-      args.Holder())->getObj();
+  TemperatureWrapper* wrap = ObjectWrap::Unwrap<TemperatureWrapper>(
+      args.Holder());
+  TemperatureSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_fahrenheit()));
 }
@@ -756,6 +892,7 @@ void ProximityWrapper::Init(Local<Object> exports) {
   // Prototypes
   NODE_SET_PROTOTYPE_METHOD(modal, "get_presence", get_presence);
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Proximity"),
       modal->GetFunction());
 }
@@ -811,8 +948,9 @@ void ProximityWrapper::get_presence(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  ProximitySensor* obj = ObjectWrap::Unwrap<ProximityWrapper>(
-      args.Holder())->getObj();
+  ProximityWrapper* wrap = ObjectWrap::Unwrap<ProximityWrapper>(args.Holder());
+  ProximitySensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_presence()));
 }
@@ -848,6 +986,7 @@ void FlameWrapper::Init(Local<Object> exports) {
   // Prototypes
   NODE_SET_PROTOTYPE_METHOD(modal, "get_signals", get_signals);
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Flame"),
       modal->GetFunction());
 }
@@ -902,7 +1041,9 @@ void FlameWrapper::get_signals(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  FlameSensor* obj = ObjectWrap::Unwrap<FlameWrapper>(args.Holder())->getObj();
+  FlameWrapper* wrap = ObjectWrap::Unwrap<FlameWrapper>(args.Holder());
+  FlameSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_signals()));
 }
@@ -938,6 +1079,7 @@ void PressureWrapper::Init(Local<Object> exports) {
   // Prototypes
   NODE_SET_PROTOTYPE_METHOD(modal, "get_pressure", get_pressure);
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Pressure"),
       modal->GetFunction());
 }
@@ -994,8 +1136,9 @@ void PressureWrapper::get_pressure(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  PressureSensor* obj = ObjectWrap::Unwrap<PressureWrapper>(
-      args.Holder())->getObj();
+  PressureWrapper* wrap = ObjectWrap::Unwrap<PressureWrapper>(args.Holder());
+  PressureSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_pressure()));
 }
@@ -1031,6 +1174,7 @@ void HallWrapper::Init(Local<Object> exports) {
   // Prototypes
   NODE_SET_PROTOTYPE_METHOD(modal, "get_detection", get_detection);
   constructor.Reset(isolate, modal->GetFunction());
+  tmpl.Reset(isolate, modal);
   exports->Set(v8::String::NewFromUtf8(isolate, "Hall"),
       modal->GetFunction());
 }
@@ -1086,7 +1230,9 @@ void HallWrapper::get_detection(const FunctionCallbackInfo<Value>& args) {
     isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
         isolate, "Wrong number of arguments")));
 
-  HallSensor* obj = ObjectWrap::Unwrap<HallWrapper>(args.Holder())->getObj();
+  HallWrapper* wrap = ObjectWrap::Unwrap<HallWrapper>(args.Holder());
+  HallSensor* obj = wrap->getObj();
+  std::lock_guard<std::mutex> io(wrap->getLock());
 
   args.GetReturnValue().Set(Number::New(isolate, obj->get_detection()));
 }
@@ -26,6 +26,7 @@
 #include <uv.h>
 #include <artik_sensor.hh>
 
+#include <mutex>
 #include <vector>
 
 namespace artik {
@@ -73,8 +74,13 @@ class SensorDeviceWrapper : public node::ObjectWrap {
 class AccelerometerWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   AccelerometerSensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
+
+  /* X, Y and Z read back to back, under the sensor lock */
+  void sample(double* out);
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       AccelerometerSensor*);
@@ -93,15 +99,23 @@ class AccelerometerWrapper : public node::ObjectWrap {
   static void get_speed_x(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void get_speed_y(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void get_speed_z(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void read_all(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   AccelerometerSensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class GyroWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   GyroSensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
+
+  /* Yaw, pitch and roll read back to back, under the sensor lock */
+  void sample(double* out);
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       GyroSensor*);
@@ -120,16 +134,21 @@ class GyroWrapper : public node::ObjectWrap {
   static void get_yaw(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void get_roll(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void get_pitch(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void read_all(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   GyroSensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 
 class HumidityWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   HumiditySensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       HumiditySensor*);
@@ -148,13 +167,17 @@ class HumidityWrapper : public node::ObjectWrap {
   static void get_humidity(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   HumiditySensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class LightWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   LightSensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       LightSensor*);
@@ -173,13 +196,17 @@ class LightWrapper : public node::ObjectWrap {
   static void get_intensity(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   LightSensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class TemperatureWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   TemperatureSensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       TemperatureSensor*);
@@ -199,13 +226,17 @@ class TemperatureWrapper : public node::ObjectWrap {
   static void get_fahrenheit(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   TemperatureSensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class ProximityWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   ProximitySensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       ProximitySensor*);
@@ -224,13 +255,17 @@ class ProximityWrapper : public node::ObjectWrap {
   static void get_presence(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   ProximitySensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class FlameWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   FlameSensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       FlameSensor*);
@@ -249,13 +284,17 @@ class FlameWrapper : public node::ObjectWrap {
   static void get_signals(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   FlameSensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class PressureWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   PressureSensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       PressureSensor*);
@@ -274,13 +313,17 @@ class PressureWrapper : public node::ObjectWrap {
   static void get_pressure(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   PressureSensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class HallWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object>);
+  static v8::Persistent<v8::FunctionTemplate> tmpl;
 
   HallSensor* getObj() { return m_sensor; }
+  std::mutex& getLock() { return m_lock; }
 
   static void NewInstance(const v8::FunctionCallbackInfo<v8::Value>& args,
       HallSensor*);
@@ -299,6 +342,8 @@ class HallWrapper : public node::ObjectWrap {
   static void get_detection(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   HallSensor *m_sensor;
+  /* Serializes SDK reads between the JS thread and the sensor hub */
+  std::mutex m_lock;
 };
 
 class SensorWrapper : public node::ObjectWrap {
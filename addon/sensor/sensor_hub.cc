@@ -0,0 +1,569 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "sensor/sensor_hub.h"
+
+#include <math.h>
+#include <string.h>
+#include <utils.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "recorder/recorder.h"
+#include "sensor/sensor.h"
+
+#define MAX_SENSOR_FIELDS 3
+
+namespace artik {
+
+using v8::Exception;
+using v8::Function;
+using v8::FunctionCallbackInfo;
+using v8::FunctionTemplate;
+using v8::Isolate;
+using v8::Local;
+using v8::Number;
+using v8::Object;
+using v8::Persistent;
+using v8::String;
+using v8::Value;
+using v8::Context;
+
+typedef std::chrono::steady_clock hub_clock;
+
+Persistent<Function> SensorHubWrapper::constructor;
+
+struct SensorHubEntry {
+  std::string type;
+  std::vector<const char*> fields;
+  std::function<void(double*)> read;
+  /* Slot of the timestamp, the fields follow */
+  size_t offset;
+  hub_clock::duration period;
+  hub_clock::time_point deadline;
+  double threshold;
+};
+
+/*
+ * Every sensor is read by a single thread, each at its own rate. The values
+ * land in one packed array of doubles: for each sensor, the monotonic
+ * timestamp of its last published sample in nanoseconds followed by its
+ * fields. The sensors due at the same time are published together, so that
+ * a snapshot never mixes samples of a sensor taken at different times. With
+ * a recorder, every update appends the whole snapshot as one record. The
+ * SDK reads go through the lock of each sensor, which its JS getters share.
+ */
+struct SensorHubSampler {
+  SensorHubWrapper* wrap;
+  std::vector<SensorHubEntry> entries;
+  Nan::Persistent<v8::Array> sensors;
+  std::vector<double> values;
+  bool notify_always;
+  std::shared_ptr<RingFile> recorder;
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable wakeup;
+  bool quit;
+  uv_async_t* async;
+  Nan::Callback* callback;
+  uint64_t updates;
+  uint64_t samples;
+  uint64_t missed;
+  uint64_t errors;
+
+  void run();
+};
+
+void SensorHubSampler::run() {
+  std::vector<double> sample(MAX_SENSOR_FIELDS);
+  std::vector<std::pair<size_t, std::vector<double>>> due;
+  hub_clock::time_point now = hub_clock::now();
+  uint64_t late;
+  std::unique_lock<std::mutex> l(lock);
+
+  for (auto& entry : entries)
+    entry.deadline = now;
+
+  for (;;) {
+    hub_clock::time_point next = entries[0].deadline;
+
+    for (auto& entry : entries)
+      next = std::min(next, entry.deadline);
+
+    if (wakeup.wait_until(l, next, [this] { return quit; }))
+      return;
+
+    /* Talk to the sensors without holding the lock, under their own */
+    l.unlock();
+    now = hub_clock::now();
+    due.clear();
+    late = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+      SensorHubEntry& entry = entries[i];
+
+      if (entry.deadline > now)
+        continue;
+
+      try {
+        entry.read(sample.data());
+        due.push_back(std::make_pair(i, sample));
+      } catch (artik::ArtikException& e) {
+        due.push_back(std::make_pair(i, std::vector<double>()));
+      }
+
+      /* Skip the periods that could not be honored instead of bursting */
+      entry.deadline += entry.period;
+      while (entry.deadline <= now) {
+        entry.deadline += entry.period;
+        late++;
+      }
+    }
+
+    double timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now.time_since_epoch()).count();
+    bool changed = false;
+
+    l.lock();
+    missed += late;
+    for (auto& item : due) {
+      SensorHubEntry& entry = entries[item.first];
+      double* slot = &values[entry.offset];
+
+      if (item.second.empty()) {
+        errors++;
+        continue;
+      }
+
+      /* One field out of the deadband publishes the whole sample */
+      bool crossed = false;
+
+      for (size_t f = 0; f < entry.fields.size() && !crossed; f++)
+        crossed = isnan(slot[f + 1]) ||
+            fabs(item.second[f] - slot[f + 1]) > entry.threshold;
+
+      samples++;
+      if (!crossed)
+        continue;
+
+      changed = true;
+      slot[0] = timestamp;
+      for (size_t f = 0; f < entry.fields.size(); f++)
+        slot[f + 1] = item.second[f];
+    }
+
+    if (changed || (notify_always && !due.empty())) {
+      updates++;
+      if (recorder) {
+        double now = RingFile::now();
+
+        recorder->append(&now, values.data(), 1);
+      }
+      if (callback)
+        uv_async_send(async);
+    }
+  }
+}
+
+static void sensor_hub_async_cb(uv_async_t* handle) {
+  SensorHubSampler* sampler = reinterpret_cast<SensorHubSampler*>(
+      handle->data);
+  Nan::HandleScope scope;
+  Isolate* isolate = Isolate::GetCurrent();
+  size_t size = sampler->values.size() * sizeof(double);
+  Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate, size);
+  double updates;
+
+  {
+    std::lock_guard<std::mutex> l(sampler->lock);
+    memcpy(buffer->GetContents().Data(), sampler->values.data(), size);
+    updates = sampler->updates;
+  }
+
+  Local<Value> argv[2] = {
+    v8::Float64Array::New(buffer, 0, sampler->values.size()),
+    Nan::New<Number>(updates)
+  };
+
+  sampler->callback->Call(2, argv);
+}
+
+static void sensor_hub_close_cb(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+template<typename W>
+static W* unwrap_sensor(Local<Value> sensor) {
+  Isolate* isolate = Isolate::GetCurrent();
+
+  if (!Local<FunctionTemplate>::New(isolate, W::tmpl)->HasInstance(sensor))
+    return NULL;
+
+  return node::ObjectWrap::Unwrap<W>(sensor.As<Object>());
+}
+
+static bool hub_entry(Local<Value> sensor, SensorHubEntry* entry) {
+  if (AccelerometerWrapper* w =
+      unwrap_sensor<AccelerometerWrapper>(sensor)) {
+    entry->type = "Accelerometer";
+    entry->fields = { "speed_x", "speed_y", "speed_z" };
+    entry->read = [w](double* out) { w->sample(out); };
+  } else if (GyroWrapper* w = unwrap_sensor<GyroWrapper>(sensor)) {
+    entry->type = "Gyro";
+    entry->fields = { "yaw", "pitch", "roll" };
+    entry->read = [w](double* out) { w->sample(out); };
+  } else if (HumidityWrapper* w = unwrap_sensor<HumidityWrapper>(sensor)) {
+    entry->type = "Humidity";
+    entry->fields = { "humidity" };
+    entry->read = [w](double* out) {
+      std::lock_guard<std::mutex> io(w->getLock());
+
+      out[0] = w->getObj()->get_humidity();
+    };
+  } else if (LightWrapper* w = unwrap_sensor<LightWrapper>(sensor)) {
+    entry->type = "Light";
+    entry->fields = { "intensity" };
+    entry->read = [w](double* out) {
+      std::lock_guard<std::mutex> io(w->getLock());
+
+      out[0] = w->getObj()->get_intensity();
+    };
+  } else if (TemperatureWrapper* w =
+      unwrap_sensor<TemperatureWrapper>(sensor)) {
+    entry->type = "Temperature";
+    entry->fields = { "celsius" };
+    entry->read = [w](double* out) {
+      std::lock_guard<std::mutex> io(w->getLock());
+
+      out[0] = w->getObj()->get_celsius();
+    };
+  } else if (ProximityWrapper* w = unwrap_sensor<ProximityWrapper>(sensor)) {
+    entry->type = "Proximity";
+    entry->fields = { "presence" };
+    entry->read = [w](double* out) {
+      std::lock_guard<std::mutex> io(w->getLock());
+
+      out[0] = w->getObj()->get_presence();
+    };
+  } else if (FlameWrapper* w = unwrap_sensor<FlameWrapper>(sensor)) {
+    entry->type = "Flame";
+    entry->fields = { "signals" };
+    entry->read = [w](double* out) {
+      std::lock_guard<std::mutex> io(w->getLock());
+
+      out[0] = w->getObj()->get_signals();
+    };
+  } else if (PressureWrapper* w = unwrap_sensor<PressureWrapper>(sensor)) {
+    entry->type = "Pressure";
+    entry->fields = { "pressure" };
+    entry->read = [w](double* out) {
+      std::lock_guard<std::mutex> io(w->getLock());
+
+      out[0] = w->getObj()->get_pressure();
+    };
+  } else if (HallWrapper* w = unwrap_sensor<HallWrapper>(sensor)) {
+    entry->type = "Hall";
+    entry->fields = { "detection" };
+    entry->read = [w](double* out) {
+      std::lock_guard<std::mutex> io(w->getLock());
+
+      out[0] = w->getObj()->get_detection();
+    };
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+SensorHubWrapper::SensorHubWrapper(SensorHubSampler* sampler) {
+  m_sampler = sampler;
+  m_sampler->wrap = this;
+}
+
+SensorHubWrapper::~SensorHubWrapper() {
+  stop_sampling();
+  m_sampler->sensors.Reset();
+  delete m_sampler;
+}
+
+void SensorHubWrapper::stop_sampling() {
+  SensorHubSampler* sampler = m_sampler;
+
+  if (!sampler->async)
+    return;
+
+  {
+    std::lock_guard<std::mutex> l(sampler->lock);
+    sampler->quit = true;
+    sampler->wakeup.notify_all();
+  }
+  sampler->thread.join();
+
+  uv_close(reinterpret_cast<uv_handle_t*>(sampler->async),
+           sensor_hub_close_cb);
+  sampler->async = NULL;
+  delete sampler->callback;
+  sampler->callback = NULL;
+  Unref();
+}
+
+void SensorHubWrapper::Init(Local<Object> exports) {
+  Isolate* isolate = exports->GetIsolate();
+
+  // Prepare constructor template
+  Local<FunctionTemplate> tpl = FunctionTemplate::New(isolate, New);
+  tpl->SetClassName(String::NewFromUtf8(isolate, "sensor_hub"));
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  // Prototypes
+  NODE_SET_PROTOTYPE_METHOD(tpl, "start", start);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stop", stop);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "read", read);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get_layout", get_layout);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "get_stats", get_stats);
+
+  constructor.Reset(isolate, tpl->GetFunction());
+  exports->Set(String::NewFromUtf8(isolate, "sensor_hub"),
+               tpl->GetFunction());
+}
+
+void SensorHubWrapper::New(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (!args.IsConstructCall()) {
+    const int argc = 2;
+    Local<Value> argv[argc] = { args[0], args[1] };
+    Local<Context> context = isolate->GetCurrentContext();
+    Local<Function> cons = Local<Function>::New(isolate, constructor);
+    args.GetReturnValue().Set(
+        cons->NewInstance(context, argc, argv).ToLocalChecked());
+    return;
+  }
+
+  if (!args[0]->IsArray() ||
+      (!args[1]->IsUndefined() && !args[1]->IsObject())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  Local<v8::Array> array = args[0].As<v8::Array>();
+  Local<v8::Array> sensors = Nan::New<v8::Array>();
+  auto notify = js_object_attribute_to_cpp<std::string>(args[1], "notify");
+  auto recorder = js_object_attribute_to_cpp<Local<Value>>(args[1],
+      "recorder");
+  RecorderWrapper* recorder_wrap = NULL;
+  SensorHubSampler* sampler = new SensorHubSampler();
+  size_t size = 0;
+
+  if (array->Length() == 0 ||
+      (notify && notify.value() != "change" && notify.value() != "always")) {
+    delete sampler;
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Invalid sensor hub settings")));
+    return;
+  }
+
+  for (unsigned int i = 0; i < array->Length(); i++) {
+    Local<Value> item = Nan::Get(array, i).ToLocalChecked();
+    auto sensor = js_object_attribute_to_cpp<Local<Value>>(item, "sensor");
+    auto rate = js_object_attribute_to_cpp<double>(item, "rate");
+    auto threshold = js_object_attribute_to_cpp<double>(item, "threshold");
+    SensorHubEntry entry;
+
+    if (!sensor || !hub_entry(sensor.value(), &entry)) {
+      delete sampler;
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Entries need a sensor device")));
+      return;
+    }
+
+    if (!rate || !(rate.value() > 0) || rate.value() > 1e6 ||
+        (threshold && !(threshold.value() >= 0))) {
+      delete sampler;
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Invalid sensor rate")));
+      return;
+    }
+
+    entry.offset = size;
+    entry.period = std::chrono::duration_cast<hub_clock::duration>(
+        std::chrono::duration<double>(1 / rate.value()));
+    entry.threshold = threshold ? threshold.value() : 0;
+    size += entry.fields.size() + 1;
+    sampler->entries.push_back(entry);
+    Nan::Set(sensors, i, sensor.value());
+  }
+
+  if (recorder) {
+    recorder_wrap = RecorderWrapper::from_js(recorder.value());
+    if (!recorder_wrap) {
+      delete sampler;
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Option recorder should be a recorder")));
+      return;
+    }
+
+    if (recorder_wrap->getFile()->channels() != size) {
+      delete sampler;
+      isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+          isolate, "Recorder channels do not match the snapshot")));
+      return;
+    }
+    sampler->recorder = recorder_wrap->getFile();
+  }
+
+  sampler->sensors.Reset(sensors);
+  sampler->values.assign(size, NAN);
+  sampler->notify_always = notify && notify.value() == "always";
+  sampler->quit = false;
+  sampler->async = NULL;
+  sampler->callback = NULL;
+  sampler->updates = 0;
+  sampler->samples = 0;
+  sampler->missed = 0;
+  sampler->errors = 0;
+
+  SensorHubWrapper* obj = new SensorHubWrapper(sampler);
+  obj->Wrap(args.This());
+  args.GetReturnValue().Set(args.This());
+}
+
+void SensorHubWrapper::start(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SensorHubWrapper* wrap = ObjectWrap::Unwrap<SensorHubWrapper>(args.Holder());
+  SensorHubSampler* sampler = wrap->m_sampler;
+
+  if (args.Length() > 1 || (args.Length() == 1 && !args[0]->IsFunction())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (sampler->async) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Sensor hub already started")));
+    return;
+  }
+
+  sampler->quit = false;
+  sampler->callback = args.Length() ?
+      new Nan::Callback(args[0].As<Function>()) : NULL;
+  sampler->async = new uv_async_t;
+  sampler->async->data = sampler;
+  uv_async_init(uv_default_loop(), sampler->async, sensor_hub_async_cb);
+
+  /* Keep the hub, and through it the sensors, alive while sampling */
+  wrap->Ref();
+  sampler->thread = std::thread(&SensorHubSampler::run, sampler);
+}
+
+void SensorHubWrapper::stop(const FunctionCallbackInfo<Value>& args) {
+  ObjectWrap::Unwrap<SensorHubWrapper>(args.Holder())->stop_sampling();
+}
+
+void SensorHubWrapper::read(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SensorHubSampler* sampler =
+      ObjectWrap::Unwrap<SensorHubWrapper>(args.Holder())->m_sampler;
+  size_t count = sampler->values.size();
+
+  if (args.Length() == 0) {
+    Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(isolate,
+        count * sizeof(double));
+    std::lock_guard<std::mutex> l(sampler->lock);
+
+    memcpy(buffer->GetContents().Data(), sampler->values.data(),
+           count * sizeof(double));
+    args.GetReturnValue().Set(v8::Float64Array::New(buffer, 0, count));
+    return;
+  }
+
+  if (!args[0]->IsFloat64Array()) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  Nan::TypedArrayContents<double> out(args[0]);
+
+  if (out.length() < count) {
+    isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(
+        isolate, "Array too small for the snapshot")));
+    return;
+  }
+
+  std::lock_guard<std::mutex> l(sampler->lock);
+
+  memcpy(*out, sampler->values.data(), count * sizeof(double));
+  args.GetReturnValue().Set(Number::New(isolate, sampler->updates));
+}
+
+void SensorHubWrapper::get_layout(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SensorHubSampler* sampler =
+      ObjectWrap::Unwrap<SensorHubWrapper>(args.Holder())->m_sampler;
+  Local<v8::Array> layout = v8::Array::New(isolate, sampler->entries.size());
+
+  for (size_t i = 0; i < sampler->entries.size(); i++) {
+    SensorHubEntry& entry = sampler->entries[i];
+    Local<Object> item = Object::New(isolate);
+    Local<v8::Array> fields = v8::Array::New(isolate, entry.fields.size() + 1);
+
+    fields->Set(0, String::NewFromUtf8(isolate, "timestamp"));
+    for (size_t f = 0; f < entry.fields.size(); f++)
+      fields->Set(f + 1, String::NewFromUtf8(isolate, entry.fields[f]));
+
+    item->Set(String::NewFromUtf8(isolate, "type"),
+              String::NewFromUtf8(isolate, entry.type.c_str()));
+    item->Set(String::NewFromUtf8(isolate, "offset"),
+              Number::New(isolate, entry.offset));
+    item->Set(String::NewFromUtf8(isolate, "fields"), fields);
+    layout->Set(i, item);
+  }
+
+  args.GetReturnValue().Set(layout);
+}
+
+void SensorHubWrapper::get_stats(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SensorHubSampler* sampler =
+      ObjectWrap::Unwrap<SensorHubWrapper>(args.Holder())->m_sampler;
+  Local<Object> stats = Object::New(isolate);
+  std::lock_guard<std::mutex> l(sampler->lock);
+
+  stats->Set(String::NewFromUtf8(isolate, "updates"),
+             Number::New(isolate, sampler->updates));
+  stats->Set(String::NewFromUtf8(isolate, "samples"),
+             Number::New(isolate, sampler->samples));
+  stats->Set(String::NewFromUtf8(isolate, "missed"),
+             Number::New(isolate, sampler->missed));
+  stats->Set(String::NewFromUtf8(isolate, "errors"),
+             Number::New(isolate, sampler->errors));
+
+  args.GetReturnValue().Set(stats);
+}
+
+}  // namespace artik
@@ -0,0 +1,56 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_SENSOR_SENSOR_HUB_H_
+#define ADDON_SENSOR_SENSOR_HUB_H_
+
+#include <node.h>
+#include <nan.h>
+#include <node_object_wrap.h>
+
+#include <uv.h>
+
+namespace artik {
+
+struct SensorHubSampler;
+
+class SensorHubWrapper : public node::ObjectWrap {
+ public:
+  static void Init(v8::Local<v8::Object> exports);
+
+  void stop_sampling();
+
+ private:
+  explicit SensorHubWrapper(SensorHubSampler* sampler);
+  ~SensorHubWrapper();
+
+  static void New(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static v8::Persistent<v8::Function> constructor;
+
+  static void start(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stop(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void read(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_layout(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_stats(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  SensorHubSampler* m_sampler;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_SENSOR_SENSOR_HUB_H_
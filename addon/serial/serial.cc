@@ -19,12 +19,17 @@
 #include "serial/serial.h"
 
 #include <unistd.h>
+#include <string.h>
 #include <node_buffer.h>
 #include <nan.h>
 #include <utils.h>
 
+#include <algorithm>
 #include <string>
 
+#define TX_CHUNK_SIZE  4096
+#define TX_RETRY_US    1000
+
 namespace artik {
 
 using v8::Exception;
@@ -65,37 +70,317 @@ const std::array<const char*, 3> SerialWrapper::s_flowcontrols = {
 
 static void serial_change_callback(void *user_data, unsigned char *buf,
     int len) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   SerialWrapper *wrap = reinterpret_cast<SerialWrapper*>(user_data);
 
-  if (!wrap->getChangeCb() || !buf)
+  if (!buf)
     return;
 
-  v8::MaybeLocal<v8::Object> array = node::Buffer::Copy(isolate,
-      reinterpret_cast<char*>(buf), len);
-
-  Handle<Value> argv[] = {
-    array.ToLocalChecked()
-  };
+  wrap->receive(buf, len);
+}
 
-  Local<Function>::New(isolate, *wrap->getChangeCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+static void free_rx_slab(char *data, void *hint) {
+  free(data);
 }
 
 SerialWrapper::SerialWrapper(unsigned int port, char *name,
     artik_serial_baudrate_t baudrate, artik_serial_parity_t parity,
     artik_serial_data_bits_t data, artik_serial_stop_bits_t stop,
     artik_serial_flowcontrol_t flowctrl) {
-  m_serial = new Serial(port, name, baudrate, parity, data, stop, flowctrl);
+  {
+    GlibLoop::SdkLock lock;
+    m_serial = new Serial(port, name, baudrate, parity, data, stop, flowctrl);
+  }
+  m_change_cb = NULL;
   m_rx_buf_size = 128;
+  m_rx_scheduled = false;
+  m_rx_current = -1;
+  m_rx_current_len = 0;
+  m_rx_bytes = 0;
+  m_rx_pool_misses = 0;
+  m_rx_paused = false;
+  m_tx_quit = false;
+  m_tx_scheduled = false;
   m_loop = GlibLoop::Instance();
-  m_loop->attach();
+  m_loop->attach(true);
 }
 
 SerialWrapper::~SerialWrapper() {
-  delete m_serial;
-  m_loop->detach();
+  /* Pending writes keep the wrapper alive, the queue is empty here */
+  if (m_tx_thread.joinable()) {
+    m_tx_quit = true;
+    m_tx_cond.notify_one();
+    m_tx_thread.join();
+  }
+  {
+    GlibLoop::SdkLock lock;
+    delete m_serial;
+  }
+  m_loop->cancel(this);
+  m_loop->detach(true);
+  m_rx_pool.Reset();
+}
+
+void SerialWrapper::receive(const unsigned char *buf, int len) {
+  bool schedule;
+
+  {
+    std::lock_guard<std::mutex> lock(m_rx_lock);
+
+    m_rx_bytes += len;
+
+    /*
+     * Once the pool ran dry, keep appending to m_rx_pending until the
+     * next flush so that data is delivered in order.
+     */
+    while (len > 0 && !m_rx_slabs.empty() && m_rx_pending.empty()) {
+      if (m_rx_current < 0) {
+        if (m_rx_free.empty()) {
+          m_rx_pool_misses++;
+          break;
+        }
+
+        m_rx_current = m_rx_free.back();
+        m_rx_current_len = 0;
+        m_rx_free.pop_back();
+      }
+
+      size_t n = std::min(static_cast<size_t>(len),
+          m_rx_buf_size - m_rx_current_len);
+
+      memcpy(m_rx_slabs[m_rx_current] + m_rx_current_len, buf, n);
+      m_rx_current_len += n;
+      buf += n;
+      len -= n;
+
+      if (m_rx_current_len == static_cast<size_t>(m_rx_buf_size)) {
+        m_rx_filled.push_back(std::make_pair(m_rx_current, m_rx_current_len));
+        m_rx_current = -1;
+      }
+    }
+
+    if (len > 0)
+      m_rx_pending.append(reinterpret_cast<const char*>(buf), len);
+
+    schedule = !m_rx_scheduled;
+    m_rx_scheduled = true;
+  }
+
+  /* Everything received during this loop iteration goes in one flush */
+  if (schedule)
+    m_loop->defer(this, [this]() { flush_rx(); });
+}
+
+void SerialWrapper::flush_rx() {
+  std::deque<std::pair<int, size_t>> filled;
+  std::string pending;
+
+  {
+    std::lock_guard<std::mutex> lock(m_rx_lock);
+
+    /* Staged data is flushed again by resume_receive() */
+    if (m_rx_paused) {
+      m_rx_scheduled = false;
+      return;
+    }
+
+    if (m_rx_current >= 0 && m_rx_current_len > 0) {
+      m_rx_filled.push_back(std::make_pair(m_rx_current, m_rx_current_len));
+      m_rx_current = -1;
+    }
+
+    filled.swap(m_rx_filled);
+    pending.swap(m_rx_pending);
+    m_rx_scheduled = false;
+  }
+
+  if (m_framer.enabled()) {
+    flush_frames(filled, pending);
+    return;
+  }
+
+  Isolate * isolate = Isolate::GetCurrent();
+  v8::HandleScope handleScope(isolate);
+  Local<v8::Array> pool = Nan::New(m_rx_pool);
+
+  for (auto& slab : filled) {
+    if (!m_change_cb) {
+      std::lock_guard<std::mutex> lock(m_rx_lock);
+      m_rx_free.push_back(slab.first);
+      continue;
+    }
+
+    m_rx_lent[slab.first] = true;
+    emit_rx(Nan::Get(pool, slab.first).ToLocalChecked(), slab.second);
+  }
+
+  for (size_t off = 0; off < pending.size() && m_change_cb;
+       off += m_rx_buf_size) {
+    size_t n = std::min(pending.size() - off,
+        static_cast<size_t>(m_rx_buf_size));
+
+    emit_rx(node::Buffer::Copy(isolate, pending.data() + off, n)
+        .ToLocalChecked(), n);
+  }
+}
+
+void SerialWrapper::flush_frames(
+    const std::deque<std::pair<int, size_t>>& filled,
+    const std::string& pending) {
+  std::vector<std::string> frames;
+
+  /* Slabs are consumed right away by the framer */
+  for (auto& slab : filled) {
+    m_framer.push(m_rx_slabs[slab.first], slab.second, &frames);
+
+    std::lock_guard<std::mutex> lock(m_rx_lock);
+    m_rx_free.push_back(slab.first);
+  }
+
+  if (!pending.empty())
+    m_framer.push(pending.data(), pending.size(), &frames);
+
+  if (frames.empty() || !m_change_cb)
+    return;
+
+  Isolate * isolate = Isolate::GetCurrent();
+  v8::HandleScope handleScope(isolate);
+  Local<v8::Array> array = Nan::New<v8::Array>(frames.size());
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    Nan::Set(array, i, node::Buffer::Copy(isolate, frames[i].data(),
+        frames[i].size()).ToLocalChecked());
+  }
+
+  /* All the frames completed during this loop iteration at once */
+  emit_rx(array, frames.size());
+}
+
+void SerialWrapper::emit_rx(Local<Value> data, size_t length) {
+  Isolate * isolate = Isolate::GetCurrent();
+  Handle<Value> argv[] = {
+    data,
+    Number::New(isolate, length)
+  };
+
+  Local<Function>::New(isolate, *m_change_cb)->Call(
+      isolate->GetCurrentContext()->Global(), 2, argv);
+}
+
+void SerialWrapper::writer_thread() {
+  std::unique_lock<std::mutex> lock(m_tx_lock);
+
+  while (!m_tx_quit) {
+    if (m_tx_queue.empty()) {
+      m_tx_cond.wait(lock);
+      continue;
+    }
+
+    TxRequest *req = m_tx_queue.front();
+    artik_error ret = S_OK;
+    size_t done = 0;
+
+    lock.unlock();
+
+    /* Write by chunks so that a release does not wait for a whole image */
+    while (done < req->length && !m_tx_quit) {
+      int len = std::min(req->length - done,
+          static_cast<size_t>(TX_CHUNK_SIZE));
+
+      {
+        GlibLoop::SdkLock io;
+        ret = m_serial->write(req->data + done, &len);
+      }
+
+      if (ret == E_TRY_AGAIN || (ret == S_OK && len == 0)) {
+        ret = S_OK;
+        usleep(TX_RETRY_US);
+        continue;
+      }
+
+      if (ret != S_OK)
+        break;
+
+      done += len;
+    }
+
+    if (ret == S_OK && done < req->length)
+      ret = E_INTERRUPTED;
+
+    req->error = ret;
+
+    lock.lock();
+    m_tx_queue.pop_front();
+    m_tx_done.push_back(req);
+    if (!m_tx_scheduled) {
+      m_tx_scheduled = true;
+      m_loop->invoke(this, [this]() { complete_tx(); });
+    }
+  }
+}
+
+void SerialWrapper::stop_writer() {
+  if (!m_tx_thread.joinable())
+    return;
+
+  m_tx_quit = true;
+  m_tx_cond.notify_one();
+  m_tx_thread.join();
+  m_tx_quit = false;
+
+  /* Fail what could not be written, callbacks run from the loop */
+  std::lock_guard<std::mutex> lock(m_tx_lock);
+
+  for (auto req : m_tx_queue) {
+    req->error = E_INTERRUPTED;
+    m_tx_done.push_back(req);
+  }
+  m_tx_queue.clear();
+
+  if (!m_tx_done.empty() && !m_tx_scheduled) {
+    m_tx_scheduled = true;
+    m_loop->defer(this, [this]() { complete_tx(); });
+  }
+}
+
+void SerialWrapper::complete_tx() {
+  std::vector<TxRequest*> done;
+
+  {
+    std::lock_guard<std::mutex> lock(m_tx_lock);
+    done.swap(m_tx_done);
+    m_tx_scheduled = false;
+  }
+
+  Nan::HandleScope scope;
+
+  for (auto req : done) {
+    if (req->callback) {
+      Local<Value> argv[] = {
+        req->error == S_OK ? Local<Value>(Nan::Null()) :
+            Nan::Error(error_msg(req->error))
+      };
+
+      req->callback->Call(1, argv);
+      delete req->callback;
+    }
+
+    req->buffer.Reset();
+    delete req;
+    Unref();
+  }
+}
+
+void SerialWrapper::reset_rx_pool() {
+  std::lock_guard<std::mutex> lock(m_rx_lock);
+
+  /* Slabs still referenced from JS are freed along with their Buffer */
+  m_rx_pool.Reset();
+  m_rx_slabs.clear();
+  m_rx_free.clear();
+  m_rx_lent.clear();
+  m_rx_filled.clear();
+  m_rx_current = -1;
+  m_rx_current_len = 0;
 }
 
 void SerialWrapper::Init(Local<Object> exports) {
@@ -118,6 +403,7 @@ void SerialWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "request", request);
   NODE_SET_PROTOTYPE_METHOD(modal, "release", release);
   NODE_SET_PROTOTYPE_METHOD(modal, "write", write);
+  NODE_SET_PROTOTYPE_METHOD(modal, "write_async", write_async);
   NODE_SET_PROTOTYPE_METHOD(modal, "get_port_num", get_port_num);
   NODE_SET_PROTOTYPE_METHOD(modal, "get_name", get_name);
   NODE_SET_PROTOTYPE_METHOD(modal, "get_baudrate", get_baudrate);
@@ -133,6 +419,12 @@ void SerialWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(modal, "set_data_bits", set_data_bits);
   NODE_SET_PROTOTYPE_METHOD(modal, "set_stop_bits", set_stop_bits);
   NODE_SET_PROTOTYPE_METHOD(modal, "set_flowctrl", set_flowctrl);
+  NODE_SET_PROTOTYPE_METHOD(modal, "set_rx_buffer", set_rx_buffer);
+  NODE_SET_PROTOTYPE_METHOD(modal, "recycle", recycle);
+  NODE_SET_PROTOTYPE_METHOD(modal, "pause_receive", pause_receive);
+  NODE_SET_PROTOTYPE_METHOD(modal, "resume_receive", resume_receive);
+  NODE_SET_PROTOTYPE_METHOD(modal, "get_rx_stats", get_rx_stats);
+  NODE_SET_PROTOTYPE_METHOD(modal, "set_framing", set_framing);
 
   constructor.Reset(isolate, modal->GetFunction());
   exports->Set(v8::String::NewFromUtf8(isolate, "serial"),
@@ -246,10 +538,17 @@ void SerialWrapper::request(const FunctionCallbackInfo<Value>& args) {
 
   SerialWrapper *wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
   Serial* obj = wrap->getObj();
-  artik_error ret = obj->request();
+  artik_error ret;
+
+  {
+    GlibLoop::SdkLock lock;
+    ret = obj->request();
+  }
   if ((ret == S_OK) && args[0]->IsFunction()) {
     wrap->m_change_cb = new v8::Persistent<v8::Function>();
     wrap->m_change_cb->Reset(isolate, Local<Function>::Cast(args[0]));
+
+    GlibLoop::SdkLock lock;
     obj->set_received_callback(serial_change_callback,
         reinterpret_cast<void*>(wrap));
   }
@@ -267,12 +566,22 @@ void SerialWrapper::release(const FunctionCallbackInfo<Value>& args) {
 
   SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
   Serial* obj = wrap->getObj();
+  artik_error ret;
+  wrap->stop_writer();
+
+  {
+    GlibLoop::SdkLock lock;
+
+    if (wrap->m_change_cb && !wrap->m_rx_paused)
+      obj->unset_received_callback();
+    ret = obj->release();
+  }
   if (wrap->m_change_cb) {
-    obj->unset_received_callback();
     delete wrap->m_change_cb;
     wrap->m_change_cb = NULL;
   }
-  args.GetReturnValue().Set(Number::New(isolate, obj->release()));
+  wrap->m_rx_paused = false;
+  args.GetReturnValue().Set(Number::New(isolate, ret));
 }
 
 void SerialWrapper::write(const FunctionCallbackInfo<Value>& args) {
@@ -294,11 +603,56 @@ void SerialWrapper::write(const FunctionCallbackInfo<Value>& args) {
   unsigned char *buffer = (unsigned char*)node::Buffer::Data(args[0]);
   int length = static_cast<int>(node::Buffer::Length(args[0]));
 
-  int ret = obj->write(buffer, &length);
+  int ret;
+
+  {
+    GlibLoop::SdkLock io;
+    ret = obj->write(buffer, &length);
+  }
 
   args.GetReturnValue().Set(Number::New(isolate, (ret == S_OK) ? length : 0));
 }
 
+void SerialWrapper::write_async(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() < 1 || args.Length() > 2 ||
+      (args.Length() == 2 && !args[1]->IsFunction())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (!node::Buffer::HasInstance(args[0])) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Argument should be a Buffer.")));
+    return;
+  }
+
+  SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
+  TxRequest *req = new TxRequest();
+
+  /* The Buffer is written in place, keep it alive until then */
+  req->buffer.Reset(args[0]->ToObject());
+  req->data = reinterpret_cast<unsigned char*>(node::Buffer::Data(args[0]));
+  req->length = node::Buffer::Length(args[0]);
+  req->callback = args.Length() == 2 ?
+      new Nan::Callback(args[1].As<Function>()) : NULL;
+  req->error = S_OK;
+
+  wrap->Ref();
+
+  {
+    std::lock_guard<std::mutex> lock(wrap->m_tx_lock);
+    wrap->m_tx_queue.push_back(req);
+  }
+
+  if (!wrap->m_tx_thread.joinable())
+    wrap->m_tx_thread = std::thread(&SerialWrapper::writer_thread, wrap);
+  else
+    wrap->m_tx_cond.notify_one();
+}
+
 void SerialWrapper::get_port_num(const FunctionCallbackInfo<Value>& args) {
   Isolate* isolate = args.GetIsolate();
   if (args.Length() != 0)
@@ -555,5 +909,259 @@ void SerialWrapper::set_flowctrl(const FunctionCallbackInfo<Value>& args) {
   obj->set_flowctrl(flowcontrol.value());
 }
 
-}  // namespace artik
+void SerialWrapper::set_rx_buffer(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() < 1 || args.Length() > 2) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong number of arguments")));
+    return;
+  }
+
+  if (!args[0]->IsUint32() || args[0]->Uint32Value() == 0 ||
+      (args.Length() == 2 && !args[1]->IsUint32())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
+
+  if (wrap->m_change_cb) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Serial port is already receiving")));
+    return;
+  }
+
+  unsigned int size = args[0]->Uint32Value();
+  unsigned int count = (args.Length() == 2) ? args[1]->Uint32Value() : 0;
+  Local<v8::Array> pool = Nan::New<v8::Array>(count);
+
+  wrap->reset_rx_pool();
+
+  std::lock_guard<std::mutex> lock(wrap->m_rx_lock);
+
+  wrap->m_rx_buf_size = size;
+  for (unsigned int i = 0; i < count; i++) {
+    char *slab = reinterpret_cast<char*>(malloc(size));
+
+    if (!slab) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Memory allocation error")));
+      wrap->m_rx_slabs.clear();
+      wrap->m_rx_free.clear();
+      return;
+    }
+
+    Nan::Set(pool, i, Nan::NewBuffer(slab, size, free_rx_slab, NULL)
+        .ToLocalChecked());
+    wrap->m_rx_slabs.push_back(slab);
+    wrap->m_rx_free.push_back(count - 1 - i);
+  }
+
+  wrap->m_rx_lent.assign(count, false);
+  wrap->m_rx_pool.Reset(pool);
+}
+
+void SerialWrapper::recycle(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() != 1 || !node::Buffer::HasInstance(args[0])) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Argument should be a Buffer.")));
+    return;
+  }
+
+  SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
+  char *data = node::Buffer::Data(args[0]);
+  auto it = std::find(wrap->m_rx_slabs.begin(), wrap->m_rx_slabs.end(), data);
+
+  /* Not from the current pool, or already given back */
+  if (it == wrap->m_rx_slabs.end())
+    return;
+
+  int slab = it - wrap->m_rx_slabs.begin();
+
+  if (!wrap->m_rx_lent[slab])
+    return;
+
+  wrap->m_rx_lent[slab] = false;
+
+  std::lock_guard<std::mutex> lock(wrap->m_rx_lock);
+  wrap->m_rx_free.push_back(slab);
+}
+
+void SerialWrapper::get_rx_stats(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
+  Local<Object> stats = Object::New(isolate);
+  std::lock_guard<std::mutex> lock(wrap->m_rx_lock);
+
+  stats->Set(String::NewFromUtf8(isolate, "bytes"),
+      Number::New(isolate, wrap->m_rx_bytes));
+  stats->Set(String::NewFromUtf8(isolate, "buffer_size"),
+      Number::New(isolate, wrap->m_rx_buf_size));
+  stats->Set(String::NewFromUtf8(isolate, "pool_size"),
+      Number::New(isolate, wrap->m_rx_slabs.size()));
+  stats->Set(String::NewFromUtf8(isolate, "pool_free"),
+      Number::New(isolate, wrap->m_rx_free.size()));
+  stats->Set(String::NewFromUtf8(isolate, "pool_misses"),
+      Number::New(isolate, wrap->m_rx_pool_misses));
+  stats->Set(String::NewFromUtf8(isolate, "frames"),
+      Number::New(isolate, wrap->m_framer.frames()));
+  stats->Set(String::NewFromUtf8(isolate, "framing_errors"),
+      Number::New(isolate, wrap->m_framer.errors()));
+
+  args.GetReturnValue().Set(stats);
+}
+
+void SerialWrapper::set_framing(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+
+  if (args.Length() < 1 || args.Length() > 2) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong number of arguments")));
+    return;
+  }
 
+  if (!args[0]->IsString() || (args.Length() == 2 && !args[1]->IsObject())) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
+  SerialFramer& framer = wrap->m_framer;
+  Local<Value> options = args.Length() == 2 ? args[1] :
+      Local<Value>::Cast(Object::New(isolate));
+  v8::String::Utf8Value param0(args[0]->ToString());
+  std::string mode(*param0);
+
+  if (mode == "none") {
+    framer.set_none();
+  } else if (mode == "delimiter") {
+    auto delimiter = js_object_attribute_to_cpp<Local<Value>>(options,
+        "delimiter");
+    auto include = js_object_attribute_to_cpp<bool>(options, "include");
+    std::string value;
+
+    if (delimiter && node::Buffer::HasInstance(delimiter.value())) {
+      value.assign(node::Buffer::Data(delimiter.value()),
+          node::Buffer::Length(delimiter.value()));
+    } else if (delimiter && delimiter.value()->IsString()) {
+      v8::String::Utf8Value str(delimiter.value());
+      value = *str;
+    }
+
+    if (value.empty()) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Delimiter should be a non empty String or Buffer")));
+      return;
+    }
+
+    framer.set_delimiter(value, include ? include.value() : false);
+  } else if (mode == "fixed") {
+    auto length = js_object_attribute_to_cpp<uint32_t>(options, "length");
+
+    if (!length || length.value() == 0) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Length should be a positive Number")));
+      return;
+    }
+
+    framer.set_fixed(length.value());
+  } else if (mode == "length") {
+    auto field_size = js_object_attribute_to_cpp<uint32_t>(options,
+        "field_size");
+    auto field_offset = js_object_attribute_to_cpp<uint32_t>(options,
+        "field_offset");
+    auto header_size = js_object_attribute_to_cpp<uint32_t>(options,
+        "header_size");
+    auto big_endian = js_object_attribute_to_cpp<bool>(options, "big_endian");
+    auto adjust = js_object_attribute_to_cpp<int32_t>(options, "adjust");
+    auto include = js_object_attribute_to_cpp<bool>(options, "include");
+    size_t size = field_size ? field_size.value() : 1;
+    size_t offset = field_offset ? field_offset.value() : 0;
+    size_t header = header_size ? header_size.value() : offset + size;
+
+    if ((size != 1 && size != 2 && size != 4) || offset + size > header) {
+      isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+          isolate, "Wrong length field configuration")));
+      return;
+    }
+
+    framer.set_length_prefix(header, offset, size,
+        big_endian ? big_endian.value() : false,
+        adjust ? adjust.value() : 0,
+        include ? include.value() : false);
+  } else if (mode == "slip") {
+    framer.set_slip();
+  } else if (mode == "cobs") {
+    framer.set_cobs();
+  } else {
+    std::string error = "Framing " + mode + " is not supported";
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, error.c_str())));
+    return;
+  }
+
+  auto max_frame = js_object_attribute_to_cpp<uint32_t>(options, "max_frame");
+  if (max_frame)
+    framer.set_max_frame(max_frame.value());
+}
+
+void SerialWrapper::pause_receive(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
+
+  if (!wrap->m_change_cb) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Serial port is not receiving")));
+    return;
+  }
+
+  if (wrap->m_rx_paused)
+    return;
+
+  wrap->m_rx_paused = true;
+
+  GlibLoop::SdkLock lock;
+  wrap->getObj()->unset_received_callback();
+}
+
+void SerialWrapper::resume_receive(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SerialWrapper* wrap = ObjectWrap::Unwrap<SerialWrapper>(args.Holder());
+  bool schedule;
+
+  if (!wrap->m_change_cb) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Serial port is not receiving")));
+    return;
+  }
+
+  if (!wrap->m_rx_paused)
+    return;
+
+  wrap->m_rx_paused = false;
+
+  {
+    GlibLoop::SdkLock lock;
+    wrap->getObj()->set_received_callback(serial_change_callback,
+        reinterpret_cast<void*>(wrap));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(wrap->m_rx_lock);
+
+    schedule = !wrap->m_rx_scheduled && (wrap->m_rx_current >= 0 ||
+        !wrap->m_rx_filled.empty() || !wrap->m_rx_pending.empty());
+    if (schedule)
+      wrap->m_rx_scheduled = true;
+  }
+
+  if (schedule)
+    wrap->m_loop->defer(wrap, [wrap]() { wrap->flush_rx(); });
+}
+
+}  // namespace artik
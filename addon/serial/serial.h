@@ -27,7 +27,17 @@
 #include <artik_serial.hh>
 #include <loop.h>
 
+#include "serial/serial_framer.h"
+
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace artik {
 
@@ -39,6 +49,8 @@ class SerialWrapper : public node::ObjectWrap {
   int GetRxBufSize() { return m_rx_buf_size; }
   v8::Persistent<v8::Function>* getChangeCb() { return m_change_cb; }
 
+  void receive(const unsigned char *buf, int len);
+
  private:
   SerialWrapper(unsigned int, char*, artik_serial_baudrate_t,
       artik_serial_parity_t, artik_serial_data_bits_t,
@@ -52,6 +64,7 @@ class SerialWrapper : public node::ObjectWrap {
   static void request(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void release(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void write(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void write_async(const v8::FunctionCallbackInfo<v8::Value>& args);
 
   static void get_port_num(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void get_name(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -68,6 +81,30 @@ class SerialWrapper : public node::ObjectWrap {
   static void set_data_bits(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void set_stop_bits(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void set_flowctrl(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void set_rx_buffer(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void recycle(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void get_rx_stats(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void set_framing(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void pause_receive(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void resume_receive(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void flush_rx();
+  void flush_frames(const std::deque<std::pair<int, size_t>>& filled,
+      const std::string& pending);
+  void emit_rx(v8::Local<v8::Value> data, size_t length);
+  void reset_rx_pool();
+
+  struct TxRequest {
+    Nan::Persistent<v8::Object> buffer;
+    Nan::Callback *callback;
+    unsigned char *data;
+    size_t length;
+    artik_error error;
+  };
+
+  void writer_thread();
+  void stop_writer();
+  void complete_tx();
 
   static const std::array<int, 7> s_baudrates;
   static const std::array<const char *, 3> s_parities;
@@ -79,6 +116,46 @@ class SerialWrapper : public node::ObjectWrap {
   v8::Persistent<v8::Function>* m_change_cb;
   int m_rx_buf_size;
   GlibLoop* m_loop;
+
+  /*
+   * Received data is gathered under m_rx_lock, possibly from the GLib
+   * thread, and flushed to JS once per loop iteration. In pooled mode it
+   * lands in recycled slabs backing persistent Buffers, otherwise in
+   * m_rx_pending and is copied out in chunks of m_rx_buf_size bytes.
+   */
+  std::mutex m_rx_lock;
+  bool m_rx_scheduled;
+  std::string m_rx_pending;
+  std::vector<char*> m_rx_slabs;
+  std::vector<int> m_rx_free;
+  std::vector<bool> m_rx_lent;
+  std::deque<std::pair<int, size_t>> m_rx_filled;
+  int m_rx_current;
+  size_t m_rx_current_len;
+  Nan::Persistent<v8::Array> m_rx_pool;
+  double m_rx_bytes;
+  double m_rx_pool_misses;
+
+  /*
+   * While paused the SDK watch on the port is removed, so data is left in
+   * the tty buffer and whatever was already gathered stays staged above.
+   */
+  bool m_rx_paused;
+
+  /* Only used from the JS thread */
+  SerialFramer m_framer;
+
+  /*
+   * Buffers queued by write_async() are written by m_tx_thread, then
+   * handed back to the JS thread along with their completion status.
+   */
+  std::mutex m_tx_lock;
+  std::condition_variable m_tx_cond;
+  std::thread m_tx_thread;
+  std::atomic<bool> m_tx_quit;
+  std::deque<TxRequest*> m_tx_queue;
+  std::vector<TxRequest*> m_tx_done;
+  bool m_tx_scheduled;
 };
 
 }  // namespace artik
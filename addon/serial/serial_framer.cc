@@ -0,0 +1,321 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#include "serial/serial_framer.h"
+
+#include <algorithm>
+
+#define SLIP_END      0xC0
+#define SLIP_ESC      0xDB
+#define SLIP_ESC_END  0xDC
+#define SLIP_ESC_ESC  0xDD
+
+#define DEFAULT_MAX_FRAME  65536
+#define COMPACT_THRESHOLD  4096
+
+namespace artik {
+
+SerialFramer::SerialFramer()
+  : m_mode(NONE),
+    m_max_frame(DEFAULT_MAX_FRAME),
+    m_pos(0),
+    m_scan(0),
+    m_escape(false),
+    m_discard(false),
+    m_include(false),
+    m_fixed(0),
+    m_header_size(0),
+    m_field_offset(0),
+    m_field_size(0),
+    m_big_endian(false),
+    m_adjust(0),
+    m_frames(0),
+    m_errors(0) {
+}
+
+void SerialFramer::reset() {
+  m_buf.clear();
+  m_pos = 0;
+  m_scan = 0;
+  m_escape = false;
+  m_discard = false;
+}
+
+void SerialFramer::set_none() {
+  reset();
+  m_mode = NONE;
+}
+
+void SerialFramer::set_delimiter(const std::string& delimiter, bool include) {
+  reset();
+  m_mode = DELIMITER;
+  m_delimiter = delimiter;
+  m_include = include;
+}
+
+void SerialFramer::set_fixed(size_t length) {
+  reset();
+  m_mode = FIXED;
+  m_fixed = length;
+}
+
+void SerialFramer::set_length_prefix(size_t header_size, size_t field_offset,
+    size_t field_size, bool big_endian, int adjust, bool include_header) {
+  reset();
+  m_mode = LENGTH_PREFIX;
+  m_header_size = header_size;
+  m_field_offset = field_offset;
+  m_field_size = field_size;
+  m_big_endian = big_endian;
+  m_adjust = adjust;
+  m_include = include_header;
+}
+
+void SerialFramer::set_slip() {
+  reset();
+  m_mode = SLIP;
+}
+
+void SerialFramer::set_cobs() {
+  reset();
+  m_mode = COBS;
+}
+
+void SerialFramer::emit(const char *data, size_t len,
+    std::vector<std::string> *frames) {
+  frames->emplace_back(data, len);
+  m_frames++;
+}
+
+void SerialFramer::error() {
+  m_errors++;
+}
+
+void SerialFramer::push(const char *data, size_t len,
+    std::vector<std::string> *frames) {
+  switch (m_mode) {
+  case NONE:
+    emit(data, len, frames);
+    break;
+  case SLIP:
+    push_slip(data, len, frames);
+    break;
+  case COBS:
+    push_cobs(data, len, frames);
+    break;
+  default:
+    push_buffered(data, len, frames);
+    break;
+  }
+}
+
+void SerialFramer::push_buffered(const char *data, size_t len,
+    std::vector<std::string> *frames) {
+  m_buf.append(data, len);
+
+  for (;;) {
+    const char *p = m_buf.data() + m_pos;
+    size_t avail = m_buf.size() - m_pos;
+
+    if (m_mode == DELIMITER) {
+      size_t dlen = m_delimiter.size();
+      size_t found = m_buf.find(m_delimiter, std::max(m_scan, m_pos));
+
+      if (found == std::string::npos) {
+        /* Next search starts where a delimiter may still begin */
+        m_scan = std::max(m_pos,
+            m_buf.size() >= dlen ? m_buf.size() - dlen + 1 : 0);
+
+        /* Too long, drop everything up to the next delimiter */
+        if (avail > m_max_frame) {
+          if (!m_discard)
+            error();
+          m_discard = true;
+          m_pos = m_scan;
+        }
+        break;
+      }
+
+      if (!m_discard) {
+        if (found - m_pos > m_max_frame)
+          error();
+        else
+          emit(p, found - m_pos + (m_include ? dlen : 0), frames);
+      }
+
+      m_discard = false;
+      m_pos = found + dlen;
+      m_scan = m_pos;
+    } else if (m_mode == FIXED) {
+      if (avail < m_fixed)
+        break;
+
+      emit(p, m_fixed, frames);
+      m_pos += m_fixed;
+    } else {
+      if (avail < m_header_size)
+        break;
+
+      const unsigned char *field =
+          reinterpret_cast<const unsigned char*>(p) + m_field_offset;
+      int64_t value = 0;
+
+      for (size_t i = 0; i < m_field_size; i++) {
+        size_t shift = m_big_endian ? (m_field_size - 1 - i) : i;
+        value |= static_cast<int64_t>(field[i]) << (8 * shift);
+      }
+
+      int64_t body = value + m_adjust;
+
+      /* No way to resynchronize a length prefixed stream, start over */
+      if (body < 0 || static_cast<uint64_t>(body) > m_max_frame) {
+        error();
+        m_pos = m_buf.size();
+        break;
+      }
+
+      size_t total = m_header_size + body;
+
+      if (avail < total)
+        break;
+
+      if (m_include)
+        emit(p, total, frames);
+      else
+        emit(p + m_header_size, body, frames);
+      m_pos += total;
+    }
+  }
+
+  if (m_pos == m_buf.size()) {
+    m_buf.clear();
+    m_pos = 0;
+    m_scan = 0;
+  } else if (m_pos > COMPACT_THRESHOLD || m_pos > m_buf.size() / 2) {
+    m_buf.erase(0, m_pos);
+    m_scan -= std::min(m_scan, m_pos);
+    m_pos = 0;
+  }
+}
+
+void SerialFramer::push_slip(const char *data, size_t len,
+    std::vector<std::string> *frames) {
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = data[i];
+
+    if (c == SLIP_END) {
+      if (!m_discard && !m_buf.empty())
+        emit(m_buf.data(), m_buf.size(), frames);
+      m_buf.clear();
+      m_escape = false;
+      m_discard = false;
+      continue;
+    }
+
+    if (m_discard)
+      continue;
+
+    if (m_escape) {
+      m_escape = false;
+
+      if (c == SLIP_ESC_END) {
+        c = SLIP_END;
+      } else if (c == SLIP_ESC_ESC) {
+        c = SLIP_ESC;
+      } else {
+        error();
+        m_discard = true;
+        m_buf.clear();
+        continue;
+      }
+    } else if (c == SLIP_ESC) {
+      m_escape = true;
+      continue;
+    }
+
+    if (m_buf.size() >= m_max_frame) {
+      error();
+      m_discard = true;
+      m_buf.clear();
+      continue;
+    }
+
+    m_buf.push_back(c);
+  }
+}
+
+void SerialFramer::push_cobs(const char *data, size_t len,
+    std::vector<std::string> *frames) {
+  /* COBS adds at most one byte every 254 */
+  size_t max_encoded = m_max_frame + m_max_frame / 254 + 1;
+
+  for (size_t i = 0; i < len; i++) {
+    if (data[i] != 0) {
+      if (m_discard)
+        continue;
+
+      if (m_buf.size() >= max_encoded) {
+        error();
+        m_discard = true;
+        m_buf.clear();
+        continue;
+      }
+
+      m_buf.push_back(data[i]);
+      continue;
+    }
+
+    if (m_discard || m_buf.empty()) {
+      m_discard = false;
+      m_buf.clear();
+      continue;
+    }
+
+    /* Decode in place, the output is never longer than the input */
+    size_t in = 0;
+    size_t out = 0;
+    size_t n = m_buf.size();
+    bool valid = true;
+
+    while (in < n) {
+      size_t code = static_cast<unsigned char>(m_buf[in]);
+
+      if (in + code > n) {
+        valid = false;
+        break;
+      }
+
+      std::copy(m_buf.begin() + in + 1, m_buf.begin() + in + code,
+                m_buf.begin() + out);
+      out += code - 1;
+      in += code;
+
+      if (code < 0xFF && in < n)
+        m_buf[out++] = 0;
+    }
+
+    if (valid)
+      emit(m_buf.data(), out, frames);
+    else
+      error();
+
+    m_buf.clear();
+  }
+}
+
+}  // namespace artik
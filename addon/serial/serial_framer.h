@@ -0,0 +1,108 @@
+/*
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ */
+
+#ifndef ADDON_SERIAL_SERIAL_FRAMER_H_
+#define ADDON_SERIAL_SERIAL_FRAMER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace artik {
+
+/*
+ * Reassembles frames out of a serial byte stream. Bytes are pushed as they
+ * are received and only complete frames come out, partial ones being kept
+ * until the next push.
+ */
+class SerialFramer {
+ public:
+  enum Mode {
+    NONE,
+    DELIMITER,
+    FIXED,
+    LENGTH_PREFIX,
+    SLIP,
+    COBS
+  };
+
+  SerialFramer();
+
+  void set_none();
+  void set_delimiter(const std::string& delimiter, bool include);
+  void set_fixed(size_t length);
+  /*
+   * Frames made of a header_size bytes header holding the payload length
+   * in a field_size (1, 2 or 4) bytes field at field_offset. 'adjust' is
+   * added to the field value, e.g. -header_size when it counts the header.
+   */
+  void set_length_prefix(size_t header_size, size_t field_offset,
+                         size_t field_size, bool big_endian, int adjust,
+                         bool include_header);
+  void set_slip();
+  void set_cobs();
+
+  void set_max_frame(size_t max_frame) { m_max_frame = max_frame; }
+
+  Mode mode() const { return m_mode; }
+  bool enabled() const { return m_mode != NONE; }
+
+  void push(const char *data, size_t len, std::vector<std::string> *frames);
+  void reset();
+
+  uint64_t frames() const { return m_frames; }
+  uint64_t errors() const { return m_errors; }
+
+ private:
+  void push_buffered(const char *data, size_t len,
+                     std::vector<std::string> *frames);
+  void push_slip(const char *data, size_t len,
+                 std::vector<std::string> *frames);
+  void push_cobs(const char *data, size_t len,
+                 std::vector<std::string> *frames);
+  void emit(const char *data, size_t len, std::vector<std::string> *frames);
+  void error();
+
+  Mode m_mode;
+  size_t m_max_frame;
+
+  /* Pending bytes, consumed up to m_pos */
+  std::string m_buf;
+  size_t m_pos;
+  size_t m_scan;
+  bool m_escape;
+  bool m_discard;
+
+  std::string m_delimiter;
+  bool m_include;
+  size_t m_fixed;
+  size_t m_header_size;
+  size_t m_field_offset;
+  size_t m_field_size;
+  bool m_big_endian;
+  int m_adjust;
+
+  uint64_t m_frames;
+  uint64_t m_errors;
+};
+
+}  // namespace artik
+
+#endif  // ADDON_SERIAL_SERIAL_FRAMER_H_
@@ -21,6 +21,12 @@
 #include <unistd.h>
 #include <node_buffer.h>
 #include <nan.h>
+#include <uv.h>
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
 
 #define MAX_ARG_STR_LEN 32
 
@@ -41,15 +47,163 @@ using v8::Context;
 
 Persistent<Function> SpiWrapper::constructor;
 
+/*
+ * Continuous full-duplex streaming: a dedicated thread repeats the same
+ * transfer into a ring of receive Buffers allocated once at start. Filled
+ * slots are handed to JS in batches through an uv_async handle and go back
+ * to the ring when the callback returns. When JS does not keep up (or the
+ * stream is paused) the ring runs out of free slots and the thread waits,
+ * so memory use stays bounded.
+ */
+struct SpiStream {
+  SpiWrapper* wrap;
+  uv_async_t async;
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable cond;
+  bool quit;
+  bool paused;
+  artik_error error;
+  std::vector<char> tx;
+  std::vector<char*> slots;
+  std::deque<size_t> free_slots;
+  std::deque<size_t> filled_slots;
+  size_t batch;
+  Nan::Persistent<v8::Array> buffers;
+  Nan::Callback* callback;
+  uint64_t transfers;
+  uint64_t stalls;
+
+  void run();
+};
+
+void SpiStream::run() {
+  std::unique_lock<std::mutex> l(lock);
+
+  while (!quit) {
+    if (free_slots.empty()) {
+      stalls++;
+      cond.wait(l, [this] { return quit || !free_slots.empty(); });
+      continue;
+    }
+
+    size_t slot = free_slots.front();
+    free_slots.pop_front();
+    l.unlock();
+
+    artik_error ret;
+    {
+      std::lock_guard<std::mutex> bus(wrap->getLock());
+      ret = wrap->getObj()->read_write(tx.data(), slots[slot], tx.size());
+    }
+
+    l.lock();
+    if (ret != S_OK) {
+      error = ret;
+      free_slots.push_front(slot);
+      l.unlock();
+      uv_async_send(&async);
+      return;
+    }
+
+    transfers++;
+    filled_slots.push_back(slot);
+    l.unlock();
+    uv_async_send(&async);
+    l.lock();
+  }
+}
+
+static void spi_stream_async_cb(uv_async_t* handle) {
+  SpiStream* stream = reinterpret_cast<SpiStream*>(handle->data);
+  Nan::HandleScope scope;
+  std::vector<size_t> batch;
+  artik_error error;
+
+  {
+    std::lock_guard<std::mutex> l(stream->lock);
+    error = stream->error;
+    while (!stream->paused && !stream->filled_slots.empty() &&
+           batch.size() < stream->batch) {
+      batch.push_back(stream->filled_slots.front());
+      stream->filled_slots.pop_front();
+    }
+  }
+
+  if (!batch.empty()) {
+    Local<v8::Array> buffers = Nan::New(stream->buffers);
+    Local<v8::Array> filled = Nan::New<v8::Array>(batch.size());
+
+    for (size_t i = 0; i < batch.size(); i++)
+      Nan::Set(filled, i, Nan::Get(buffers, batch[i]).ToLocalChecked());
+
+    Local<Value> argv[2] = { Nan::Null(), filled };
+    Local<Value> ret = stream->callback->Call(2, argv);
+
+    /* The callback may have stopped the stream */
+    if (stream->wrap == NULL)
+      return;
+
+    std::lock_guard<std::mutex> l(stream->lock);
+    if (!ret.IsEmpty() && ret->IsFalse())
+      stream->paused = true;
+    for (size_t i = 0; i < batch.size(); i++)
+      stream->free_slots.push_back(batch[i]);
+    stream->cond.notify_one();
+    /* A failure may have come while the batch was being delivered */
+    if ((!stream->paused && !stream->filled_slots.empty()) ||
+        stream->error != S_OK)
+      uv_async_send(&stream->async);
+  } else if (error != S_OK) {
+    SpiWrapper* wrap = stream->wrap;
+    Nan::Callback* callback = stream->callback;
+
+    /* Keep the callback alive past the stream teardown */
+    stream->callback = NULL;
+    wrap->stop_stream();
+
+    Local<Value> argv[1] = { Nan::Error(error_msg(error)) };
+    callback->Call(1, argv);
+    delete callback;
+  }
+}
+
+static void spi_stream_close_cb(uv_handle_t* handle) {
+  SpiStream* stream = reinterpret_cast<SpiStream*>(handle->data);
+
+  stream->buffers.Reset();
+  delete stream->callback;
+  delete stream;
+}
+
 SpiWrapper::SpiWrapper(unsigned int bus, unsigned int cs, artik_spi_mode mode,
   unsigned int bits_per_word, unsigned int speed) {
   m_spi = new Spi(bus, cs, mode, bits_per_word, speed);
+  m_stream = NULL;
 }
 
 SpiWrapper::~SpiWrapper() {
+  stop_stream();
   delete m_spi;
 }
 
+void SpiWrapper::stop_stream() {
+  if (!m_stream)
+    return;
+
+  {
+    std::lock_guard<std::mutex> l(m_stream->lock);
+    m_stream->quit = true;
+  }
+  m_stream->cond.notify_one();
+  m_stream->thread.join();
+  m_stream->wrap = NULL;
+  uv_close(reinterpret_cast<uv_handle_t*>(&m_stream->async),
+           spi_stream_close_cb);
+  m_stream = NULL;
+  Unref();
+}
+
 void SpiWrapper::Init(Local<Object> exports) {
   Isolate* isolate = exports->GetIsolate();
 
@@ -64,6 +218,11 @@ void SpiWrapper::Init(Local<Object> exports) {
   NODE_SET_PROTOTYPE_METHOD(tpl, "read", request);
   NODE_SET_PROTOTYPE_METHOD(tpl, "write", release);
   NODE_SET_PROTOTYPE_METHOD(tpl, "read_write", read_write);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stream_start", stream_start);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stream_stop", stream_stop);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stream_pause", stream_pause);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stream_resume", stream_resume);
+  NODE_SET_PROTOTYPE_METHOD(tpl, "stream_stats", stream_stats);
 
   constructor.Reset(isolate, tpl->GetFunction());
   exports->Set(String::NewFromUtf8(isolate, "spi"),
@@ -141,7 +300,11 @@ void SpiWrapper::read(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  obj->read(buffer, length);
+  {
+    std::lock_guard<std::mutex> lock(
+        ObjectWrap::Unwrap<SpiWrapper>(args.Holder())->getLock());
+    obj->read(buffer, length);
+  }
 
   args.GetReturnValue().Set(Nan::CopyBuffer(buffer, length).ToLocalChecked());
 
@@ -166,9 +329,10 @@ void SpiWrapper::write(const FunctionCallbackInfo<Value>& args) {
   char * buffer = node::Buffer::Data(args[0]);
   unsigned int length = node::Buffer::Length(args[0]);
 
-  Spi* obj = ObjectWrap::Unwrap<SpiWrapper>(args.Holder())->getObj();
+  SpiWrapper* wrap = ObjectWrap::Unwrap<SpiWrapper>(args.Holder());
+  std::lock_guard<std::mutex> lock(wrap->getLock());
 
-  artik_error ret = obj->write(buffer, length);
+  artik_error ret = wrap->getObj()->write(buffer, length);
 
   args.GetReturnValue().Set(Number::New(isolate, ret));
 }
@@ -199,7 +363,11 @@ void SpiWrapper::read_write(const FunctionCallbackInfo<Value>& args) {
     return;
   }
 
-  obj->read_write(tx_buffer, rx_buffer, length);
+  {
+    std::lock_guard<std::mutex> lock(
+        ObjectWrap::Unwrap<SpiWrapper>(args.Holder())->getLock());
+    obj->read_write(tx_buffer, rx_buffer, length);
+  }
 
   args.GetReturnValue().Set(
       Nan::CopyBuffer(rx_buffer, length).ToLocalChecked());
@@ -207,5 +375,107 @@ void SpiWrapper::read_write(const FunctionCallbackInfo<Value>& args) {
   free(rx_buffer);
 }
 
+void SpiWrapper::stream_start(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SpiWrapper* wrap = ObjectWrap::Unwrap<SpiWrapper>(args.Holder());
+
+  if (args.Length() < 4 || !args[1]->IsUint32() || !args[2]->IsUint32() ||
+      !args[3]->IsFunction() || args[1]->Uint32Value() == 0 ||
+      args[2]->Uint32Value() == 0) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Wrong arguments")));
+    return;
+  }
+
+  if (!node::Buffer::HasInstance(args[0]) ||
+      node::Buffer::Length(args[0]) == 0) {
+    isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(
+        isolate, "Argument should be a Buffer.")));
+    return;
+  }
+
+  if (wrap->m_stream) {
+    isolate->ThrowException(Exception::Error(String::NewFromUtf8(
+        isolate, "Stream already started")));
+    return;
+  }
+
+  char *tx_buffer = node::Buffer::Data(args[0]);
+  size_t length = node::Buffer::Length(args[0]);
+  unsigned int ring_size = args[1]->Uint32Value();
+  Local<v8::Array> buffers = Nan::New<v8::Array>(ring_size);
+  SpiStream* stream = new SpiStream();
+
+  stream->wrap = wrap;
+  stream->quit = false;
+  stream->paused = false;
+  stream->error = S_OK;
+  stream->tx.assign(tx_buffer, tx_buffer + length);
+  stream->batch = args[2]->Uint32Value();
+  stream->callback = new Nan::Callback(args[3].As<Function>());
+  stream->transfers = 0;
+  stream->stalls = 0;
+
+  for (unsigned int i = 0; i < ring_size; i++) {
+    Local<Object> buffer = Nan::NewBuffer(length).ToLocalChecked();
+
+    Nan::Set(buffers, i, buffer);
+    stream->slots.push_back(node::Buffer::Data(buffer));
+    stream->free_slots.push_back(i);
+  }
+  stream->buffers.Reset(buffers);
+
+  stream->async.data = stream;
+  uv_async_init(uv_default_loop(), &stream->async, spi_stream_async_cb);
+
+  /* Keep the wrapper alive for as long as the stream runs */
+  wrap->Ref();
+  wrap->m_stream = stream;
+  stream->thread = std::thread(&SpiStream::run, stream);
+}
+
+void SpiWrapper::stream_stop(const FunctionCallbackInfo<Value>& args) {
+  ObjectWrap::Unwrap<SpiWrapper>(args.Holder())->stop_stream();
+}
+
+void SpiWrapper::stream_pause(const FunctionCallbackInfo<Value>& args) {
+  SpiStream* stream = ObjectWrap::Unwrap<SpiWrapper>(args.Holder())->m_stream;
+
+  if (!stream)
+    return;
+
+  std::lock_guard<std::mutex> l(stream->lock);
+  stream->paused = true;
+}
+
+void SpiWrapper::stream_resume(const FunctionCallbackInfo<Value>& args) {
+  SpiStream* stream = ObjectWrap::Unwrap<SpiWrapper>(args.Holder())->m_stream;
+
+  if (!stream)
+    return;
+
+  std::lock_guard<std::mutex> l(stream->lock);
+  stream->paused = false;
+  uv_async_send(&stream->async);
+}
+
+void SpiWrapper::stream_stats(const FunctionCallbackInfo<Value>& args) {
+  Isolate* isolate = args.GetIsolate();
+  SpiStream* stream = ObjectWrap::Unwrap<SpiWrapper>(args.Holder())->m_stream;
+  Local<Object> stats = Object::New(isolate);
+
+  if (stream) {
+    std::lock_guard<std::mutex> l(stream->lock);
+    stats->Set(String::NewFromUtf8(isolate, "transfers"),
+               Number::New(isolate, stream->transfers));
+    stats->Set(String::NewFromUtf8(isolate, "stalls"),
+               Number::New(isolate, stream->stalls));
+    stats->Set(String::NewFromUtf8(isolate, "pending"),
+               Number::New(isolate, stream->filled_slots.size()));
+  }
+
+  args.GetReturnValue().Set(stats);
+}
+
 }  // namespace artik
 
@@ -24,13 +24,18 @@
 
 #include <artik_spi.hh>
 
+#include <mutex>
+
 namespace artik {
 
+struct SpiStream;
+
 class SpiWrapper : public node::ObjectWrap {
  public:
   static void Init(v8::Local<v8::Object> exports);
 
   Spi* getObj() { return m_spi; }
+  std::mutex& getLock() { return m_lock; }
 
  private:
   SpiWrapper(unsigned int bus, unsigned int cs, artik_spi_mode mode,
@@ -45,8 +50,18 @@ class SpiWrapper : public node::ObjectWrap {
   static void read(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void write(const v8::FunctionCallbackInfo<v8::Value>& args);
   static void read_write(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stream_start(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stream_stop(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stream_pause(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stream_resume(const v8::FunctionCallbackInfo<v8::Value>& args);
+  static void stream_stats(const v8::FunctionCallbackInfo<v8::Value>& args);
+
+  void stop_stream();
 
   Spi* m_spi;
+  /* Serializes transfers between the JS thread and the streaming thread */
+  std::mutex m_lock;
+  SpiStream* m_stream;
 };
 
 }  // namespace artik
@@ -53,11 +53,13 @@ ZigbeeWrapper::ZigbeeWrapper() :
     m_init_cb(0) {
   m_zb = new Zigbee();
   m_loop = GlibLoop::Instance();
+  /* Its SDK calls are not serialized with the GLib thread */
   m_loop->attach();
 }
 
 ZigbeeWrapper::~ZigbeeWrapper() {
   delete m_zb;
+  m_loop->cancel(this);
   m_loop->detach();
 }
 
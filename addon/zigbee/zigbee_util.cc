@@ -22,6 +22,8 @@
 #include <artik_log.h>
 #include <glib.h>
 
+#include <string>
+
 #include "zigbee/zigbee.h"
 #include "zigbee/zigbee_util.h"
 
@@ -976,8 +978,6 @@ char* convert_endpointlist_to_json(const artik_zigbee_endpoint_list *list) {
 
 void zb_callback(void *user_data, artik_zigbee_response_type response_type,
                  void *payload) {
-  Isolate * isolate = Isolate::GetCurrent();
-  v8::HandleScope handleScope(isolate);
   ZigbeeWrapper* wrap = reinterpret_cast<ZigbeeWrapper*>(user_data);
   converter_func func = NULL;
   char *json_res;
@@ -1063,14 +1063,22 @@ void zb_callback(void *user_data, artik_zigbee_response_type response_type,
   else
     json_res = _convert_unknown(response_type);
 
-  Handle<Value> argv[] =
-      { Handle<Value>(String::NewFromUtf8(isolate, json_res)) };
+  /* Payload is only valid during the callback, convert it right away */
+  std::string json(json_res ? json_res : "");
 
   if (json_res)
     free(json_res);
 
-  Local<Function>::New(isolate, *wrap->getIintCb())->Call(
-      isolate->GetCurrentContext()->Global(), 1, argv);
+  GlibLoop::Instance()->invoke(wrap, [wrap, json]() {
+    Isolate * isolate = Isolate::GetCurrent();
+    v8::HandleScope handleScope(isolate);
+
+    Handle<Value> argv[] =
+        { Handle<Value>(String::NewFromUtf8(isolate, json.c_str())) };
+
+    Local<Function>::New(isolate, *wrap->getIintCb())->Call(
+        isolate->GetCurrentContext()->Global(), 1, argv);
+  });
 }
 
 void throw_error(Isolate *isolate, artik_error code) {
@@ -0,0 +1,157 @@
+/*
+ * Compare the per operation latency of the regular SDK path with the
+ * cached descriptors of the fast I/O mode:
+ *  - gpio write()
+ *  - pwm set_duty_cycle()
+ *  - adc get_value()
+ *
+ * On a board, set BENCH_GPIO, BENCH_PWM and BENCH_ADC to the pins that can
+ * be driven safely, the same calls are then timed before and after
+ * enable_fast_io(), the others are skipped:
+ *
+ *	BENCH_GPIO=128 BENCH_PWM=0 BENCH_ADC=0 node benchmark/fast-io-benchmark.js [iterations]
+ *
+ * When none of them is set, the attributes live in a fake sysfs tree on
+ * tmpfs, so no hardware is needed. The SDK cannot be pointed at another
+ * root, so its open/access/close pattern is reproduced on the same files.
+ *
+ *	node benchmark/fast-io-benchmark.js [iterations]
+ */
+var artik = require('../src');
+var fs = require('fs');
+var os = require('os');
+
+var iterations = parseInt(process.argv[2] || '100000');
+
+function bench(name, op) {
+	var start = process.hrtime();
+
+	for (var i = 0; i < iterations; i++)
+		op(i);
+
+	var elapsed = process.hrtime(start);
+	var ns = (elapsed[0] * 1e9 + elapsed[1]) / iterations;
+
+	console.log(name + ': ' + ns.toFixed(0) + ' ns/op');
+}
+
+/* Runs the same operation before and after enabling the fast I/O mode */
+function compare(name, device, op) {
+	bench(name + ', SDK', op);
+	device.enable_fast_io();
+	bench(name + ', fast I/O', op);
+	device.disable_fast_io();
+}
+
+function bench_board() {
+	if (process.env.BENCH_GPIO) {
+		var gpio = new artik.gpio(parseInt(process.env.BENCH_GPIO), 'bench',
+			'out', 'none', 0);
+
+		gpio.request();
+		compare('gpio write', gpio, function(i) { gpio.write(i & 1); });
+		gpio.release();
+	}
+
+	if (process.env.BENCH_PWM) {
+		var pwm = artik.pwm(parseInt(process.env.BENCH_PWM), 'bench', 400000,
+			0, 0);
+
+		pwm.request();
+		compare('pwm duty cycle', pwm, function(i) {
+			pwm.set_duty_cycle(i & 0xffff);
+		});
+		pwm.release();
+	}
+
+	if (process.env.BENCH_ADC) {
+		var adc = artik.adc(parseInt(process.env.BENCH_ADC), 'bench');
+
+		adc.request();
+		compare('adc read', adc, function() { adc.get_value(); });
+		adc.release();
+	}
+}
+
+function bench_fake_sysfs() {
+	var base = fs.existsSync('/dev/shm') ? '/dev/shm' : os.tmpdir();
+	var root = fs.mkdtempSync(base + '/fake-sysfs-');
+	var files = [];
+	var dirs = [];
+
+	function attribute(path, value) {
+		var dir = root;
+
+		path.split('/').slice(0, -1).forEach(function(name) {
+			dir += '/' + name;
+			if (!fs.existsSync(dir)) {
+				fs.mkdirSync(dir);
+				dirs.unshift(dir);
+			}
+		});
+		fs.writeFileSync(root + '/' + path, value + '\n');
+		files.push(root + '/' + path);
+
+		return root + '/' + path;
+	}
+
+	/* What the SDK sysfs accessors do on every call */
+	function sdk_write(path) {
+		return function(i) {
+			var fd = fs.openSync(path, 'w');
+			fs.writeSync(fd, String(i & 1));
+			fs.closeSync(fd);
+		};
+	}
+
+	function sdk_read(path) {
+		var buf = new Buffer(32);
+
+		return function() {
+			var fd = fs.openSync(path, 'r');
+			fs.readSync(fd, buf, 0, buf.length, 0);
+			fs.closeSync(fd);
+		};
+	}
+
+	var gpio_value = attribute('class/gpio/gpio42/value', 0);
+	var pwm_duty = attribute('class/pwm/pwmchip0/pwm2/duty_cycle', 0);
+	attribute('class/pwm/pwmchip0/pwm2/period', 400000);
+	var adc_raw = attribute('bus/iio/devices/iio:device0/in_voltage0_raw',
+		1234);
+
+	/* None of these is requested, only the cached attributes are used */
+	var gpio = new artik.gpio(42, 'bench', 'out', 'none', 0);
+	var pwm = artik.pwm(2, 'bench', 400000, 0, 0);
+	var adc = artik.adc(0, 'bench');
+
+	console.log('fake sysfs in ' + root);
+
+	bench('gpio write, SDK', sdk_write(gpio_value));
+	gpio.enable_fast_io(root);
+	bench('gpio write, fast I/O', function(i) { gpio.write(i & 1); });
+	gpio.disable_fast_io();
+
+	bench('pwm duty cycle, SDK', sdk_write(pwm_duty));
+	pwm.enable_fast_io(root);
+	bench('pwm duty cycle, fast I/O', function(i) {
+		pwm.set_duty_cycle(i & 0xffff);
+	});
+	pwm.disable_fast_io();
+
+	bench('adc read, SDK', sdk_read(adc_raw));
+	adc.enable_fast_io(root);
+	bench('adc read, fast I/O', function() { adc.get_value(); });
+	adc.disable_fast_io();
+
+	files.forEach(function(file) { fs.unlinkSync(file); });
+	dirs.forEach(function(dir) { fs.rmdirSync(dir); });
+	fs.rmdirSync(root);
+}
+
+console.log(iterations + ' iterations');
+
+if (process.env.BENCH_GPIO || process.env.BENCH_PWM || process.env.BENCH_ADC)
+	bench_board();
+else
+	bench_fake_sysfs();
@@ -0,0 +1,83 @@
+/*
+ * Measure the cost of the GLib/libuv loop integration:
+ *  - CPU time consumed by an otherwise idle process while a wrapper keeps
+ *    the GLib loop attached.
+ *  - Latency between a GLib-side event (HTTP response received by the SDK)
+ *    and the corresponding JS callback.
+ *
+ * Run it once against a build of the previous release and once against the
+ * current tree to compare both loop implementations:
+ *
+ *	node benchmark/glib-loop-benchmark.js [idle_seconds] [requests]
+ */
+var spawn = require('child_process').spawn;
+var artik_http = require('../src/http');
+
+var idle_seconds = parseInt(process.argv[2] || '5');
+var requests = parseInt(process.argv[3] || '200');
+var port = 18080;
+
+var server_src =
+	"require('http').createServer(function(req, res) {" +
+	"	res.end('ok');" +
+	"}).listen(" + port + ", function() { process.send('ready'); });";
+
+function percentile(values, p) {
+	var sorted = values.slice().sort(function(a, b) { return a - b; });
+	return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+function measure_idle(http, done) {
+	var start = process.cpuUsage();
+	var wall = process.hrtime();
+
+	setTimeout(function() {
+		var cpu = process.cpuUsage(start);
+		var elapsed = process.hrtime(wall);
+		var elapsed_us = elapsed[0] * 1e6 + elapsed[1] / 1e3;
+
+		console.log('Idle CPU: ' +
+			((cpu.user + cpu.system) * 100 / elapsed_us).toFixed(2) + ' %' +
+			' (user ' + (cpu.user / 1e3).toFixed(1) + ' ms, system ' +
+			(cpu.system / 1e3).toFixed(1) + ' ms over ' + idle_seconds + ' s)');
+		done();
+	}, idle_seconds * 1000);
+}
+
+function measure_latency(http, done) {
+	var url = 'http://127.0.0.1:' + port + '/';
+	var latencies = [];
+
+	function next() {
+		if (latencies.length == requests) {
+			console.log('Request latency over ' + requests + ' requests:' +
+				' median ' + percentile(latencies, 0.5).toFixed(3) + ' ms,' +
+				' p99 ' + percentile(latencies, 0.99).toFixed(3) + ' ms,' +
+				' max ' + percentile(latencies, 1).toFixed(3) + ' ms');
+			return done();
+		}
+
+		var start = process.hrtime();
+		http.get(url, null, null, function(response, status) {
+			var diff = process.hrtime(start);
+			latencies.push(diff[0] * 1e3 + diff[1] / 1e6);
+			setImmediate(next);
+		});
+	}
+
+	next();
+}
+
+var server = spawn(process.execPath, ['-e', server_src],
+		{ stdio: ['ignore', 'inherit', 'inherit', 'ipc'] });
+
+server.on('message', function(msg) {
+	var http = new artik_http();
+
+	measure_idle(http, function() {
+		measure_latency(http, function() {
+			server.kill();
+			process.exit(0);
+		});
+	});
+});
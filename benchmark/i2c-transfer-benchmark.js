@@ -0,0 +1,102 @@
+/*
+ * Compare the cost of reading a set of registers (e.g. one sample of a 9-axis
+ * IMU) register by register against a single batched transfer:
+ *  - synchronous read_register() loop
+ *  - read_register_async() loop
+ *  - one transfer() call
+ *
+ * The chip must be readable on the target bus, the i2c-stub kernel module
+ * can be used when no real one is available:
+ *
+ *	modprobe i2c-stub chip_addr=0x50
+ *	node benchmark/i2c-transfer-benchmark.js <bus> [address] [samples] [registers]
+ */
+var i2c = require('../src/i2c');
+
+if (process.argv.length < 3) {
+	console.log('Usage: node i2c-transfer-benchmark.js <bus> [address] [samples] [registers]');
+	process.exit(-1);
+}
+
+var bus = parseInt(process.argv[2]);
+var address = parseInt(process.argv[3] || '0x50');
+var samples = parseInt(process.argv[4] || '2000');
+var registers = parseInt(process.argv[5] || '9');
+
+var chip = new i2c(bus, 2000, '8', address);
+var ops = [];
+for (var i = 0; i < registers; i++)
+	ops.push({ reg: i, len: 2 });
+
+function report(name, start) {
+	var elapsed = process.hrtime(start);
+	var elapsed_us = elapsed[0] * 1e6 + elapsed[1] / 1e3;
+
+	console.log(name + ': ' + (elapsed_us / samples).toFixed(1) + ' us/sample, ' +
+		Math.round(samples * 1e6 / elapsed_us) + ' samples/s');
+}
+
+function bench_sync(next) {
+	var start = process.hrtime();
+
+	for (var n = 0; n < samples; n++) {
+		for (var i = 0; i < registers; i++)
+			chip.read_register(ops[i].reg, ops[i].len);
+	}
+
+	report('read_register loop      ', start);
+	next();
+}
+
+function bench_async(next) {
+	var start = process.hrtime();
+	var out = new Buffer(registers * 2);
+	var n = 0;
+
+	(function sample() {
+		var pending = [];
+
+		if (n++ == samples) {
+			report('read_register_async loop', start);
+			return next();
+		}
+
+		for (var i = 0; i < registers; i++)
+			pending.push(chip.read_register_async(ops[i].reg, out.slice(i * 2, i * 2 + 2)));
+
+		Promise.all(pending).then(sample);
+	})();
+}
+
+function bench_transfer(next) {
+	var start = process.hrtime();
+	var out = new Buffer(registers * 2);
+	var n = 0;
+
+	(function sample(err) {
+		if (err)
+			throw err;
+
+		if (n++ == samples) {
+			report('transfer                ', start);
+			return next();
+		}
+
+		chip.transfer(ops, out, sample);
+	})();
+}
+
+if (chip.request()) {
+	console.log('Failed to request I2C chip ' + address + ' on bus ' + bus);
+	process.exit(-1);
+}
+
+console.log(samples + ' samples of ' + registers + ' registers');
+
+bench_sync(function() {
+	bench_async(function() {
+		bench_transfer(function() {
+			chip.release();
+		});
+	});
+});
@@ -0,0 +1,125 @@
+/*
+ * Measure the serial receive throughput and the GC activity it causes.
+ *
+ * A pseudo-terminal pair is created with socat, one end being linked to the
+ * device node the SDK opens for the given port, while a child process writes
+ * to the other end as fast as possible:
+ *
+ *	node benchmark/serial-rx-benchmark.js <port> <device> [mode] [size] [pool] [seconds]
+ *
+ * The device node must not exist yet, move the real one away while running
+ * the benchmark. For instance on ARTIK 530, where port 4 is /dev/ttyAMA4:
+ *
+ *	node benchmark/serial-rx-benchmark.js 4 /dev/ttyAMA4 copy 128
+ *	node benchmark/serial-rx-benchmark.js 4 /dev/ttyAMA4 pool 4096 8
+ *
+ * 'copy' with a 128 bytes size matches the behavior of previous releases.
+ */
+var spawn = require('child_process').spawn;
+var fs = require('fs');
+var serial = require('../src/serial');
+
+if (process.argv.length < 4) {
+	console.log('Usage: node serial-rx-benchmark.js <port> <device> [copy|pool] [size] [pool] [seconds]');
+	process.exit(-1);
+}
+
+var port = parseInt(process.argv[2]);
+var device = process.argv[3];
+var mode = process.argv[4] || 'copy';
+var size = parseInt(process.argv[5] || '128');
+var pool = (mode == 'pool') ? parseInt(process.argv[6] || '8') : 0;
+var seconds = parseInt(process.argv[7] || '10');
+var peer = '/tmp/artik-serial-benchmark';
+
+var writer_src =
+	"var fs = require('fs');" +
+	"var chunk = new Buffer(65536).fill(0x55);" +
+	"var out = fs.createWriteStream('" + peer + "');" +
+	"(function write() { while (out.write(chunk)); out.once('drain', write); })();";
+
+var gc_count = 0;
+var gc_time = 0;
+
+function observe_gc() {
+	var perf_hooks;
+
+	try {
+		perf_hooks = require('perf_hooks');
+	} catch (e) {
+		return false;
+	}
+
+	if (!perf_hooks.PerformanceObserver)
+		return false;
+
+	new perf_hooks.PerformanceObserver(function(list) {
+		list.getEntries().forEach(function(entry) {
+			gc_count++;
+			gc_time += entry.duration;
+		});
+	}).observe({ entryTypes: ['gc'] });
+
+	return true;
+}
+
+function run() {
+	var uart = new serial(port, 'benchmark', 115200, 'none', 8, 1, 'none');
+	var events = 0;
+
+	uart.set_rx_buffer(size, pool);
+	uart.on('read', function(data) {
+		events++;
+		if (pool)
+			uart.recycle(data);
+	});
+
+	if (uart.request()) {
+		console.log('Failed to request serial port ' + port);
+		process.exit(-1);
+	}
+
+	var gc_observed = observe_gc();
+	var writer = spawn(process.execPath, ['-e', writer_src], { stdio: 'inherit' });
+	var start = process.hrtime();
+
+	setTimeout(function() {
+		var elapsed = process.hrtime(start);
+		var elapsed_s = elapsed[0] + elapsed[1] / 1e9;
+		var stats = uart.get_rx_stats();
+
+		writer.kill();
+		uart.release();
+
+		console.log('Mode: ' + mode + ', size: ' + size + ', pool: ' + pool);
+		console.log('Throughput: ' + Math.round(stats.bytes / elapsed_s) + ' bytes/s, ' +
+			Math.round(events / elapsed_s) + ' events/s');
+		if (pool)
+			console.log('Pool misses: ' + stats.pool_misses);
+		if (gc_observed)
+			console.log('GC: ' + gc_count + ' pauses, ' + gc_time.toFixed(1) + ' ms total');
+		else
+			console.log('GC: not observable with this node.js version');
+		process.exit(0);
+	}, seconds * 1000);
+}
+
+var socat = spawn('socat', [
+	'PTY,raw,echo=0,link=' + device,
+	'PTY,raw,echo=0,link=' + peer
+], { stdio: 'inherit' });
+
+socat.on('error', function() {
+	console.log('socat is needed to create the pseudo-terminals');
+	process.exit(-1);
+});
+
+process.on('exit', function() {
+	socat.kill();
+});
+
+(function wait_pty() {
+	if (fs.existsSync(device) && fs.existsSync(peer))
+		return run();
+	setTimeout(wait_pty, 100);
+})();
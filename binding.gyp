@@ -29,7 +29,8 @@
       'cflags_cc': [
                 '-fexceptions',
 		'-DCONFIG_RELEASE',
-                '<!@(pkg-config --cflags-only-I glib-2.0)'
+                '<!@(pkg-config --cflags-only-I glib-2.0)',
+                '<!@(pkg-config --cflags-only-I libcurl)'
       ],
       'link_settings' : {
                 'ldflags': ['-Wl,--no-as-needed'],
@@ -43,7 +44,8 @@
                         '<!@(pkg-config --libs-only-l libartik-sdk-wifi)',
                         '<!@(pkg-config --libs-only-l libartik-sdk-zigbee)',
                         '<!@(pkg-config --libs-only-l libartik-sdk-lwm2m)',
-                        '<!@(pkg-config --libs-only-l libartik-sdk-mqtt)'
+                        '<!@(pkg-config --libs-only-l libartik-sdk-mqtt)',
+                        '<!@(pkg-config --libs-only-l libcurl)'
                 ]
       },
       'sources': [
@@ -51,12 +53,21 @@
         'addon/utils.cc',
         'addon/loop.cc',
         'addon/base/ssl_config_converter.cc',
+        'addon/base/sysfs_file.cc',
+        'addon/base/sha256.cc',
         'addon/gpio/gpio.cc',
+        'addon/gpio/gpio_group.cc',
         'addon/serial/serial.cc',
+        'addon/serial/serial_framer.cc',
         'addon/i2c/i2c.cc',
         'addon/pwm/pwm.cc',
         'addon/adc/adc.cc',
+        'addon/dsp/dsp_pipeline.cc',
+        'addon/dsp/dsp_js.cc',
         'addon/http/http.cc',
+        'addon/http/http_client.cc',
+        'addon/http/header_arena.cc',
+        'addon/http/http_headers.cc',
         'addon/websocket/websocket.cc',
         'addon/cloud/cloud.cc',
         'addon/wifi/wifi.cc',
@@ -64,6 +75,9 @@
         'addon/spi/spi.cc',
         'addon/time/time.cc',
         'addon/sensor/sensor.cc',
+        'addon/sensor/sensor_hub.cc',
+        'addon/recorder/ring_file.cc',
+        'addon/recorder/recorder.cc',
         'addon/network/network.cc',
         'addon/bluetooth/bluetooth.cc',
         'addon/bluetooth/agent.cc',
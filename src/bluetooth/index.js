@@ -1,6 +1,7 @@
 var events = require('events');
 var util = require('util');
 var artik = require('../../build/Release/artik-sdk.node');
+var SppStream = require('../stream').SppStream;
 
 var Filter = function(rssi, uuids, type) {
 	this.rssi = rssi;
@@ -37,6 +38,10 @@ artik.SppSocket.prototype.__proto__ = events.EventEmitter.prototype;
 artik.Spp.prototype.__proto__ = events.EventEmitter.prototype;
 artik.Ftp.prototype.__proto__ = events.EventEmitter.prototype;
 
+artik.SppSocket.prototype.create_stream = function create_stream(options) {
+	return new SppStream(this, options);
+};
+
 module.exports = require('./bluetooth');
 module.exports.Avrcp = artik.Avrcp;
 module.exports.A2dp = artik.A2dp;
@@ -41,3 +41,43 @@ Gpio.prototype.get_direction = function get_direction() {
 Gpio.prototype.get_id = function get_id() {
 	return this.gpio.get_id();
 };
+
+Gpio.prototype.start_capture = function start_capture(options) {
+	var _ = this;
+	return this.gpio.start_capture(options || {}, function(events, dropped) {
+		_.emit('edges', events, dropped);
+	});
+};
+
+Gpio.prototype.stop_capture = function stop_capture() {
+	return this.gpio.stop_capture();
+};
+
+Gpio.prototype.get_capture_stats = function get_capture_stats() {
+	return this.gpio.get_capture_stats();
+};
+
+Gpio.prototype.start_counter = function start_counter(options) {
+	var _ = this;
+	return this.gpio.start_counter(options || {}, function(snapshot) {
+		_.emit('counter', snapshot);
+	});
+};
+
+Gpio.prototype.stop_counter = function stop_counter() {
+	return this.gpio.stop_counter();
+};
+
+Gpio.prototype.read_counter = function read_counter(reset) {
+	return this.gpio.read_counter(!!reset);
+};
+
+Gpio.prototype.enable_fast_io = function enable_fast_io(root) {
+	if (root === undefined)
+		return this.gpio.enable_fast_io();
+	return this.gpio.enable_fast_io(root);
+};
+
+Gpio.prototype.disable_fast_io = function disable_fast_io() {
+	return this.gpio.disable_fast_io();
+};
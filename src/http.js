@@ -1,18 +1,25 @@
 var events = require('events');
 var util = require('util');
 var http = require('../build/Release/artik-sdk.node').http;
+var http_headers = require('../build/Release/artik-sdk.node').http_headers;
 
 var Readable = require('stream').Readable;
 
-var Http = function() {
+var Http = function(options) {
 	events.EventEmitter.call(this);
-	this.http = new http();
+	this.http = new http(options);
 }
 
 util.inherits(Http, events.EventEmitter);
 
 module.exports = Http;
 
+/*
+ * Headers marshaled once and shared by every request they are passed to,
+ * in place of a [name, value, ...] array.
+ */
+Http.HttpHeaders = http_headers;
+
 Http.prototype.get_stream = function(url, headers, ssl_config) {
 	var fifo = new Buffer(0);
 	var read_on = false;
@@ -44,18 +51,155 @@ Http.prototype.get_stream = function(url, headers, ssl_config) {
 	return inStream;
 }
 
+/*
+ * Feed a readable stream to a request, one chunk at a time: the stream
+ * stays paused until the native side is done with the previous chunk.
+ */
+function pump(_, id, stream, reject) {
+	stream.on('data', function(chunk) {
+		if (!Buffer.isBuffer(chunk))
+			chunk = new Buffer(chunk);
+
+		stream.pause();
+		_.http.write_body(id, chunk, function() {
+			stream.resume();
+		});
+	});
+
+	stream.on('end', function() {
+		_.http.end_body(id);
+	});
+
+	stream.on('error', function(err) {
+		reject(err);
+		_.http.cancel(id);
+	});
+}
+
+/*
+ * Without a callback, requests run natively off the JavaScript thread and
+ * return a Promise of { status, headers, body }. The body is a Buffer with
+ * the 'binary' option, a String otherwise. The Promise carries a cancel()
+ * method which aborts the request and rejects it with an ECANCELED error.
+ */
+function request(_, method, url, headers, body, ssl_config, options) {
+	var id;
+	var stream = body && typeof body.pipe === 'function' ? body : null;
+	var binary = !!(options && options.binary);
+	var promise = new Promise(function(resolve, reject) {
+		id = _.http.request(method, url, headers, stream ? { stream: true } : body,
+			ssl_config, options || {},
+			function(err, status, response, response_headers) {
+				if (err)
+					reject(err);
+				else
+					resolve({
+						status: status,
+						headers: response_headers,
+						body: binary ? response : response.toString()
+					});
+			});
+
+		if (stream)
+			pump(_, id, stream, reject);
+	});
+
+	promise.cancel = function() {
+		if (id !== undefined)
+			_.http.cancel(id);
+	};
+
+	return promise;
+}
+
+/* Callback flavor of request(), for bodies only the native client takes */
+function request_cb(_, method, url, headers, body, ssl_config, func) {
+	request(_, method, url, headers, body, ssl_config).then(
+		function(response) {
+			func(response.body, response.status);
+		},
+		function(err) {
+			func(err.message, 0);
+		});
+}
+
+/*
+ * Download to a file natively, the data never goes through JavaScript.
+ * Resolved with { status, headers, size, resumed, sha256 }, rejected on
+ * transfer failures and on statuses other than 2xx. A 416 reply to a
+ * resumed download means the file was already complete.
+ */
+Http.prototype.download = function(url, path, opts) {
+	var _ = this;
+	var id;
+	var options = Object.assign({ progress_interval: 500 }, opts);
+	var promise = new Promise(function(resolve, reject) {
+		id = _.http.download(url, path, options.headers, options.ssl_config, options,
+			typeof options.progress === 'function' ? options.progress : undefined,
+			function(err, status, body, headers, info) {
+				if (err)
+					return reject(err);
+
+				if ((status < 200 || status >= 300) && !(status === 416 && info.resumed)) {
+					var error = new Error('Download failed with status ' + status);
+
+					error.status = status;
+					error.body = body.toString();
+					return reject(error);
+				}
+
+				resolve({
+					status: status,
+					headers: headers,
+					size: info.size,
+					resumed: info.resumed,
+					sha256: info.sha256
+				});
+			});
+	});
+
+	promise.cancel = function() {
+		if (id !== undefined)
+			_.http.cancel(id);
+	};
+
+	return promise;
+}
+
+Http.prototype.get_pool_stats = function() {
+	return this.http.get_pool_stats();
+}
+
 Http.prototype.get = function(url, headers, ssl_config, func) {
+	if (typeof func !== 'function')
+		return request(this, 'GET', url, headers, undefined, ssl_config, func);
+
 	return this.http.get(url, headers, ssl_config, func);
 }
 
 Http.prototype.post = function(url, headers, body, ssl_config, func) {
+	if (typeof func !== 'function')
+		return request(this, 'POST', url, headers, body, ssl_config, func);
+
+	if (body && typeof body === 'object')
+		return request_cb(this, 'POST', url, headers, body, ssl_config, func);
+
 	return this.http.post(url, headers, body, ssl_config, func);
 };
 
 Http.prototype.put = function(url, headers, body, ssl_config, func) {
+	if (typeof func !== 'function')
+		return request(this, 'PUT', url, headers, body, ssl_config, func);
+
+	if (body && typeof body === 'object')
+		return request_cb(this, 'PUT', url, headers, body, ssl_config, func);
+
 	return this.http.put(url, headers, body, ssl_config, func);
 }
 
 Http.prototype.del = function(url, headers, ssl_config, func) {
+	if (typeof func !== 'function')
+		return request(this, 'DELETE', url, headers, undefined, ssl_config, func);
+
 	return this.http.del(url, headers, ssl_config, func);
 }
@@ -0,0 +1,32 @@
+var i2c = require('../build/Release/artik-sdk.node').i2c;
+
+/*
+ * The native asynchronous methods take a node-style callback as their last
+ * argument. When it is omitted, return a Promise instead.
+ */
+function promisify(method) {
+	return function() {
+		var _ = this;
+		var args = Array.prototype.slice.call(arguments);
+
+		if (typeof args[args.length - 1] === 'function')
+			return method.apply(this, args);
+
+		return new Promise(function(resolve, reject) {
+			args.push(function(err, data) {
+				if (err)
+					reject(err);
+				else
+					resolve(data);
+			});
+			method.apply(_, args);
+		});
+	};
+}
+
+[ 'read_async', 'write_async', 'read_register_async', 'write_register_async',
+	'transfer' ].forEach(function(name) {
+	i2c.prototype[name] = promisify(i2c.prototype[name]);
+});
+
+module.exports = i2c;
@@ -19,17 +19,21 @@ module.exports.get_platform_serial_number = artik.get_platform_serial_number;
 module.exports.get_platform_manufacturer = artik.get_platform_manufacturer;
 module.exports.get_platform_uptime = artik.get_platform_uptime;
 module.exports.get_platform_model_number = artik.get_platform_model_number;
+module.exports.set_glib_thread = artik.set_glib_thread;
 module.exports.destroy = artik.destroy;
 
 module.exports.adc = artik.adc;
-module.exports.i2c = artik.i2c;
+module.exports.gpio_group = artik.gpio_group;
 module.exports.media = artik.media;
 module.exports.pwm = artik.pwm;
+module.exports.recorder = artik.recorder;
 module.exports.sensor = artik.sensor;
+module.exports.sensor_hub = artik.sensor_hub;
 module.exports.spi = artik.spi;
 
 /* Other exports */
 module.exports.time = require('./time');
+module.exports.i2c = require('./i2c');
 module.exports.http = require('./http');
 module.exports.bluetooth = require('./bluetooth');
 module.exports.wifi = require('./wifi');
@@ -1,10 +1,14 @@
 var events = require('events');
 var util = require('util');
 var serial = require('../build/Release/artik-sdk.node').serial;
+var SerialStream = require('./stream').SerialStream;
 
 function Serial(id, label, baudrate, parity, frame_size, stop_bits, ctrl) {
 	events.EventEmitter.call(this);
 	this.serial = serial(id, label, baudrate, parity, frame_size, stop_bits, ctrl);
+	this.high_water_mark = 16384;
+	this.queued = 0;
+	this.need_drain = false;
 }
 
 util.inherits(Serial, events.EventEmitter);
@@ -12,8 +16,17 @@ module.exports = Serial;
 
 Serial.prototype.request = function request() {
 	var _ = this;
-	return this.serial.request(function(val) {
-		_.emit('read', val);
+	return this.serial.request(function(val, length) {
+		if (Array.isArray(val)) {
+			_.emit('frames', val);
+			if (_.listenerCount('frame') > 0) {
+				val.forEach(function(frame) {
+					_.emit('frame', frame);
+				});
+			}
+			return;
+		}
+		_.emit('read', length < val.length ? val.slice(0, length) : val);
 	});
 };
 
@@ -25,6 +38,65 @@ Serial.prototype.write = function write(val) {
     return this.serial.write(val);
 };
 
+Serial.prototype.write_async = function write_async(val, callback) {
+	var _ = this;
+	this.queued += val.length;
+	this.serial.write_async(val, function(err) {
+		_.queued -= val.length;
+		if (callback)
+			callback(err);
+		else if (err && _.listenerCount('error') > 0)
+			_.emit('error', err);
+		if (_.need_drain && _.queued == 0) {
+			_.need_drain = false;
+			_.emit('drain');
+		}
+	});
+	if (this.queued >= this.high_water_mark)
+		this.need_drain = true;
+	return !this.need_drain;
+};
+
+Serial.prototype.set_high_water_mark = function set_high_water_mark(val) {
+	this.high_water_mark = val;
+};
+
+Serial.prototype.get_write_queue_size = function get_write_queue_size() {
+	return this.queued;
+};
+
+Serial.prototype.set_rx_buffer = function set_rx_buffer(size, pool) {
+	if (pool === undefined)
+		return this.serial.set_rx_buffer(size);
+	return this.serial.set_rx_buffer(size, pool);
+};
+
+Serial.prototype.recycle = function recycle(buf) {
+	return this.serial.recycle(buf);
+};
+
+Serial.prototype.get_rx_stats = function get_rx_stats() {
+	return this.serial.get_rx_stats();
+};
+
+Serial.prototype.set_framing = function set_framing(mode, options) {
+	if (options === undefined)
+		return this.serial.set_framing(mode);
+	return this.serial.set_framing(mode, options);
+};
+
+Serial.prototype.pause_receive = function pause_receive() {
+	return this.serial.pause_receive();
+};
+
+Serial.prototype.resume_receive = function resume_receive() {
+	return this.serial.resume_receive();
+};
+
+Serial.prototype.create_stream = function create_stream(options) {
+	return new SerialStream(this, options);
+};
+
 Serial.prototype.get_port_num = function get_port_num() {
     return this.serial.get_port_num();
 };
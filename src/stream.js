@@ -0,0 +1,196 @@
+var stream = require('stream');
+var util = require('util');
+
+/*
+ * Duplex adapters over the event based wrappers. The source is paused
+ * natively as soon as push() returns false and resumed from _read(), so
+ * that a slow consumer does not make received data pile up in memory.
+ */
+
+/*
+ * Streams only call _destroy() from destroy() since node 8. On older
+ * versions, provide a destroy() doing the same, so that the source is
+ * released there too.
+ */
+function add_destroy(Stream) {
+	if (stream.Duplex.prototype.destroy)
+		return;
+
+	Stream.prototype.destroy = function destroy(err) {
+		var _ = this;
+
+		if (this.destroyed)
+			return this;
+		this.destroyed = true;
+		this._destroy(err || null, function(err) {
+			process.nextTick(function() {
+				if (err)
+					_.emit('error', err);
+				_.emit('close');
+			});
+		});
+		return this;
+	};
+}
+
+function SerialStream(serial, options) {
+	stream.Duplex.call(this, options);
+	this.serial = serial;
+	this.paused = false;
+	this.pooled = serial.get_rx_stats().pool_size > 0;
+
+	var _ = this;
+	this.on_read = function(buf) {
+		if (_.pooled) {
+			/*
+			 * Pool slabs go back to the port, the stream keeps a copy.
+			 * Other 'read' listeners get the same slab, which is then
+			 * theirs to recycle.
+			 */
+			var copy = new Buffer(buf.length);
+			buf.copy(copy);
+			if (serial.listenerCount('read') == 1)
+				serial.recycle(buf);
+			buf = copy;
+		}
+		_.receive(buf);
+	};
+	this.on_frames = function(frames) {
+		frames.forEach(function(frame) {
+			_.receive(frame);
+		});
+	};
+	serial.on('read', this.on_read);
+	serial.on('frames', this.on_frames);
+}
+
+util.inherits(SerialStream, stream.Duplex);
+
+SerialStream.prototype.receive = function receive(chunk) {
+	if (!this.push(chunk) && !this.paused) {
+		this.paused = true;
+		this.serial.serial.pause_receive();
+	}
+};
+
+SerialStream.prototype._read = function _read() {
+	if (this.paused) {
+		this.paused = false;
+		this.serial.serial.resume_receive();
+	}
+};
+
+SerialStream.prototype._write = function _write(chunk, encoding, callback) {
+	this.serial.write_async(chunk, callback);
+};
+
+SerialStream.prototype._destroy = function _destroy(err, callback) {
+	this.serial.removeListener('read', this.on_read);
+	this.serial.removeListener('frames', this.on_frames);
+	if (this.paused) {
+		this.paused = false;
+		this.serial.serial.resume_receive();
+	}
+	callback(err);
+};
+
+function SppStream(socket, options) {
+	stream.Duplex.call(this, options);
+	this.socket = socket;
+	this.paused = false;
+
+	var _ = this;
+	this.on_data = function(error, buf) {
+		if (error) {
+			_.emit('error', new Error(error));
+			return;
+		}
+		if (buf.length == 0) {
+			_.push(null);
+			return;
+		}
+		if (!_.push(buf) && !_.paused) {
+			_.paused = true;
+			socket.pause();
+		}
+	};
+	socket.on('data', this.on_data);
+}
+
+util.inherits(SppStream, stream.Duplex);
+
+SppStream.prototype._read = function _read() {
+	if (this.paused) {
+		this.paused = false;
+		this.socket.resume();
+	}
+};
+
+SppStream.prototype._write = function _write(chunk, encoding, callback) {
+	try {
+		this.socket.write(chunk);
+	} catch (err) {
+		return callback(err);
+	}
+	callback();
+};
+
+SppStream.prototype._destroy = function _destroy(err, callback) {
+	this.socket.removeListener('data', this.on_data);
+	if (this.paused) {
+		this.paused = false;
+		this.socket.resume();
+	}
+	callback(err);
+};
+
+/*
+ * The websocket SDK reads its socket on its own and has no way to throttle
+ * it, so messages received while the consumer is slow are only held back
+ * in the readable buffer.
+ */
+function WebsocketStream(websocket, options) {
+	stream.Duplex.call(this, options);
+	this.websocket = websocket;
+
+	var _ = this;
+	this.on_receive = function(message) {
+		_.push(message);
+	};
+	this.on_connected = function(status) {
+		if (status == 'CLOSED')
+			_.push(null);
+		else if (status == 'HANDSHAKE ERROR')
+			_.emit('error', new Error('Websocket handshake error'));
+	};
+	websocket.on('receive', this.on_receive);
+	websocket.on('connected', this.on_connected);
+}
+
+util.inherits(WebsocketStream, stream.Duplex);
+
+WebsocketStream.prototype._read = function _read() {
+};
+
+WebsocketStream.prototype._write = function _write(chunk, encoding, callback) {
+	try {
+		this.websocket.write_stream(chunk.toString());
+	} catch (err) {
+		return callback(err);
+	}
+	callback();
+};
+
+WebsocketStream.prototype._destroy = function _destroy(err, callback) {
+	this.websocket.removeListener('receive', this.on_receive);
+	this.websocket.removeListener('connected', this.on_connected);
+	callback(err);
+};
+
+add_destroy(SerialStream);
+add_destroy(SppStream);
+add_destroy(WebsocketStream);
+
+module.exports.SerialStream = SerialStream;
+module.exports.SppStream = SppStream;
+module.exports.WebsocketStream = WebsocketStream;
@@ -1,6 +1,7 @@
 var events = require('events');
 var util = require('util');
 var websocket = require('../build/Release/artik-sdk.node').websocket;
+var WebsocketStream = require('./stream').WebsocketStream;
 
 var Websocket = function(uri, ssl_config) {
 	events.EventEmitter.call(this);
@@ -29,3 +30,7 @@ Websocket.prototype.write_stream = function write_stream(message) {
 Websocket.prototype.close_stream = function close_stream() {
 	return this.websocket.close_stream();
 };
+
+Websocket.prototype.create_stream = function create_stream(options) {
+	return new WebsocketStream(this, options);
+};
@@ -9,6 +9,8 @@ var assert     = require('chai').assert;
 var validator  = require('validator');
 var exec 	   = require('child_process').execSync;
 var artik      = require('../src');
+var fs         = require('fs');
+var os         = require('os');
 
 
 /* Test Specific Includes */
@@ -42,6 +44,101 @@ testCase('ADC', function() {
 
 	});
 
+	testCase('#stream_start(), #stream_stop()', function() {
+
+		assertions('Deliver blocks of samples at a steady rate', function(done) {
+
+			this.timeout(5000);
+
+			var timestamps = [];
+
+			adc.stream_start({ rate: 1000, block_size: 100 }, function(err, samples, timestamp, dropped) {
+				assert.isNull(err);
+				assert.instanceOf(samples, Int32Array);
+				assert.equal(samples.length, 100);
+				assert.equal(dropped, 0);
+				timestamps.push(timestamp);
+				if (timestamps.length < 5)
+					return;
+
+				var stats = adc.stream_stats();
+				adc.stream_stop();
+				assert.equal(stats.overruns, 0);
+				for (var i = 1; i < timestamps.length; i++)
+					assert.closeTo(timestamps[i] - timestamps[i - 1], 100e6, 1e6);
+				done();
+			});
+		});
+
+		assertions('Reject invalid settings', function() {
+			assert.throws(function() { adc.stream_start({ rate: 0 }, function() {}) }, RangeError);
+		});
+
+	});
+
+	testCase('#stream_start() with a DSP pipeline', function() {
+
+		assertions('Deliver features instead of samples', function(done) {
+
+			this.timeout(5000);
+
+			var dsp = {
+				fir: [ 0.25, 0.25, 0.25, 0.25 ],
+				decimate: 2,
+				fft: { size: 32, window: 'hann' },
+				samples: true
+			};
+
+			adc.stream_start({ rate: 1000, block_size: 64, dsp: dsp }, function(err, channels, timestamp, dropped) {
+				adc.stream_stop();
+				assert.isNull(err);
+				assert.isArray(channels);
+				assert.equal(channels.length, 1);
+				assert.instanceOf(channels[0].samples, Float32Array);
+				assert.equal(channels[0].samples.length, 32);
+				assert.instanceOf(channels[0].spectrum, Float32Array);
+				assert.equal(channels[0].spectrum.length, 17);
+				assert.isAtMost(channels[0].min, channels[0].max);
+				assert.isAtLeast(channels[0].rms, 0);
+				done();
+			});
+		});
+
+		assertions('Reject invalid pipelines', function() {
+			assert.throws(function() { adc.stream_start({ rate: 1000, dsp: { fft: { size: 100 } } }, function() {}) }, RangeError);
+			assert.throws(function() { adc.stream_start({ rate: 1000, dsp: { iir: { b: [ 1 ], a: [ 0 ] } } }, function() {}) }, RangeError);
+		});
+
+	});
+
+	testCase('#enable_fast_io()', function() {
+
+		var root, fake;
+
+		pre(function() {
+			/* Fake sysfs tree for channel 3, never requested */
+			root = fs.mkdtempSync(os.tmpdir() + '/sysfs-');
+			['/bus', '/bus/iio', '/bus/iio/devices', '/bus/iio/devices/iio:device0'].forEach(function(dir) {
+				fs.mkdirSync(root + dir);
+			});
+			fs.writeFileSync(root + '/bus/iio/devices/iio:device0/in_voltage3_raw', '1234\n');
+			fake = artik.adc(3, 'fast');
+		});
+
+		assertions('Read the cached raw attribute', function() {
+			fake.enable_fast_io(root);
+			assert.equal(fake.get_value(), 1234);
+			fs.writeFileSync(root + '/bus/iio/devices/iio:device0/in_voltage3_raw', '42\n');
+			assert.equal(fake.get_value(), 42);
+			fake.disable_fast_io();
+		});
+
+		post(function() {
+			exec('rm -rf ' + root);
+		});
+
+	});
+
 	post(function() {
 		adc.release();
 	});
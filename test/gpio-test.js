@@ -10,6 +10,10 @@ var validator      = require('validator');
 var exec           = require('child_process').execSync;
 var artik          = require('../src');
 var runManualTests = parseInt(process.env.RUN_MANUAL_TESTS);
+var mockup_id      = process.env.GPIO_MOCKUP_ID;
+var mockup_event   = process.env.GPIO_MOCKUP_EVENT;
+var fs             = require('fs');
+var os             = require('os');
 
 /* Test Specific Includes */
 var button, red, green, blue, led400, led401, sw403, sw404;
@@ -204,6 +208,238 @@ testCase('GPIO', function() {
 
         });
 
+    });
+
+    testCase('#start_capture(), #stop_capture()', function() {
+
+	var mockup;
+
+	/* Space the edges out so that sysfs does not merge them */
+	function toggle(edges) {
+		var i = 0;
+		var timer = setInterval(function() {
+			fs.writeFileSync(mockup_event, (i + 1) % 2 ? '1' : '0');
+			if (++i == edges)
+				clearInterval(timer);
+		}, 20);
+	}
+
+	pre(function() {
+		if (!mockup_id || !mockup_event)
+			this.skip();
+
+		mockup = new artik.gpio(parseInt(mockup_id), 'mockup', 'in', 'both', 0);
+		mockup.request();
+	});
+
+	assertions('Deliver timestamped edges in batches', function(done) {
+
+		this.timeout(5000);
+
+		var events = [];
+
+		mockup.start_capture({ interval: 100, count: 8 });
+		mockup.on('edges', function(batch, dropped) {
+			assert.instanceOf(batch, Float64Array);
+			assert.equal(dropped, 0);
+			Array.prototype.push.apply(events, Array.prototype.slice.call(batch));
+			if (events.length < 32)
+				return;
+
+			mockup.removeAllListeners('edges');
+			mockup.stop_capture();
+			for (var i = 0; i < events.length; i += 2) {
+				assert.equal(events[i + 1], (i / 2 + 1) % 2);
+				if (i > 0)
+					assert.isAbove(events[i], events[i - 2]);
+			}
+			done();
+		});
+
+		toggle(16);
+	});
+
+	assertions('Count the edges dropped when the ring is full', function(done) {
+
+		this.timeout(5000);
+
+		mockup.start_capture({ interval: 500, count: 0, ring_size: 4 });
+		mockup.once('edges', function(batch, dropped) {
+			assert.equal(batch.length, 8);
+			assert.equal(dropped, 6);
+			assert.equal(mockup.get_capture_stats().overruns, 6);
+			mockup.stop_capture();
+			done();
+		});
+
+		toggle(10);
+	});
+
+	post(function() {
+		if (mockup)
+			mockup.release();
+	});
+
+    });
+
+    testCase('#start_counter(), #read_counter()', function() {
+
+	var mockup;
+
+	pre(function() {
+		if (!mockup_id || !mockup_event)
+			this.skip();
+
+		mockup = new artik.gpio(parseInt(mockup_id), 'mockup', 'in', 'both', 0);
+		mockup.request();
+	});
+
+	assertions('Count the rising edges and time them', function(done) {
+
+		this.timeout(5000);
+
+		mockup.start_counter({ edge: 'rising',
+			histogram: { min: 0, max: 100000, bins: 10 } });
+
+		var i = 0;
+		var timer = setInterval(function() {
+			fs.writeFileSync(mockup_event, (i + 1) % 2 ? '1' : '0');
+			if (++i < 20)
+				return;
+
+			clearInterval(timer);
+			var snapshot = mockup.read_counter(true);
+			assert.equal(snapshot.count, 10);
+			assert.equal(snapshot.pulses, 10);
+			assert.isAbove(snapshot.period_min, 30000);
+			assert.isBelow(snapshot.frequency, 30);
+			assert.equal(snapshot.histogram.reduce(function(a, b) { return a + b; }), 9);
+			assert.equal(mockup.read_counter().pulses, 0);
+			assert.equal(mockup.stop_counter().count, 10);
+			done();
+		}, 20);
+	});
+
+	assertions('Time full periods when counting both edges', function(done) {
+
+		this.timeout(5000);
+
+		mockup.start_counter({ edge: 'both' });
+
+		var i = 0;
+		var timer = setInterval(function() {
+			fs.writeFileSync(mockup_event, (i + 1) % 2 ? '1' : '0');
+			if (++i < 20)
+				return;
+
+			clearInterval(timer);
+			var snapshot = mockup.stop_counter();
+			assert.equal(snapshot.count, 20);
+			assert.isAbove(snapshot.period_min, 30000);
+			assert.isBelow(snapshot.frequency, 30);
+			done();
+		}, 20);
+	});
+
+	assertions('Reject bouncing edges', function(done) {
+
+		this.timeout(5000);
+
+		mockup.start_counter({ debounce: 1000000 });
+
+		var i = 0;
+		var timer = setInterval(function() {
+			fs.writeFileSync(mockup_event, (i + 1) % 2 ? '1' : '0');
+			if (++i < 3)
+				return;
+
+			clearInterval(timer);
+			setTimeout(function() {
+				var snapshot = mockup.stop_counter();
+				assert.equal(snapshot.count, 1);
+				assert.equal(snapshot.rejected, 2);
+				fs.writeFileSync(mockup_event, '0');
+				done();
+			}, 50);
+		}, 20);
+	});
+
+	post(function() {
+		if (mockup)
+			mockup.release();
+	});
+
+    });
+
+    testCase('gpio_group', function() {
+
+	var group;
+
+	pre(function() {
+		if (!mockup_id)
+			this.skip();
+
+		var id = parseInt(mockup_id);
+		group = new artik.gpio_group([id, id + 1, id + 2], 'group', 'out');
+		assert.equal(group.request(), 0);
+	});
+
+	assertions('Write and read back a bitmask', function() {
+		assert.equal(group.get_count(), 3);
+		assert.equal(group.write(0x5), 0);
+		assert.equal(group.read(), 0x5);
+		assert.equal(group.write(0x2, 0x3), 0);
+		assert.equal(group.read(), 0x6);
+	});
+
+	assertions('Write and read back arrays', function() {
+		var values = new Uint8Array(3);
+
+		assert.equal(group.write(new Uint8Array([1, 1, 0])), 0);
+		assert.deepEqual(Array.prototype.slice.call(group.read(values)), [ 1, 1, 0 ]);
+		assert.equal(group.write([ 0, 0, 1 ]), 0);
+		assert.equal(group.read(), 0x4);
+		assert.throws(function() { group.write(new Uint8Array(2)) }, RangeError);
+	});
+
+	post(function() {
+		if (group)
+			group.release();
+	});
+
+    });
+
+    testCase('#enable_fast_io()', function() {
+
+	var root, gpio;
+
+	pre(function() {
+		/* Fake sysfs tree, the GPIO is never requested */
+		root = fs.mkdtempSync(os.tmpdir() + '/sysfs-');
+		['/class', '/class/gpio', '/class/gpio/gpio42'].forEach(function(dir) {
+			fs.mkdirSync(root + dir);
+		});
+		fs.writeFileSync(root + '/class/gpio/gpio42/value', '0\n');
+		gpio = new artik.gpio(42, 'fast', 'out', 'none', 0);
+	});
+
+	assertions('Read and write through the cached value attribute', function() {
+		gpio.enable_fast_io(root);
+		assert.equal(gpio.write(1), 0);
+		assert.equal(fs.readFileSync(root + '/class/gpio/gpio42/value', 'utf8'), '1');
+		fs.writeFileSync(root + '/class/gpio/gpio42/value', '0\n');
+		assert.equal(gpio.read(), 0);
+		gpio.disable_fast_io();
+	});
+
+	assertions('Report missing attributes', function() {
+		assert.throws(function() { gpio.enable_fast_io(root + '/none') }, Error);
+	});
+
+	post(function() {
+		exec('rm -rf ' + root);
+	});
+
     });
 
 	post(function() {
@@ -11,6 +11,12 @@ var exec       = require('child_process').execSync;
 var artik_http = require("../src/http");
 var md5        = require('md5');
 var fs         = require('fs');
+var os         = require('os');
+var path       = require('path');
+var node_http  = require('http');
+var node_https = require('https');
+var Readable   = require('stream').Readable;
+var crypto     = require('crypto');
 
 /* Test Specific Includes */
 var http = new artik_http();
@@ -327,6 +333,381 @@ testCase('HTTP', function() {
 		});
 	});
 
+	testCase('Promises against a local server', function() {
+		var server;
+		var secure_server;
+		var base;
+		var secure_base;
+		var cert;
+		var dir;
+		var file = crypto.randomBytes(256 * 1024);
+
+		pre(function(done) {
+			this.timeout(10000);
+
+			var handler = function(req, res) {
+				var chunks = [];
+
+				req.on('data', function(chunk) { chunks.push(chunk); });
+				req.on('end', function() {
+					if (req.url == '/slow')
+						return setTimeout(function() { res.end('late'); }, 2000);
+					if (req.url == '/busy')
+						return setTimeout(function() { res.end('busy'); }, 200);
+					if (req.url == '/close') {
+						res.setHeader('Connection', 'close');
+						return res.end('closed');
+					}
+					if (req.url == '/file' || req.url == '/cut' || req.url == '/shifted') {
+						var range = /bytes=(\d+)-/.exec(req.headers.range || '');
+						var start = range ? Number(range[1]) : 0;
+
+						/* Answers any range with another one */
+						if (req.url == '/shifted' && range)
+							start = 0;
+
+						if (start >= file.length) {
+							res.writeHead(416, { 'Content-Range': 'bytes */' + file.length });
+							return res.end();
+						}
+						if (range)
+							res.writeHead(206, {
+								'Content-Range': 'bytes ' + start + '-' + (file.length - 1) + '/' + file.length,
+								'Content-Length': file.length - start
+							});
+						else
+							res.writeHead(200, { 'Content-Length': file.length });
+
+						if (req.url == '/cut') {
+							res.write(file.slice(start, start + 1000));
+							return setTimeout(function() { res.destroy(); }, 50);
+						}
+						return res.end(file.slice(start));
+					}
+					if (req.url == '/binary') {
+						res.setHeader('Set-Cookie', [ 'a=1', 'b=2' ]);
+						res.setHeader('X-Length', '4');
+						return res.end(Buffer.from([ 0xff, 0x00, 0x01, 0x80 ]));
+					}
+
+					res.writeHead(req.url == '/missing' ? 404 : 200);
+					res.end(req.method + ' ' + (req.headers['x-test'] || '') + ' ' +
+						Buffer.concat(chunks).toString());
+				});
+			};
+			dir = fs.mkdtempSync(path.join(os.tmpdir(), 'artik-http-'));
+
+			exec('openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj /CN=localhost ' +
+				'-addext subjectAltName=DNS:localhost ' +
+				'-keyout ' + dir + '/key.pem -out ' + dir + '/cert.pem 2>/dev/null');
+			cert = fs.readFileSync(dir + '/cert.pem');
+
+			server = node_http.createServer(handler).listen(0, '127.0.0.1', function() {
+				base = 'http://127.0.0.1:' + server.address().port;
+				secure_server = node_https.createServer({
+					key: fs.readFileSync(dir + '/key.pem'),
+					cert: cert
+				}, handler).listen(0, 'localhost', function() {
+					secure_base = 'https://localhost:' + secure_server.address().port;
+					done();
+				});
+			});
+		});
+
+		assertions('HTTP Get - Should resolve with the status and the body', function() {
+			return http.get(base + '/', [ 'X-Test', 'yes' ], null).then(function(response) {
+				assert.equal(response.status, 200);
+				assert.equal(response.body, 'GET yes ');
+				assert.equal(response.headers['content-length'], '8');
+			});
+		});
+
+		assertions('HTTP Headers - Should be shared by several requests', function() {
+			var headers = new artik_http.HttpHeaders([ 'X-Test', 'shared' ]);
+
+			assert.equal(headers.get_count(), 1);
+			return Promise.all([
+				http.get(base + '/', headers, null),
+				http.post(base + '/', headers, 'a', null)
+			]).then(function(responses) {
+				assert.equal(responses[0].body, 'GET shared ');
+				assert.equal(responses[1].body, 'POST shared a');
+			});
+		});
+
+		assertions('HTTP Headers - Should send a single header pair with a callback', function(done) {
+			http.get(base + '/', [ 'X-Test', 'single' ], null, function(response, status) {
+				assert.equal(status, 200);
+				assert.equal(response, 'GET single ');
+				done();
+			});
+		});
+
+		assertions('HTTP Headers - Should keep the headers of a callback request until it completes', function(done) {
+			/* Only the request refers to the headers once the call returns */
+			http.get(base + '/', new artik_http.HttpHeaders([ 'X-Test', 'kept' ]), null, function(response, status) {
+				assert.equal(status, 200);
+				assert.equal(response, 'GET kept ');
+				done();
+			});
+		});
+
+		assertions('HTTP Get - Should resolve with a Buffer and the headers in binary mode', function() {
+			return http.get(base + '/binary', null, null, { binary: true }).then(function(response) {
+				assert.isTrue(Buffer.isBuffer(response.body));
+				assert.deepEqual(Array.from(response.body), [ 0xff, 0x00, 0x01, 0x80 ]);
+				assert.equal(response.headers['x-length'], '4');
+				assert.deepEqual(response.headers['set-cookie'], [ 'a=1', 'b=2' ]);
+			});
+		});
+
+		assertions('HTTP Post - Should send the body and resolve on HTTP errors', function() {
+			return Promise.all([
+				http.post(base + '/', null, 'a=1', null),
+				http.put(base + '/missing', null, 'b=2', null),
+				http.del(base + '/', null, null)
+			]).then(function(responses) {
+				assert.equal(responses[0].body, 'POST  a=1');
+				assert.equal(responses[1].status, 404);
+				assert.equal(responses[1].body, 'PUT  b=2');
+				assert.equal(responses[2].body, 'DELETE  ');
+			});
+		});
+
+		assertions('HTTP Post - Should send a Buffer body as is', function() {
+			var body = Buffer.from([ 0x61, 0x00, 0x62 ]);
+
+			return http.post(base + '/', null, body, null).then(function(response) {
+				assert.equal(response.body, 'POST  a\u0000b');
+			});
+		});
+
+		assertions('HTTP Put - Should send a file body', function() {
+			fs.writeFileSync(dir + '/body.txt', 'from a file');
+
+			return http.put(base + '/', null, { file: dir + '/body.txt' }, null).then(
+				function(response) {
+					assert.equal(response.body, 'PUT  from a file');
+				});
+		});
+
+		assertions('HTTP Post - Should reject when the body file is missing', function() {
+			return http.post(base + '/', null, { file: dir + '/none' }, null).then(function() {
+				assert.fail();
+			}, function(err) {
+				assert.match(err.message, /none/);
+			});
+		});
+
+		assertions('HTTP Post - Should stream a readable body', function() {
+			var chunks = [ 'one ', 'two ', 'three' ];
+			var stream = new Readable({
+				read: function() {
+					var self = this;
+
+					setTimeout(function() { self.push(chunks.shift() || null); }, 20);
+				}
+			});
+
+			return http.post(base + '/', null, stream, null).then(function(response) {
+				assert.equal(response.body, 'POST  one two three');
+			});
+		});
+
+		assertions('HTTP Post - Should reject with the error of the body stream', function() {
+			var stream = new Readable({ read: function() {} });
+
+			setTimeout(function() { stream.emit('error', new Error('broken')); }, 50);
+
+			return http.post(base + '/', null, stream, null).then(function() {
+				assert.fail();
+			}, function(err) {
+				assert.equal(err.message, 'broken');
+			});
+		});
+
+		assertions('HTTP Post - Should call back with a Buffer body', function(done) {
+			http.post(base + '/', null, Buffer.from('raw'), null, function(response, status) {
+				assert.equal(status, 200);
+				assert.equal(response, 'POST  raw');
+				done();
+			});
+		});
+
+		assertions('HTTP Download - Should write the file and its digest', function() {
+			var progress = 0;
+
+			return http.download(base + '/file', dir + '/download.bin', {
+				sha256: true,
+				progress_interval: 0,
+				progress: function(received, total) {
+					assert.equal(total, file.length);
+					progress = received;
+				}
+			}).then(function(result) {
+				assert.equal(result.status, 200);
+				assert.equal(result.size, file.length);
+				assert.isFalse(result.resumed);
+				assert.equal(result.sha256, crypto.createHash('sha256').update(file).digest('hex'));
+				assert.equal(progress, file.length);
+				assert.isTrue(fs.readFileSync(dir + '/download.bin').equals(file));
+			});
+		});
+
+		assertions('HTTP Download - Should resume an interrupted download', function() {
+			var target = dir + '/resume.bin';
+
+			return http.download(base + '/cut', target, { resume: true }).then(function() {
+				assert.fail();
+			}, function(err) {
+				assert.equal(fs.statSync(target).size, 1000);
+				return http.download(base + '/file', target, { resume: true, sha256: true });
+			}).then(function(result) {
+				assert.equal(result.status, 206);
+				assert.isTrue(result.resumed);
+				assert.equal(result.sha256, crypto.createHash('sha256').update(file).digest('hex'));
+				assert.isTrue(fs.readFileSync(target).equals(file));
+				return http.download(base + '/file', target, { resume: true });
+			}).then(function(result) {
+				assert.equal(result.status, 416);
+				assert.equal(result.size, file.length);
+			});
+		});
+
+		assertions('HTTP Download - Should start over when served another range', function() {
+			var target = dir + '/shifted.bin';
+
+			fs.writeFileSync(target, file.slice(0, 1000));
+			return http.download(base + '/shifted', target, { resume: true, sha256: true }).then(function(result) {
+				assert.equal(result.status, 200);
+				assert.isFalse(result.resumed);
+				assert.equal(result.size, file.length);
+				assert.equal(result.sha256, crypto.createHash('sha256').update(file).digest('hex'));
+				assert.isTrue(fs.readFileSync(target).equals(file));
+			});
+		});
+
+		assertions('HTTP Download - Should reject and leave the file alone on errors', function() {
+			fs.writeFileSync(dir + '/kept.bin', 'kept');
+
+			return http.download(base + '/missing', dir + '/kept.bin').then(function() {
+				assert.fail();
+			}, function(err) {
+				assert.equal(err.status, 404);
+				assert.equal(fs.readFileSync(dir + '/kept.bin').toString(), 'kept');
+			});
+		});
+
+		assertions('HTTP Get - Should not block the event loop', function() {
+			this.timeout(5000);
+
+			var ticks = 0;
+			var timer = setInterval(function() { ticks++; }, 10);
+
+			return http.get(base + '/slow', null, null).then(function(response) {
+				clearInterval(timer);
+				assert.equal(response.body, 'late');
+				assert.isAbove(ticks, 10);
+			});
+		});
+
+		assertions('HTTP Get - Should reject with ETIMEDOUT after the timeout', function() {
+			return http.get(base + '/slow', null, null, { timeout: 200 }).then(function() {
+				assert.fail();
+			}, function(err) {
+				assert.equal(err.code, 'ETIMEDOUT');
+			});
+		});
+
+		assertions('HTTP Get - Should reject with ECANCELED when cancelled', function() {
+			var request = http.get(base + '/slow', null, null);
+
+			setTimeout(request.cancel, 100);
+			return request.then(function() {
+				assert.fail();
+			}, function(err) {
+				assert.equal(err.code, 'ECANCELED');
+			});
+		});
+
+		assertions('HTTP Get SSL - Should verify the server against the CA certificate', function() {
+			var config = { ca_cert: cert, verify_cert: 'required' };
+
+			return http.get(secure_base + '/', null, config).then(function(response) {
+				assert.equal(response.status, 200);
+
+				/* Without the CA certificate, the server cannot be trusted */
+				return http.get(secure_base + '/', null, { verify_cert: 'required' }).then(function() {
+					assert.fail();
+				}, function(err) {
+					assert.instanceOf(err, Error);
+				});
+			});
+		});
+
+		assertions('HTTP Get SSL - Should reuse pooled connections', function() {
+			this.timeout(5000);
+
+			var pooled = new artik_http({ max_connections_per_host: 2 });
+			var config = { ca_cert: cert, verify_cert: 'required' };
+			var accepted = 0;
+			var counter = function() { accepted++; };
+
+			secure_server.on('secureConnection', counter);
+
+			return pooled.get(secure_base + '/', null, config).then(function() {
+				return pooled.get(secure_base + '/', null, config);
+			}).then(function() {
+				var all = [];
+
+				for (var i = 0; i < 6; i++)
+					all.push(pooled.get(secure_base + '/busy', null, config));
+				return Promise.all(all);
+			}).then(function() {
+				var stats = pooled.get_pool_stats();
+
+				secure_server.removeListener('secureConnection', counter);
+				assert.equal(stats.requests, 8);
+				assert.equal(stats.connections, accepted);
+				assert.isAtMost(accepted, 2);
+				assert.equal(stats.handshakes, accepted);
+				assert.equal(stats.reused, 8 - accepted);
+				assert.closeTo(stats.reuse_ratio, (8 - accepted) / 8, 1e-9);
+			});
+		});
+
+		assertions('HTTP Get SSL - Should count a handshake per new TLS connection', function() {
+			this.timeout(5000);
+
+			var pooled = new artik_http();
+			var config = { ca_cert: cert, verify_cert: 'required' };
+			var accepted = 0;
+			var counter = function() {
+				accepted++;
+			};
+
+			secure_server.on('secureConnection', counter);
+
+			/* Each request needs a new connection */
+			return pooled.get(secure_base + '/close', null, config).then(function() {
+				return pooled.get(secure_base + '/close', null, config);
+			}).then(function() {
+				return pooled.get(secure_base + '/close', null, config);
+			}).then(function() {
+				var stats = pooled.get_pool_stats();
+
+				secure_server.removeListener('secureConnection', counter);
+				assert.equal(stats.handshakes, 3);
+				assert.equal(accepted, 3);
+			});
+		});
+
+		post(function() {
+			server.close();
+			secure_server.close();
+		});
+	});
+
 	testCase('#get() - network down', function(done) {
 	        pre(function() {
 			if (allow_disable_wifi == 1) {
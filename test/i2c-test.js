@@ -10,6 +10,8 @@ var validator      = require('validator');
 var exec           = require('child_process').execSync;
 var artik          = require('../src');
 var runManualTests = process.env.RUN_MANUAL_TESTS;
+var i2cStubBus     = process.env.I2C_STUB_BUS;
+var i2cStubAddress = parseInt(process.env.I2C_STUB_ADDRESS || '0x50');
 
 
 /* Test Specific Includes */
@@ -21,7 +23,10 @@ testCase('I2C', function() {
 	pre(function() {
 		const name = artik.get_platform_name();
 
-		if(name == 'ARTIK 520') {
+		if(i2cStubBus) {
+			console.log('Running I2C test on simulated bus ' + i2cStubBus);
+			cw2015 = artik.i2c(parseInt(i2cStubBus), 2000, '8', i2cStubAddress);
+		} else if(name == 'ARTIK 520') {
 			console.log('Running I2C test on ARTIK 520');
 		} else if(name == 'ARTIK 1020') {
 			console.log('Running I2C test on ARTIK 1020');
@@ -66,6 +71,122 @@ testCase('I2C', function() {
 
 	});
 
+	testCase('#read_register_async', function() {
+
+		assertions('Read Register Values into a caller supplied buffer', function(done) {
+			var reg = new Buffer(1);
+			cw2015.read_register_async(8, reg, function(err, data) {
+				assert.isNull(err);
+				assert.strictEqual(data, reg);
+				console.log('Config: 0x' + data.toString('hex'));
+				done();
+			});
+		});
+
+		assertions('Read Register Values with a Promise', function() {
+			return cw2015.read_register_async(0, 1).then(function(data) {
+				assert.equal(data.length, 1);
+			});
+		});
+
+		assertions('Throw on wrong arguments', function() {
+			assert.throws(function() {
+				cw2015.read_register_async('8', 1, function() {});
+			}, TypeError);
+		});
+
+	});
+
+	testCase('#write_register_async', function() {
+
+		assertions('Write then read back Register Values', function() {
+			if (!i2cStubBus)
+				this.skip();
+
+			var reg = new Buffer([0x5a]);
+			return cw2015.write_register_async(8, reg).then(function() {
+				return cw2015.read_register_async(8, new Buffer(1));
+			}).then(function(data) {
+				assert.equal(data[0], 0x5a);
+				assert.equal(data.length, 1);
+			});
+		});
+
+		assertions('Serialize concurrent transactions', function() {
+			if (!i2cStubBus)
+				this.skip();
+
+			/*
+			 * Each batch writes its own value and reads it back, which only
+			 * holds if no other transaction ran in between, whatever the
+			 * order the batches were run in.
+			 */
+			var pending = [];
+			for (var i = 0; i < 16; i++) {
+				pending.push(cw2015.transfer([
+					{ reg: 8, data: new Buffer([i]) },
+					{ reg: 8, len: 1 }
+				], new Buffer(1)));
+			}
+			return Promise.all(pending).then(function(results) {
+				assert.equal(results.length, 16);
+				results.forEach(function(data, i) {
+					assert.equal(data[0], i);
+				});
+			});
+		});
+
+		assertions('Run concurrent reads', function() {
+			var pending = [];
+			for (var i = 0; i < 16; i++)
+				pending.push(cw2015.read_register_async(8, 1));
+			return Promise.all(pending).then(function(results) {
+				assert.equal(results.length, 16);
+				results.forEach(function(data) {
+					assert.equal(data.length, 1);
+				});
+			});
+		});
+
+	});
+
+	testCase('#transfer', function() {
+
+		assertions('Read several registers into one buffer', function() {
+			var out = new Buffer(4);
+			return cw2015.transfer([
+				{ reg: 0, len: 1 },
+				{ reg: 8, len: 1 },
+				{ reg: 8, len: 1, offset: 3 }
+			], out).then(function(data) {
+				assert.strictEqual(data, out);
+				assert.equal(data[1], data[3]);
+			});
+		});
+
+		assertions('Write and read back registers in one batch', function(done) {
+			if (!i2cStubBus)
+				this.skip();
+
+			var out = new Buffer(1);
+			cw2015.transfer([
+				{ reg: 8, data: new Buffer([0x5a]) },
+				{ reg: 8, len: 1 }
+			], out, function(err, data) {
+				assert.isNull(err);
+				assert.equal(data[0], 0x5a);
+				done();
+			});
+		});
+
+		assertions('Reject reads not fitting the output buffer', function() {
+			assert.throws(function() {
+				cw2015.transfer([ { reg: 0, len: 2 } ], new Buffer(1), function() {});
+			}, RangeError);
+		});
+
+	});
+
 	post(function() {
 		cw2015.release();
 	});
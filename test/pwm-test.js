@@ -9,6 +9,8 @@ var assert     = require('chai').assert;
 var validator  = require('validator');
 var exec       = require('child_process').execSync;
 var artik      = require('../src');
+var fs         = require('fs');
+var os         = require('os');
 
 
 /* Test Specific Includes */
@@ -58,6 +60,78 @@ testCase('PWM', function() {
 
 	});
 
+	testCase('#play(), #stop()', function() {
+
+		assertions('Play a table the requested number of times', function(done) {
+			var start = Date.now();
+
+			pwm.play({ interval: 10, duty: [ 100000, 200000, 300000, 200000 ], repeat: 3 }, function(err, cycles) {
+				assert.isNull(err);
+				assert.equal(cycles, 3);
+				assert.isAtLeast(Date.now() - start, 100);
+				assert.equal(pwm.get_duty_cycle(), 200000);
+				done();
+			});
+		});
+
+		assertions('Loop over a curve until stopped', function(done) {
+			pwm.play({ interval: 5, duty: { shape: 'ease-in-out', from: 100000, to: 300000, steps: 10 }, mode: 'loop' }, function() {
+				assert.fail('Looping sequences do not complete');
+			});
+			assert.throws(function() { pwm.play({ interval: 5, duty: [ 0 ] }) }, Error);
+			assert.throws(function() { pwm.set_duty_cycle(0) }, Error);
+			assert.throws(function() { pwm.set_period(400000) }, Error);
+			setTimeout(function() {
+				var stats = pwm.get_sequence_stats();
+
+				pwm.stop();
+				assert.isAtLeast(stats.cycles, 1);
+				assert.deepEqual(pwm.get_sequence_stats(), {});
+				done();
+			}, 200);
+		});
+
+		assertions('Reject invalid sequences', function() {
+			assert.throws(function() { pwm.play({ interval: 0, duty: [ 0 ] }) }, RangeError);
+			assert.throws(function() { pwm.play({ interval: 10, duty: [] }) }, RangeError);
+			assert.throws(function() { pwm.play({ interval: 10, duty: { shape: 'square', from: 0, to: 1, steps: 4 } }) }, RangeError);
+			assert.throws(function() { pwm.play({ interval: 10, duty: [ 500000 ], period: [ 400000 ] }) }, RangeError);
+			assert.throws(function() { pwm.play({ interval: 10, duty: [ 0 ], sync: [ { pwm: new Date(), duty: [ 0 ] } ] }) }, TypeError);
+			assert.throws(function() { pwm.play({ interval: 10, duty: [ 0 ], sync: [ { pwm: pwm, duty: [ 0 ] } ] }) }, Error);
+		});
+
+	});
+
+	testCase('#enable_fast_io()', function() {
+
+		var root, fake;
+
+		pre(function() {
+			/* Fake sysfs tree for channel 1 of chip 1, never requested */
+			root = fs.mkdtempSync(os.tmpdir() + '/sysfs-');
+			['/class', '/class/pwm', '/class/pwm/pwmchip1', '/class/pwm/pwmchip1/pwm1'].forEach(function(dir) {
+				fs.mkdirSync(root + dir);
+			});
+			fs.writeFileSync(root + '/class/pwm/pwmchip1/pwm1/period', '400000\n');
+			fs.writeFileSync(root + '/class/pwm/pwmchip1/pwm1/duty_cycle', '0\n');
+			fake = artik.pwm(257, 'fast', 400000, 0, 0);
+		});
+
+		assertions('Write the duty cycle through the cached attribute', function() {
+			fake.enable_fast_io(root);
+			assert.equal(fake.set_duty_cycle(123456), 0);
+			assert.equal(fs.readFileSync(root + '/class/pwm/pwmchip1/pwm1/duty_cycle', 'utf8'), '123456');
+			assert.equal(fake.get_duty_cycle(), 123456);
+			assert.equal(fake.get_period(), 400000);
+			fake.disable_fast_io();
+		});
+
+		post(function() {
+			exec('rm -rf ' + root);
+		});
+
+	});
+
 	post(function() {
 		pwm.release();
 	});
@@ -0,0 +1,98 @@
+/* Global Includes */
+var testCase       = require('mocha').describe;
+var pre            = require('mocha').before;
+var preEach        = require('mocha').beforeEach;
+var post           = require('mocha').after;
+var postEach       = require('mocha').afterEach;
+var assertions     = require('mocha').it;
+var assert         = require('chai').assert;
+var fs             = require('fs');
+var os             = require('os');
+var path           = require('path');
+var artik          = require('../src');
+
+/* Test Specific Includes */
+var file = path.join(os.tmpdir(), 'artik-recorder-test-' + process.pid + '.rec');
+var rec;
+
+/* Test Case Module */
+testCase('Recorder', function() {
+
+    pre(function() {
+        if (fs.existsSync(file))
+            fs.unlinkSync(file);
+        rec = new artik.recorder(file, { channels: 2, capacity: 4 });
+    });
+
+    testCase('#append()', function() {
+
+        assertions('Keep the last records when the file wraps', function() {
+            for (var i = 0; i < 6; i++)
+                rec.append([ i, -i ], 1000 + i * 10);
+
+            var info = rec.get_info();
+            assert.equal(info.channels, 2);
+            assert.equal(info.capacity, 4);
+            assert.equal(info.count, 4);
+            assert.equal(info.written, 6);
+            assert.equal(info.first, 1020);
+            assert.equal(info.last, 1050);
+        });
+
+        assertions('Keep the timestamps in order', function() {
+            rec.append(new Float64Array([ 6, -6 ]), 900);
+            assert.equal(rec.get_info().last, 1050);
+        });
+
+        assertions('Reject values not matching the channels', function() {
+            assert.throws(function() { rec.append([ 1 ]) }, RangeError);
+            assert.throws(function() { rec.append('1, 2') }, TypeError);
+        });
+
+    });
+
+    testCase('#query()', function() {
+
+        assertions('Return the records of a time range', function() {
+            var res = rec.query(1025, 1045);
+
+            assert.instanceOf(res.timestamps, Float64Array);
+            assert.deepEqual(Array.from(res.timestamps), [ 1030, 1040 ]);
+            assert.deepEqual(Array.from(res.values), [ 3, -3, 4, -4 ]);
+        });
+
+        assertions('Limit the count of records', function() {
+            var res = rec.query(0, 2000, 1);
+
+            assert.deepEqual(Array.from(res.timestamps), [ 1030 ]);
+            assert.equal(rec.query(3000, 4000).timestamps.length, 0);
+        });
+
+    });
+
+    testCase('Reopen', function() {
+
+        assertions('Find the records back after reopening the file', function() {
+            rec.sync();
+            rec.close();
+            assert.throws(function() { rec.append([ 0, 0 ]) }, Error);
+
+            rec = new artik.recorder(file);
+            assert.equal(rec.get_info().written, 7);
+            assert.deepEqual(Array.from(rec.query(1050, 1050).values), [ 5, -5, 6, -6 ]);
+        });
+
+        assertions('Reject another layout or a foreign file', function() {
+            assert.throws(function() { new artik.recorder(file, { channels: 3 }) }, Error);
+            assert.throws(function() { new artik.recorder(__filename) }, Error);
+            assert.throws(function() { new artik.recorder(file, { capacity: 0 }) }, RangeError);
+        });
+
+    });
+
+    post(function() {
+        rec.close();
+        fs.unlinkSync(file);
+    });
+
+});
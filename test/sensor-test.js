@@ -108,6 +108,20 @@ testCase('Sensors', function() {
             assert.notEqual(acce_sensor.get_speed_z(), -1);
         });
 
+        assertions('#read_all() - get acceleration on all axes', function() {
+
+            if (!acce_sensor)
+                this.skip();
+
+            var sample = new Float32Array(4);
+
+            assert.strictEqual(acce_sensor.read_all(sample, 1), sample);
+            assert.equal(acce_sensor.read_all().length, 3);
+            assert.throws(function() { acce_sensor.read_all(sample, 2) }, RangeError);
+            assert.throws(function() { acce_sensor.read_all(sample, 0xffffffff) }, RangeError);
+            assert.throws(function() { acce_sensor.read_all([ 0, 0, 0 ]) }, TypeError);
+        });
+
     });
 
     testCase('#get_gyro_sensor()', function() {
@@ -133,6 +147,14 @@ testCase('Sensors', function() {
             assert.notEqual(gyro_sensor.get_roll(), -1);
         });
 
+        assertions('#read_all() - get yaw, pitch and roll', function() {
+            if (!gyro_sensor)
+                this.skip();
+            var sample = gyro_sensor.read_all();
+            assert.instanceOf(sample, Float32Array);
+            assert.equal(sample.length, 3);
+        });
+
     });
 
 
@@ -231,6 +253,73 @@ testCase('Sensors', function() {
     });
 
 
+    testCase('sensor_hub', function() {
+
+        assertions('Sample every sensor into one packed array', function(done) {
+
+            var entries = [];
+
+            if (acce_sensor)
+                entries.push({ sensor: acce_sensor, rate: 50 });
+            if (gyro_sensor)
+                entries.push({ sensor: gyro_sensor, rate: 50 });
+            if (envtemp_sensor)
+                entries.push({ sensor: envtemp_sensor, rate: 10 });
+            if (entries.length == 0)
+                this.skip();
+
+            var hub = new artik.sensor_hub(entries, { notify: 'always' });
+            var layout = hub.get_layout();
+            var last = layout[layout.length - 1];
+            var size = last.offset + last.fields.length;
+
+            assert.equal(layout[0].offset, 0);
+            assert.equal(layout[0].fields[0], 'timestamp');
+
+            hub.start(function(values, updates) {
+                hub.stop();
+                assert.instanceOf(values, Float64Array);
+                assert.equal(values.length, size);
+                assert.isAbove(updates, 0);
+
+                var copy = new Float64Array(size);
+                assert.equal(hub.read(copy), hub.get_stats().updates);
+                assert.isAbove(copy[0], 0);
+                done();
+            });
+        });
+
+        assertions('Record every update', function(done) {
+
+            if (!envtemp_sensor)
+                this.skip();
+
+            var file = require('os').tmpdir() + '/artik-hub-test-' + process.pid + '.rec';
+            var rec = new artik.recorder(file, { channels: 2, capacity: 16 });
+            var hub = new artik.sensor_hub([ { sensor: envtemp_sensor, rate: 10 } ],
+                                           { notify: 'always', recorder: rec });
+
+            hub.start(function() {
+                hub.stop();
+                var info = rec.get_info();
+                var values = rec.query(info.last, info.last).values;
+                assert.isAbove(info.count, 0);
+                assert.equal(values[values.length - 1], hub.read()[1]);
+                rec.close();
+                require('fs').unlinkSync(file);
+                done();
+            });
+        });
+
+        assertions('Reject invalid entries', function() {
+            assert.throws(function() { new artik.sensor_hub([]) }, RangeError);
+            assert.throws(function() { new artik.sensor_hub([ { sensor: {}, rate: 1 } ]) }, TypeError);
+            /* A native object of another module is not a sensor either */
+            assert.throws(function() { new artik.sensor_hub([ { sensor: artik.adc(0, 'hub'), rate: 1 } ]) }, TypeError);
+        });
+
+    });
+
     post(function() {
 
     });
@@ -86,6 +86,231 @@ testCase('Serial', function() {
 
 	});
 
+	testCase('#write_async()', function() {
+
+		assertions('Queue writes and get them back in order', function(done) {
+
+			this.timeout(10000);
+
+			var tx_buf = new Buffer(8192);
+			var rx_bufs = [];
+			var received = 0;
+			var written = 0;
+
+			for (var i = 0; i < tx_buf.length; i++)
+				tx_buf[i] = i & 0xff;
+
+			/*
+			 * The last bytes may be read back before the completion of
+			 * their write is reported, so wait for both.
+			 */
+			function check() {
+				if (received < tx_buf.length || written < 4)
+					return;
+
+				assert.equal(Buffer.concat(rx_bufs).equals(tx_buf), true);
+				assert.equal(written, 4);
+				loopback.removeAllListeners('read');
+				done();
+			}
+
+			loopback.set_high_water_mark(4096);
+			loopback.on('read', function(data) {
+				rx_bufs.push(new Buffer(data));
+				received += data.length;
+				check();
+			});
+
+			var ok = true;
+			for (var off = 0; off < tx_buf.length; off += 2048) {
+				ok = loopback.write_async(tx_buf.slice(off, off + 2048), function(err) {
+					assert.isNull(err);
+					written++;
+					check();
+				});
+			}
+
+			assert.equal(ok, false);
+			assert.equal(loopback.get_write_queue_size(), tx_buf.length);
+		});
+
+		assertions('Emit drain once the queue is written', function(done) {
+
+			this.timeout(5000);
+
+			loopback.once('drain', function() {
+				assert.equal(loopback.get_write_queue_size(), 0);
+				/* Let the looped back data in before the next test */
+				setTimeout(done, 200);
+			});
+
+			loopback.set_high_water_mark(16);
+			assert.equal(loopback.write_async(new Buffer(32).fill(0x55)), false);
+		});
+
+	});
+
+	testCase('#set_rx_buffer(), #recycle()', function() {
+
+		assertions('Refuse to change the receive buffers while receiving', function() {
+			assert.throws(function() { loopback.set_rx_buffer(64, 4) }, Error);
+		});
+
+		assertions('Receive the data in pooled buffers', function(done) {
+
+			this.timeout(5000);
+
+			var tx_buf = new Buffer(256);
+			var rx_bufs = [];
+			var received = 0;
+
+			for (var i = 0; i < tx_buf.length; i++)
+				tx_buf[i] = i;
+
+			loopback.removeAllListeners('read');
+			loopback.release();
+			loopback.set_rx_buffer(64, 4);
+			loopback.request();
+
+			loopback.on('read', function(data) {
+				assert.isAtMost(data.length, 64);
+				rx_bufs.push(new Buffer(data));
+				received += data.length;
+				loopback.recycle(data);
+
+				if (received >= tx_buf.length) {
+					var stats = loopback.get_rx_stats();
+					assert.equal(Buffer.concat(rx_bufs).equals(tx_buf), true);
+					assert.equal(stats.pool_size, 4);
+					assert.equal(stats.pool_free, 4);
+					loopback.removeAllListeners('read');
+					done();
+				}
+			});
+
+			loopback.write(tx_buf);
+		});
+
+	});
+
+	testCase('#set_framing()', function() {
+
+		assertions('Reassemble delimited frames', function(done) {
+
+			this.timeout(5000);
+
+			var lines = [];
+
+			loopback.set_framing('delimiter', { delimiter: '\r\n' });
+			loopback.on('frame', function(frame) {
+				lines.push(frame.toString());
+				if (lines.length == 3) {
+					assert.deepEqual(lines, [ 'first', 'second', 'third' ]);
+					loopback.removeAllListeners('frame');
+					done();
+				}
+			});
+
+			loopback.write(new Buffer('first\r\nsec'));
+			loopback.write(new Buffer('ond\r\nthird\r\nfou'));
+		});
+
+		assertions('Reassemble length prefixed frames', function(done) {
+
+			this.timeout(5000);
+
+			loopback.set_framing('length', { field_size: 2, big_endian: true });
+			loopback.on('frames', function(frames) {
+				assert.equal(frames.length, 2);
+				assert.equal(frames[0].toString(), 'abc');
+				assert.equal(frames[1].toString(), 'de');
+				loopback.removeAllListeners('frames');
+				done();
+			});
+
+			loopback.write(new Buffer([0x00, 0x03, 0x61, 0x62, 0x63, 0x00, 0x02, 0x64, 0x65]));
+		});
+
+		assertions('Decode SLIP frames', function(done) {
+
+			this.timeout(5000);
+
+			loopback.set_framing('slip');
+			loopback.on('frame', function(frame) {
+				assert.equal(frame.equals(new Buffer([0x01, 0xc0, 0xdb, 0x02])), true);
+				loopback.removeAllListeners('frame');
+				loopback.set_framing('none');
+				done();
+			});
+
+			loopback.write(new Buffer([0xc0, 0x01, 0xdb, 0xdc, 0xdb, 0xdd, 0x02, 0xc0]));
+		});
+
+		assertions('Reject unknown framing modes', function() {
+			assert.throws(function() { loopback.set_framing('hdlc') }, TypeError);
+			assert.throws(function() { loopback.set_framing('fixed', { length: 0 }) }, TypeError);
+		});
+
+	});
+
+	testCase('#pause_receive(), #resume_receive(), #create_stream()', function() {
+
+		assertions('Hold the data back while paused', function(done) {
+
+			this.timeout(5000);
+
+			var received = 0;
+
+			loopback.on('read', function(data) {
+				received += data.length;
+				loopback.recycle(data);
+			});
+
+			loopback.pause_receive();
+			loopback.write(new Buffer(32).fill(0xaa));
+
+			setTimeout(function() {
+				assert.equal(received, 0);
+				loopback.resume_receive();
+				setTimeout(function() {
+					assert.equal(received, 32);
+					loopback.removeAllListeners('read');
+					done();
+				}, 500);
+			}, 500);
+		});
+
+		assertions('Pipe the data through a stream with bounded buffering', function(done) {
+
+			this.timeout(10000);
+
+			var tx_buf = new Buffer(4096);
+			var rx_bufs = [];
+			var received = 0;
+			var stream = loopback.create_stream({ highWaterMark: 256 });
+
+			for (var i = 0; i < tx_buf.length; i++)
+				tx_buf[i] = (i * 7) & 0xff;
+
+			stream.write(tx_buf);
+
+			/* Start consuming late, the port must have been paused meanwhile */
+			setTimeout(function() {
+				assert.isBelow(stream._readableState.length, tx_buf.length);
+				stream.on('data', function(data) {
+					rx_bufs.push(data);
+					received += data.length;
+					if (received >= tx_buf.length) {
+						assert.equal(Buffer.concat(rx_bufs).equals(tx_buf), true);
+						stream.destroy();
+						done();
+					}
+				});
+			}, 1000);
+		});
+
+	});
+
     testCase('#get_*(), #set_*()', function() {
         assertions('Get the value that are passed to the constructor', function(done) {
         	assert.equal(loopback.get_baudrate(), 115200);
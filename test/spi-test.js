@@ -89,6 +89,54 @@ testCase('SPI', function() {
 
 	});
 
+	testCase('#stream_start()', function() {
+
+		assertions('Stream the data to spi loopback port and read it back', function(done) {
+
+			console.log('Starting Loopback Stream Test...Make sure you have connected MOSI and MISO with a wire');
+			var tx_buf = new Buffer(256);
+			var received = 0;
+
+			for (var i = 0; i < tx_buf.length; i++)
+				tx_buf[i] = i;
+
+			spi.stream_start(tx_buf, 8, 4, function(err, buffers) {
+				assert.isNull(err);
+				assert.isAtMost(buffers.length, 4);
+				buffers.forEach(function(rx_buf) {
+					assert.equal(tx_buf.equals(rx_buf), true);
+				});
+				received += buffers.length;
+				if (received >= 64) {
+					spi.stream_stop();
+					done();
+				}
+			});
+		});
+
+		assertions('Stop filling buffers while the stream is paused', function(done) {
+			var tx_buf = new Buffer(64).fill(0x5a);
+
+			spi.stream_start(tx_buf, 4, 4, function(err, buffers) {
+				return false;
+			});
+
+			setTimeout(function() {
+				var stats = spi.stream_stats();
+				assert.isAtMost(stats.pending, 4);
+				assert.isAbove(stats.stalls, 0);
+				var transfers = stats.transfers;
+				setTimeout(function() {
+					assert.equal(spi.stream_stats().transfers, transfers);
+					spi.stream_stop();
+					assert.deepEqual(spi.stream_stats(), {});
+					done();
+				}, 100);
+			}, 200);
+		});
+
+	});
+
 	post(function() {
 		spi.release();
 	});
@@ -91,6 +91,24 @@ testCase('Websockets', function() {
 
 	});
 
+	testCase('#create_stream()', function () {
+
+		assertions('Get the echo back through the stream', function(done) {
+
+			conn.removeAllListeners('receive');
+
+			var stream = conn.create_stream();
+			stream.once('data', function(data) {
+				assert.equal(data.toString(), test_message);
+				stream.destroy();
+				done();
+			});
+
+			stream.write(test_message);
+		});
+
+	});
+
 	post(function() {
 	});
 